@@ -0,0 +1,484 @@
+// Benchmark of ingestion and queries on a generated corpus with Zipfian
+// word frequencies, varying document lengths, minus words and statuses.
+//
+// Usage: search_server_benchmark [key=value ...]
+//     documents=20000 queries=2000 vocabulary=20000 zipf=1.0
+//     min_length=5 max_length=200 min_query_length=1 max_query_length=6
+//     minus_probability=0.1 statuses=0.7,0.1,0.1,0.1 stop_words=10
+//     threads=1,2,4,8 seed=42 format=json|csv perf=1
+//
+// Prints one flat object of metrics as JSON or as metric,value CSV lines.
+// With perf=1 the hardware counters of every region are added per
+// operation where the kernel allows perf_event_open, perf.available tells
+// whether it did.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <execution>
+#include <iostream>
+#include <new>
+#include <optional>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "metrics.h"
+#include "perf_counters.h"
+#include "search_server.h"
+#include "tool_common.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+// Bytes currently allocated through operator new, for memory per document
+std::atomic<std::int64_t> live_heap_bytes{0};
+// Keeps the returned blocks aligned like malloc's
+constexpr std::size_t ALLOCATION_HEADER = alignof(std::max_align_t);
+
+} // namespace
+
+void *operator new(std::size_t size){
+    void *block = std::malloc(size + ALLOCATION_HEADER);
+    if (block == nullptr){
+        throw std::bad_alloc();
+    }
+    *static_cast<std::size_t*>(block) = size;
+    live_heap_bytes.fetch_add(static_cast<std::int64_t>(size), std::memory_order_relaxed);
+    return static_cast<char*>(block) + ALLOCATION_HEADER;
+}
+
+void *operator new(std::size_t size, const std::nothrow_t&) noexcept{
+    try{
+        return operator new(size);
+    }catch (const std::bad_alloc&){
+        return nullptr;
+    }
+}
+
+void operator delete(void *data) noexcept{
+    if (data == nullptr){
+        return;
+    }
+    char *block = static_cast<char*>(data) - ALLOCATION_HEADER;
+    live_heap_bytes.fetch_sub(static_cast<std::int64_t>(*reinterpret_cast<std::size_t*>(block)),
+                              std::memory_order_relaxed);
+    std::free(block);
+}
+
+void operator delete(void *data, std::size_t) noexcept{
+    operator delete(data);
+}
+
+void operator delete(void *data, const std::nothrow_t&) noexcept{
+    operator delete(data);
+}
+
+namespace {
+
+struct BenchmarkOptions{
+    int document_count = 20000;
+    int query_count = 2000;
+    int vocabulary_size = 20000;
+    double zipf_exponent = 1.0;
+    int min_document_length = 5;
+    int max_document_length = 200;
+    int min_query_length = 1;
+    int max_query_length = 6;
+    double minus_probability = 0.1;
+    // Weights of ACTUAL, IRRELEVANT, BANNED and REMOVED
+    std::vector<double> status_weights{0.7, 0.1, 0.1, 0.1};
+    // The most frequent words of the vocabulary
+    int stop_word_count = 10;
+    std::vector<int> thread_counts{1, 2, 4, 8};
+    unsigned seed = 42;
+    OutputFormat format = OutputFormat::JSON;
+    bool use_perf_counters = true;
+};
+
+struct GeneratedDocument{
+    std::string text;
+    DocumentStatus status;
+    std::vector<int> ratings;
+};
+
+using Clock = std::chrono::steady_clock;
+
+template <typename T>
+std::vector<T> ParseList(const std::string &text){
+    std::vector<T> values;
+    std::size_t begin = 0;
+    while (begin <= text.size()){
+        const std::size_t end = std::min(text.find(',', begin), text.size());
+        values.push_back(static_cast<T>(std::stod(text.substr(begin, end - begin))));
+        begin = end + 1;
+    }
+    return values;
+}
+
+BenchmarkOptions ParseOptions(int argc, char **argv){
+    BenchmarkOptions options;
+    ParseKeyValueOptions(argc, argv, [&options](const std::string &key, const std::string &value){
+        if (key == "documents"){
+            options.document_count = std::stoi(value);
+        }else if (key == "queries"){
+            options.query_count = std::stoi(value);
+        }else if (key == "vocabulary"){
+            options.vocabulary_size = std::stoi(value);
+        }else if (key == "zipf"){
+            options.zipf_exponent = std::stod(value);
+        }else if (key == "min_length"){
+            options.min_document_length = std::stoi(value);
+        }else if (key == "max_length"){
+            options.max_document_length = std::stoi(value);
+        }else if (key == "min_query_length"){
+            options.min_query_length = std::stoi(value);
+        }else if (key == "max_query_length"){
+            options.max_query_length = std::stoi(value);
+        }else if (key == "minus_probability"){
+            options.minus_probability = std::stod(value);
+        }else if (key == "statuses"){
+            options.status_weights = ParseList<double>(value);
+        }else if (key == "stop_words"){
+            options.stop_word_count = std::stoi(value);
+        }else if (key == "threads"){
+            options.thread_counts = ParseList<int>(value);
+        }else if (key == "seed"){
+            options.seed = static_cast<unsigned>(std::stoul(value));
+        }else if (key == "format"){
+            options.format = ParseOutputFormat(value);
+        }else if (key == "perf"){
+            options.use_perf_counters = std::stoi(value) != 0;
+        }else{
+            return false;
+        }
+        return true;
+    });
+    if (options.status_weights.size() != 4){
+        throw std::invalid_argument("statuses needs four weights"s);
+    }
+    if (options.vocabulary_size <= options.stop_word_count || options.min_document_length <= 0
+        || options.min_document_length > options.max_document_length
+        || options.min_query_length <= 0 || options.min_query_length > options.max_query_length){
+        throw std::invalid_argument("Inconsistent options"s);
+    }
+    return options;
+}
+
+// Word i is drawn with probability proportional to 1 / (i + 1)^exponent
+class ZipfSampler{
+public:
+    ZipfSampler(int size, double exponent)
+        : cumulative_(size){
+        double sum = 0;
+        for (int i = 0; i < size; ++i){
+            sum += 1.0 / std::pow(i + 1.0, exponent);
+            cumulative_[i] = sum;
+        }
+    }
+
+    int operator()(std::mt19937 &generator) const{
+        const double point = std::uniform_real_distribution<>(0, cumulative_.back())(generator);
+        const auto it = std::upper_bound(cumulative_.begin(), cumulative_.end(), point);
+        return static_cast<int>(std::min<std::ptrdiff_t>(it - cumulative_.begin(), cumulative_.size() - 1));
+    }
+
+private:
+    std::vector<double> cumulative_;
+};
+
+std::vector<std::string> GenerateVocabulary(std::mt19937 &generator, int size){
+    std::set<std::string> seen;
+    std::vector<std::string> words;
+    words.reserve(size);
+    while (static_cast<int>(words.size()) < size){
+        std::string word(std::uniform_int_distribution(3, 10)(generator), ' ');
+        for (char &c : word){
+            c = static_cast<char>(std::uniform_int_distribution<int>('a', 'z')(generator));
+        }
+        if (seen.insert(word).second){
+            words.push_back(std::move(word));
+        }
+    }
+    return words;
+}
+
+// Log-normal lengths centered between the bounds, clamped to them
+int GenerateLength(std::mt19937 &generator, int min_length, int max_length){
+    const double median = std::sqrt(static_cast<double>(min_length) * max_length);
+    const double length = std::lognormal_distribution<>(std::log(median), 0.6)(generator);
+    return std::clamp(static_cast<int>(length), min_length, max_length);
+}
+
+std::vector<GeneratedDocument> GenerateDocuments(std::mt19937 &generator, const BenchmarkOptions &options,
+                                                 const std::vector<std::string> &vocabulary,
+                                                 const ZipfSampler &sampler){
+    std::discrete_distribution<int> status_distribution(options.status_weights.begin(),
+                                                        options.status_weights.end());
+    std::vector<GeneratedDocument> documents(options.document_count);
+    for (GeneratedDocument &document : documents){
+        const int length = GenerateLength(generator, options.min_document_length, options.max_document_length);
+        for (int i = 0; i < length; ++i){
+            if (i > 0){
+                document.text.push_back(' ');
+            }
+            document.text += vocabulary[sampler(generator)];
+        }
+        document.status = static_cast<DocumentStatus>(status_distribution(generator));
+        document.ratings.resize(std::uniform_int_distribution(0, 5)(generator));
+        for (int &rating : document.ratings){
+            rating = std::uniform_int_distribution(-10, 10)(generator);
+        }
+    }
+    return documents;
+}
+
+std::vector<std::string> GenerateQueries(std::mt19937 &generator, const BenchmarkOptions &options,
+                                         const std::vector<std::string> &vocabulary, const ZipfSampler &sampler){
+    std::vector<std::string> queries(options.query_count);
+    for (std::string &query : queries){
+        const int length = std::uniform_int_distribution(options.min_query_length, options.max_query_length)(generator);
+        for (int i = 0; i < length; ++i){
+            if (i > 0){
+                query.push_back(' ');
+            }
+            if (std::uniform_real_distribution<>(0, 1)(generator) < options.minus_probability){
+                query.push_back('-');
+            }
+            query += vocabulary[sampler(generator)];
+        }
+    }
+    return queries;
+}
+
+double SecondsSince(Clock::time_point start){
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+template <typename Policy>
+std::vector<double> MeasureLatencies(const SearchServer &search_server, const std::vector<std::string> &queries,
+                                     Policy policy, double &checksum){
+    std::vector<double> latencies;
+    latencies.reserve(queries.size());
+    for (const std::string &query : queries){
+        const auto start = Clock::now();
+        const auto documents = search_server.FindTopDocuments(policy, query);
+        latencies.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        for (const Document &document : documents){
+            checksum += document.relevance;
+        }
+    }
+    return latencies;
+}
+
+// MatchDocument of every query against a document spread over the index
+std::vector<double> MeasureMatchLatencies(const SearchServer &search_server, const std::vector<std::string> &queries,
+                                          double &checksum){
+    std::vector<double> latencies;
+    latencies.reserve(queries.size());
+    const int document_count = search_server.GetDocumentCount();
+    for (std::size_t i = 0; i < queries.size(); ++i){
+        const int document_id = static_cast<int>(i * 7919 % document_count);
+        const auto start = Clock::now();
+        const auto [words, status] = search_server.MatchDocument(queries[i], document_id);
+        latencies.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+        checksum += words.size();
+    }
+    return latencies;
+}
+
+// Removes count documents evenly spread over the ids
+std::vector<double> MeasureRemoveLatencies(SearchServer &search_server, int count){
+    std::vector<double> latencies;
+    latencies.reserve(count);
+    const int document_count = search_server.GetDocumentCount();
+    for (int i = 0; i < count; ++i){
+        const int document_id = static_cast<int>(static_cast<std::int64_t>(i) * document_count / count);
+        const auto start = Clock::now();
+        search_server.RemoveDocument(document_id);
+        latencies.push_back(std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+    }
+    return latencies;
+}
+
+// Hardware counters of a region divided by its number of operations, and
+// the instructions per cycle. Events the kernel did not count are left out.
+void AddPerfMetrics(Metrics &metrics, const std::string &prefix, const PerfReading &reading,
+                    std::size_t operation_count){
+    const double operations = static_cast<double>(std::max<std::size_t>(operation_count, 1));
+    for (std::size_t i = 0; i < PERF_EVENT_COUNT; ++i){
+        const auto event = static_cast<PerfEvent>(i);
+        if (reading.IsCounted(event)){
+            metrics.emplace_back(prefix + "." + PerfCounters::GetName(event) + "_per_op", reading.Get(event) / operations);
+        }
+    }
+    if (reading.IsCounted(PerfEvent::CYCLES) && reading.IsCounted(PerfEvent::INSTRUCTIONS)
+        && reading.Get(PerfEvent::CYCLES) > 0){
+        metrics.emplace_back(prefix + ".ipc", reading.Get(PerfEvent::INSTRUCTIONS) / reading.Get(PerfEvent::CYCLES));
+    }
+}
+
+// Runs function, counting it when counters is not null
+template <typename Function>
+void MeasurePerfRegion(Metrics &metrics, PerfCounters *counters, const std::string &prefix,
+                       std::size_t operation_count, Function function){
+    if (counters == nullptr){
+        function();
+        return;
+    }
+    counters->Start();
+    function();
+    AddPerfMetrics(metrics, prefix, counters->Stop(), operation_count);
+}
+
+// Every thread runs the whole query set
+double MeasureThroughput(const SearchServer &search_server, const std::vector<std::string> &queries,
+                         int thread_count){
+    std::atomic<std::size_t> result_count{0};
+    const auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_count; ++i){
+        threads.emplace_back([&search_server, &queries, &result_count]{
+            std::size_t count = 0;
+            for (const std::string &query : queries){
+                count += search_server.FindTopDocuments(query).size();
+            }
+            result_count += count;
+        });
+    }
+    for (std::thread &thread : threads){
+        thread.join();
+    }
+    return static_cast<double>(queries.size()) * thread_count / SecondsSince(start);
+}
+
+Metrics RunBenchmark(const BenchmarkOptions &options){
+    Metrics metrics;
+    metrics.emplace_back("config.documents", options.document_count);
+    metrics.emplace_back("config.queries", options.query_count);
+    metrics.emplace_back("config.vocabulary", options.vocabulary_size);
+    metrics.emplace_back("config.zipf", options.zipf_exponent);
+    metrics.emplace_back("config.minus_probability", options.minus_probability);
+
+    std::mt19937 generator(options.seed);
+    const auto vocabulary = GenerateVocabulary(generator, options.vocabulary_size);
+    const ZipfSampler sampler(options.vocabulary_size, options.zipf_exponent);
+    const auto documents = GenerateDocuments(generator, options, vocabulary, sampler);
+    const auto queries = GenerateQueries(generator, options, vocabulary, sampler);
+    const std::vector<std::string> stop_words(vocabulary.begin(), vocabulary.begin() + options.stop_word_count);
+    double text_bytes = 0;
+    for (const GeneratedDocument &document : documents){
+        text_bytes += document.text.size();
+    }
+    metrics.emplace_back("corpus.megabytes", text_bytes / 1e6);
+
+    // Only the regions running on this thread are fully counted, for the
+    // parallel ones the counters show the share of the calling thread
+    std::optional<PerfCounters> perf_counters;
+    if (options.use_perf_counters){
+        perf_counters.emplace();
+    }
+    PerfCounters *counters = perf_counters && perf_counters->IsAvailable() ? &*perf_counters : nullptr;
+    metrics.emplace_back("perf.available", counters != nullptr ? 1 : 0);
+
+    // Ingestion one document at a time; the heap growth is the index size
+    const std::int64_t heap_before = live_heap_bytes.load();
+    SearchServer search_server(stop_words);
+    auto start = Clock::now();
+    MeasurePerfRegion(metrics, counters, "perf.ingest", documents.size(), [&]{
+        for (std::size_t i = 0; i < documents.size(); ++i){
+            search_server.AddDocument(static_cast<int>(i), std::string_view{documents[i].text},
+                                      documents[i].status, documents[i].ratings);
+        }
+    });
+    double seconds = SecondsSince(start);
+    const double index_bytes = static_cast<double>(live_heap_bytes.load() - heap_before);
+    metrics.emplace_back("ingest.seconds", seconds);
+    metrics.emplace_back("ingest.documents_per_second", documents.size() / seconds);
+    metrics.emplace_back("ingest.megabytes_per_second", text_bytes / 1e6 / seconds);
+    metrics.emplace_back("memory.index_bytes", index_bytes);
+    metrics.emplace_back("memory.bytes_per_document", index_bytes / std::max<std::size_t>(documents.size(), 1));
+    // The server's own accounting, the gap to index_bytes is the stop words and query caches
+    const MemoryStats memory = search_server.GetMemoryStats();
+    metrics.emplace_back("memory.accounted_bytes", static_cast<double>(memory.GetTotalBytes()));
+    metrics.emplace_back("memory.term_dictionary_bytes", static_cast<double>(memory.term_dictionary_bytes));
+    metrics.emplace_back("memory.term_text_bytes", static_cast<double>(memory.term_text_bytes));
+    metrics.emplace_back("memory.posting_bytes", static_cast<double>(memory.posting_bytes));
+    metrics.emplace_back("memory.forward_index_bytes", static_cast<double>(memory.forward_index_bytes));
+    metrics.emplace_back("memory.document_metadata_bytes", static_cast<double>(memory.document_metadata_bytes));
+    metrics.emplace_back("memory.dead_postings", static_cast<double>(memory.dead_posting_count));
+
+    {
+        std::vector<DocumentInput> batch;
+        batch.reserve(documents.size());
+        for (std::size_t i = 0; i < documents.size(); ++i){
+            batch.push_back({static_cast<int>(i), documents[i].text, documents[i].status, documents[i].ratings});
+        }
+        SearchServer batch_server(stop_words);
+        start = Clock::now();
+        batch_server.AddDocuments(std::execution::par, batch);
+        seconds = SecondsSince(start);
+        metrics.emplace_back("batch_ingest.seconds", seconds);
+        metrics.emplace_back("batch_ingest.documents_per_second", documents.size() / seconds);
+    }
+
+    double checksum = 0;
+    std::vector<double> latencies;
+    MeasurePerfRegion(metrics, counters, "perf.query.seq", queries.size(), [&]{
+        latencies = MeasureLatencies(search_server, queries, std::execution::seq, checksum);
+    });
+    AddLatencyMetrics(metrics, "query.seq", std::move(latencies));
+    MeasurePerfRegion(metrics, counters, "perf.query.par", queries.size(), [&]{
+        latencies = MeasureLatencies(search_server, queries, std::execution::par, checksum);
+    });
+    AddLatencyMetrics(metrics, "query.par", std::move(latencies));
+    for (int thread_count : options.thread_counts){
+        metrics.emplace_back("throughput.threads_" + std::to_string(thread_count) + ".qps",
+                             MeasureThroughput(search_server, queries, thread_count));
+    }
+    // Shared scan of the whole query set
+    MeasurePerfRegion(metrics, counters, "perf.query.batch", queries.size(), [&]{
+        start = Clock::now();
+        const auto results = search_server.FindTopDocumentsBatch(std::execution::par, queries);
+        metrics.emplace_back("query.batch.qps", queries.size() / SecondsSince(start));
+    });
+    if (!documents.empty()){
+        MeasurePerfRegion(metrics, counters, "perf.match", queries.size(), [&]{
+            latencies = MeasureMatchLatencies(search_server, queries, checksum);
+        });
+        AddLatencyMetrics(metrics, "match", std::move(latencies));
+        // Last, as it shrinks the index
+        const int remove_count = std::min(options.query_count, options.document_count);
+        MeasurePerfRegion(metrics, counters, "perf.remove", remove_count, [&]{
+            latencies = MeasureRemoveLatencies(search_server, remove_count);
+        });
+        AddLatencyMetrics(metrics, "remove", std::move(latencies));
+    }
+    // Stage latencies of all the queries above, from the metrics registry
+    for (const auto &[name, histogram] : MetricsRegistry::Instance().GetSnapshot().histograms){
+        const std::string prefix = "stage." + name.substr(0, name.size() - std::string_view{"_ns"}.size());
+        metrics.emplace_back(prefix + ".p50_ns", histogram.GetPercentile(50));
+        metrics.emplace_back(prefix + ".p99_ns", histogram.GetPercentile(99));
+    }
+    // Keeps the queries from being optimized away and catches result changes
+    metrics.emplace_back("query.relevance_checksum", checksum);
+    return metrics;
+}
+
+} // namespace
+
+int main(int argc, char **argv){
+    try{
+        const BenchmarkOptions options = ParseOptions(argc, argv);
+        PrintMetrics(RunBenchmark(options), options.format);
+    }catch (const std::exception &error){
+        std::cerr << "search_server_benchmark: " << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,188 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+#include "hashing.h"
+
+// Native-endian binary I/O of trivially copyable values and arrays.
+// Counts read from the data are checked against what the stream still
+// holds before anything is allocated for them, so a damaged count throws
+// std::invalid_argument instead of exhausting memory.
+
+constexpr std::uint64_t UNKNOWN_SIZE = UINT64_MAX;
+// Streams that cannot seek are read in chunks of this size
+constexpr std::size_t READ_CHUNK_BYTES = 1 << 20;
+
+// Bytes from the read position to the end, UNKNOWN_SIZE if the stream cannot seek
+inline std::uint64_t GetRemainingBytes(std::istream &input){
+    const std::istream::pos_type position = input.tellg();
+    if (position == std::istream::pos_type(-1)){
+        input.clear(input.rdstate() & ~std::ios::failbit);
+        return UNKNOWN_SIZE;
+    }
+    input.seekg(0, std::ios::end);
+    const std::istream::pos_type end = input.tellg();
+    input.clear(input.rdstate() & ~std::ios::failbit);
+    input.seekg(position);
+    if (end == std::istream::pos_type(-1) || end - position < 0){
+        return UNKNOWN_SIZE;
+    }
+    return static_cast<std::uint64_t>(end - position);
+}
+
+template <typename T>
+void WriteValue(std::ostream &output, const T &value){
+    static_assert(std::is_trivially_copyable_v<T>);
+    output.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+T ReadValue(std::istream &input){
+    static_assert(std::is_trivially_copyable_v<T>);
+    T value;
+    if (!input.read(reinterpret_cast<char*>(&value), sizeof(T))){
+        throw std::invalid_argument("Unexpected end of binary data");
+    }
+    return value;
+}
+
+// Reads count elements with a single read
+template <typename T>
+void ReadArray(std::istream &input, T *data, std::size_t count){
+    static_assert(std::is_trivially_copyable_v<T>);
+    if (count != 0 && !input.read(reinterpret_cast<char*>(data), count * sizeof(T))){
+        throw std::invalid_argument("Unexpected end of binary data");
+    }
+}
+
+template <typename T>
+void WriteArray(std::ostream &output, const T *data, std::size_t count){
+    static_assert(std::is_trivially_copyable_v<T>);
+    output.write(reinterpret_cast<const char*>(data), count * sizeof(T));
+}
+
+// Element count followed by the elements
+template <typename T>
+void WriteVector(std::ostream &output, const std::vector<T> &values){
+    WriteValue<std::uint64_t>(output, values.size());
+    WriteArray(output, values.data(), values.size());
+}
+
+// Reads count elements whose count came from the data
+template <typename T>
+std::vector<T> ReadVector(std::istream &input, std::uint64_t count){
+    static_assert(std::is_trivially_copyable_v<T>);
+    const std::uint64_t remaining = GetRemainingBytes(input);
+    if (count > remaining / sizeof(T)){
+        throw std::invalid_argument("Element count exceeds the binary data");
+    }
+    std::vector<T> values;
+    if (remaining != UNKNOWN_SIZE){
+        values.resize(count);
+        ReadArray(input, values.data(), values.size());
+        return values;
+    }
+    // The vector grows with the data actually read
+    const std::size_t chunk_size = std::max<std::size_t>(1, READ_CHUNK_BYTES / sizeof(T));
+    while (values.size() < count){
+        const std::size_t offset = values.size();
+        const std::size_t size = std::min<std::uint64_t>(chunk_size, count - offset);
+        values.resize(offset + size);
+        ReadArray(input, values.data() + offset, size);
+    }
+    return values;
+}
+
+template <typename T>
+std::vector<T> ReadVector(std::istream &input){
+    return ReadVector<T>(input, ReadValue<std::uint64_t>(input));
+}
+
+// Lengths first, then all characters back to back
+template <typename StringContainer>
+void WriteStrings(std::ostream &output, const StringContainer &strings){
+    std::vector<std::uint32_t> lengths;
+    for (const auto &str : strings){
+        lengths.push_back(static_cast<std::uint32_t>(str.size()));
+    }
+    WriteVector(output, lengths);
+    for (const auto &str : strings){
+        output.write(str.data(), str.size());
+    }
+}
+
+inline std::vector<std::string> ReadStrings(std::istream &input){
+    const auto lengths = ReadVector<std::uint32_t>(input);
+    std::vector<std::string> strings;
+    strings.reserve(lengths.size());
+    for (std::uint32_t length : lengths){
+        const auto characters = ReadVector<char>(input, length);
+        strings.emplace_back(characters.begin(), characters.end());
+    }
+    return strings;
+}
+
+// Unbuffered stream buffer passing everything through to another one and
+// keeping the CRC-32C of the bytes written or read through it. Seeks are
+// forwarded, so GetRemainingBytes works on a stream using it.
+class ChecksumStreamBuf : public std::streambuf{
+public:
+    explicit ChecksumStreamBuf(std::streambuf *target)
+        : target_(target){
+    }
+
+    std::uint32_t GetChecksum() const{return checksum_;}
+
+protected:
+    std::streamsize xsputn(const char *data, std::streamsize size) override{
+        const std::streamsize written = target_->sputn(data, size);
+        checksum_ = ExtendCrc32c(checksum_, std::string_view(data, std::max<std::streamsize>(written, 0)));
+        return written;
+    }
+
+    int_type overflow(int_type ch) override{
+        if (traits_type::eq_int_type(ch, traits_type::eof())){
+            return traits_type::not_eof(ch);
+        }
+        const char c = traits_type::to_char_type(ch);
+        return xsputn(&c, 1) == 1 ? ch : traits_type::eof();
+    }
+
+    std::streamsize xsgetn(char *data, std::streamsize size) override{
+        const std::streamsize read = target_->sgetn(data, size);
+        checksum_ = ExtendCrc32c(checksum_, std::string_view(data, std::max<std::streamsize>(read, 0)));
+        return read;
+    }
+
+    int_type underflow() override{
+        return target_->sgetc();
+    }
+
+    int_type uflow() override{
+        char c;
+        return xsgetn(&c, 1) == 1 ? traits_type::to_int_type(c) : traits_type::eof();
+    }
+
+    pos_type seekoff(off_type offset, std::ios::seekdir direction, std::ios::openmode which) override{
+        return target_->pubseekoff(offset, direction, which);
+    }
+
+    pos_type seekpos(pos_type position, std::ios::openmode which) override{
+        return target_->pubseekpos(position, which);
+    }
+
+    int sync() override{
+        return target_->pubsync();
+    }
+
+private:
+    std::streambuf *target_;
+    std::uint32_t checksum_ = 0;
+};
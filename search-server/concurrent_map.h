@@ -38,12 +38,13 @@ public:
         return {buckets_[key_num], key};
     }
     
-    void Delete(const Key& key){
+    // Returns the number of erased entries, 0 or 1
+    size_t Delete(const Key& key){
         std::uint64_t uKey = static_cast<uint64_t>(key);
 	    std::uint64_t key_num = uKey % buckets_.size();
     
         std::lock_guard<std::mutex> m_guard(buckets_[key_num].mutex_value);
-        buckets_[key_num].data.erase(key);
+        return buckets_[key_num].data.erase(key);
     }
 
    std::map<Key, Value> BuildOrdinaryMap(){
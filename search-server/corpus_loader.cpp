@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <charconv>
+#include <execution>
+#include <iterator>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "corpus_loader.h"
+#include "mapped_file.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+// Documents of one chunk, or the offset of its first malformed record
+struct ParsedChunk{
+    std::vector<DocumentInput> documents;
+    std::size_t error_offset = std::string_view::npos;
+};
+
+bool ParseStatus(std::string_view text, DocumentStatus &status){
+    static const std::pair<std::string_view, DocumentStatus> STATUSES[] = {
+        {"ACTUAL", DocumentStatus::ACTUAL},
+        {"IRRELEVANT", DocumentStatus::IRRELEVANT},
+        {"BANNED", DocumentStatus::BANNED},
+        {"REMOVED", DocumentStatus::REMOVED},
+    };
+    for (const auto &[name, value] : STATUSES){
+        if (text == name){
+            status = value;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ParseInt(std::string_view text, int &value){
+    const auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return error == std::errc{} && end == text.data() + text.size();
+}
+
+// Cuts the field before the next tab off line
+bool TakeField(std::string_view &line, std::string_view &field){
+    const std::size_t tab = line.find('\t');
+    if (tab == std::string_view::npos){
+        return false;
+    }
+    field = line.substr(0, tab);
+    line.remove_prefix(tab + 1);
+    return true;
+}
+
+bool ParseRecord(std::string_view line, DocumentInput &document){
+    std::string_view id;
+    std::string_view status;
+    std::string_view ratings;
+    if (!TakeField(line, id) || !TakeField(line, status) || !TakeField(line, ratings)
+        || !ParseInt(id, document.document_id) || !ParseStatus(status, document.status)){
+        return false;
+    }
+    document.ratings.clear();
+    bool is_valid = true;
+    ForEachWord(ratings, [&document, &is_valid](std::string_view word, bool){
+        int rating = 0;
+        is_valid = is_valid && ParseInt(word, rating);
+        document.ratings.push_back(rating);
+    });
+    document.text = line;
+    return is_valid;
+}
+
+ParsedChunk ParseChunk(std::string_view corpus, std::size_t begin, std::size_t end){
+    ParsedChunk chunk;
+    while (begin < end){
+        std::size_t line_end = corpus.find('\n', begin);
+        if (line_end == std::string_view::npos || line_end > end){
+            line_end = end;
+        }
+        std::string_view line = corpus.substr(begin, line_end - begin);
+        if (!line.empty() && line.back() == '\r'){
+            line.remove_suffix(1);
+        }
+        if (!line.empty()){
+            DocumentInput document{};
+            if (!ParseRecord(line, document)){
+                chunk.error_offset = begin;
+                return chunk;
+            }
+            chunk.documents.push_back(std::move(document));
+        }
+        begin = line_end + 1;
+    }
+    return chunk;
+}
+
+} // namespace
+
+std::size_t LoadCorpus(SearchServer &search_server, const std::string &path, CorpusLoadOptions options){
+    // The mapping must outlive the load, the texts are read from it
+    const MappedFile corpus(path);
+    return LoadCorpusFromBuffer(search_server, corpus.GetContents(), options);
+}
+
+std::size_t LoadCorpusFromBuffer(SearchServer &search_server, std::string_view corpus, CorpusLoadOptions options){
+    const std::size_t chunk_size = std::max<std::size_t>(options.chunk_size, 1);
+    // A window of chunks is parsed at a time, so at most that many parsed
+    // records are held besides the index
+    const std::size_t window_size = std::max(4u * std::thread::hardware_concurrency(), 4u);
+
+    std::size_t added = 0;
+    std::size_t offset = 0;
+    while (offset < corpus.size()){
+        std::vector<std::pair<std::size_t, std::size_t>> bounds;
+        for (; offset < corpus.size() && bounds.size() < window_size; ){
+            std::size_t end = std::min(offset + chunk_size, corpus.size());
+            if (end < corpus.size()){
+                end = corpus.find('\n', end);
+                end = end == std::string_view::npos ? corpus.size() : end + 1;
+            }
+            bounds.emplace_back(offset, end);
+            offset = end;
+        }
+
+        std::vector<ParsedChunk> chunks(bounds.size());
+        std::transform(std::execution::par, bounds.begin(), bounds.end(), chunks.begin(),
+            [corpus](const std::pair<std::size_t, std::size_t> &chunk_bounds){
+                return ParseChunk(corpus, chunk_bounds.first, chunk_bounds.second);
+            });
+
+        std::vector<DocumentInput> documents;
+        std::size_t error_offset = std::string_view::npos;
+        for (ParsedChunk &chunk : chunks){
+            std::move(chunk.documents.begin(), chunk.documents.end(), std::back_inserter(documents));
+            if (chunk.error_offset != std::string_view::npos){
+                error_offset = chunk.error_offset;
+                break;
+            }
+        }
+        search_server.AddDocuments(std::execution::par, documents);
+        added += documents.size();
+        if (error_offset != std::string_view::npos){
+            throw std::invalid_argument("Malformed corpus record at byte "s + std::to_string(error_offset));
+        }
+    }
+    return added;
+}
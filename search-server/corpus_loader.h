@@ -0,0 +1,26 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include "search_server.h"
+
+// Corpus files hold one document per line, fields separated by tabs:
+//     id<TAB>status<TAB>ratings<TAB>text
+// status is ACTUAL, IRRELEVANT, BANNED or REMOVED, ratings are space
+// separated integers and may be empty. Empty lines are skipped.
+
+struct CorpusLoadOptions{
+    // Bytes parsed by one task, chunks end at line boundaries
+    std::size_t chunk_size = std::size_t{1} << 22;
+};
+
+// Maps the file, parses and tokenizes its chunks in parallel and adds the
+// documents in file order through AddDocuments. Document texts are read in
+// place and copied only into the term dictionary. Returns the number of added
+// documents. To avoid even that copy, keep the corpus mapped for the lifetime
+// of the server, pass it to SearchServer::BorrowText and load it with
+// LoadCorpusFromBuffer. Throws std::runtime_error if the file cannot be read and
+// std::invalid_argument on malformed records, documents before them stay added.
+std::size_t LoadCorpus(SearchServer &search_server, const std::string &path, CorpusLoadOptions options = {});
+std::size_t LoadCorpusFromBuffer(SearchServer &search_server, std::string_view corpus,
+                                 CorpusLoadOptions options = {});
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+
+// std::allocator that keeps the number of bytes the container holds.
+// Every container gets its own counter, shared by the rebound copies of
+// its allocator, so node based containers report their exact footprint
+// through get_allocator().GetBytes(). A container copy starts a counter
+// of its own, and copy assignment keeps the target's counter, since the
+// target reallocates its elements anyway. Not thread safe, like the
+// container itself under modification.
+template <typename T>
+class CountingAllocator{
+public:
+    using value_type = T;
+    // Moved and swapped storage takes its counter along
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+    using propagate_on_container_copy_assignment = std::false_type;
+
+    CountingAllocator()
+        : bytes_(std::make_shared<std::size_t>(0)){
+    }
+
+    // Copying instead of moving keeps the counter of a moved-from container
+    CountingAllocator(const CountingAllocator &other) noexcept = default;
+
+    template <typename U>
+    CountingAllocator(const CountingAllocator<U> &other) noexcept
+        : bytes_(other.bytes_){
+    }
+
+    CountingAllocator &operator=(const CountingAllocator &other) noexcept = default;
+
+    // Used by container copy constructors, the copy must not add to the original's counter
+    CountingAllocator select_on_container_copy_construction() const{
+        return {};
+    }
+
+    T *allocate(std::size_t count){
+        T *result = std::allocator<T>().allocate(count);
+        *bytes_ += count * sizeof(T);
+        return result;
+    }
+
+    void deallocate(T *pointer, std::size_t count) noexcept{
+        std::allocator<T>().deallocate(pointer, count);
+        *bytes_ -= count * sizeof(T);
+    }
+
+    std::size_t GetBytes() const{return *bytes_;}
+
+    template <typename U>
+    bool operator==(const CountingAllocator<U> &other) const{return bytes_ == other.bytes_;}
+    template <typename U>
+    bool operator!=(const CountingAllocator<U> &other) const{return bytes_ != other.bytes_;}
+
+private:
+    template <typename U>
+    friend class CountingAllocator;
+
+    std::shared_ptr<std::size_t> bytes_;
+};
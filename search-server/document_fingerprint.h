@@ -0,0 +1,25 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+// 128-bit fingerprint of a document's set of distinct words. Equal word sets
+// give equal fingerprints; both lanes come from one 64-bit word hash, so
+// distinct sets may collide and SearchServer compares the words of documents
+// with equal fingerprints. It does not depend on word order or repeats.
+struct DocumentFingerprint{
+    std::uint64_t low = 0;
+    std::uint64_t high = 0;
+
+    bool operator==(const DocumentFingerprint &other) const{
+        return low == other.low && high == other.high;
+    }
+    bool operator!=(const DocumentFingerprint &other) const{
+        return !(*this == other);
+    }
+};
+
+struct DocumentFingerprintHasher{
+    std::size_t operator()(const DocumentFingerprint &fingerprint) const{
+        return static_cast<std::size_t>(fingerprint.low ^ (fingerprint.high * 0x9E3779B97F4A7C15ULL));
+    }
+};
@@ -0,0 +1,73 @@
+#include <cstdio>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include "binary_io.h"
+#include "durable_search_server.h"
+
+using namespace std::string_literals;
+
+// A checkpoint is the sequence number of the last logged operation it
+// contains followed by a SearchServer snapshot
+
+DurableSearchServer::DurableSearchServer(const std::string &checkpoint_path, const std::string &log_path,
+                                         SearchServer empty_server, WriteAheadLogOptions options)
+    : checkpoint_path_(checkpoint_path),
+    search_server_(LoadCheckpoint(checkpoint_path, std::move(empty_server), checkpoint_sequence_)),
+    log_(log_path, options){
+    replayed_count_ = log_.Replay(search_server_, checkpoint_sequence_);
+}
+
+void DurableSearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
+                                      const std::vector<int> &ratings){
+    search_server_.AddDocument(document_id, document, status, ratings);
+    log_.LogAddDocument(document_id, document, status, ratings);
+}
+
+void DurableSearchServer::RemoveDocument(int document_id){
+    search_server_.RemoveDocument(document_id);
+    log_.LogRemoveDocument(document_id);
+}
+
+void DurableSearchServer::Sync(){
+    log_.Sync();
+}
+
+void DurableSearchServer::Checkpoint(){
+    log_.Sync();
+    const std::string temporary_path = checkpoint_path_ + ".tmp"s;
+    {
+        std::ofstream output(temporary_path, std::ios::binary | std::ios::trunc);
+        if (!output){
+            throw std::runtime_error("Cannot open "s + temporary_path);
+        }
+        WriteValue(output, log_.GetLastSequence());
+        search_server_.Save(output);
+        output.close();
+        if (!output){
+            throw std::runtime_error("Cannot write "s + temporary_path);
+        }
+    }
+    SyncFile(temporary_path);
+    // A crash before the rename keeps the old checkpoint and the full log,
+    // a crash after it replays only records newer than the new checkpoint
+    if (std::rename(temporary_path.c_str(), checkpoint_path_.c_str()) != 0){
+        throw std::runtime_error("Cannot replace "s + checkpoint_path_);
+    }
+    // The rename is durable only once the directory is synced; the log
+    // may be emptied only after that, or a crash could lose both
+    SyncParentDirectory(checkpoint_path_);
+    checkpoint_sequence_ = log_.GetLastSequence();
+    log_.Truncate();
+}
+
+SearchServer DurableSearchServer::LoadCheckpoint(const std::string &path, SearchServer &&empty_server,
+                                                 std::uint64_t &sequence){
+    std::ifstream input(path, std::ios::binary);
+    if (!input){
+        sequence = 0;
+        return std::move(empty_server);
+    }
+    sequence = ReadValue<std::uint64_t>(input);
+    return SearchServer::Load(input);
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "search_server.h"
+#include "write_ahead_log.h"
+
+// SearchServer whose changes survive a crash. Every applied AddDocument and
+// RemoveDocument is appended to a write-ahead log; Checkpoint saves a snapshot
+// and empties the log. On construction the latest checkpoint is loaded and
+// the log is replayed on top of it.
+class DurableSearchServer{
+public:
+    // empty_server is used when there is no checkpoint yet
+    DurableSearchServer(const std::string &checkpoint_path, const std::string &log_path,
+                        SearchServer empty_server, WriteAheadLogOptions options = {});
+
+    // Throw like the SearchServer methods, rejected operations are not logged.
+    // Removing an unknown document is logged too and replays as a no-op.
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status,
+                     const std::vector<int> &ratings);
+    void RemoveDocument(int document_id);
+
+    // Makes all logged operations durable
+    void Sync();
+    // Atomically replaces the checkpoint file and truncates the log
+    void Checkpoint();
+
+    const SearchServer &GetSearchServer() const{return search_server_;}
+    // Number of log records applied on construction
+    std::size_t GetReplayedCount() const{return replayed_count_;}
+
+private:
+    std::string checkpoint_path_;
+    std::uint64_t checkpoint_sequence_ = 0;
+    SearchServer search_server_;
+    WriteAheadLog log_;
+    std::size_t replayed_count_ = 0;
+
+    static SearchServer LoadCheckpoint(const std::string &path, SearchServer &&empty_server,
+                                       std::uint64_t &sequence);
+};
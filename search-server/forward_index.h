@@ -0,0 +1,70 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string_view>
+#include <utility>
+#include "term_dictionary.h"
+
+// One term of a document's forward index with the number of its
+// occurrences; tf is term_count divided by the document's word count.
+// The entries of a document are stored contiguously and sorted by term.
+struct ForwardEntry{
+    TermId term;
+    std::uint32_t term_count;
+};
+
+// Read-only view of a document's forward index, yielding (word, tf) pairs
+// ordered by term id. Adding or removing documents invalidates it.
+class WordFrequencies{
+public:
+    class Iterator{
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::pair<std::string_view, double>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = value_type;
+
+        Iterator(const ForwardEntry *entry, const TermDictionary *terms, double inv_word_count)
+            : entry_(entry), terms_(terms), inv_word_count_(inv_word_count){}
+
+        value_type operator*() const{
+            return {terms_->GetTerm(entry_->term), entry_->term_count * inv_word_count_};
+        }
+        Iterator &operator++(){
+            ++entry_;
+            return *this;
+        }
+        Iterator operator++(int){
+            Iterator old = *this;
+            ++entry_;
+            return old;
+        }
+        bool operator==(const Iterator &other) const{return entry_ == other.entry_;}
+        bool operator!=(const Iterator &other) const{return entry_ != other.entry_;}
+
+    private:
+        const ForwardEntry *entry_;
+        const TermDictionary *terms_;
+        double inv_word_count_;
+    };
+
+    WordFrequencies() = default;
+    WordFrequencies(const ForwardEntry *entries, std::size_t size, const TermDictionary *terms,
+                    double inv_word_count)
+        : entries_(entries), size_(size), terms_(terms), inv_word_count_(inv_word_count){}
+
+    Iterator begin() const{return {entries_, terms_, inv_word_count_};}
+    Iterator end() const{return {entries_ + size_, terms_, inv_word_count_};}
+    std::size_t size() const{return size_;}
+    bool empty() const{return size_ == 0;}
+
+    const ForwardEntry *data() const{return entries_;}
+
+private:
+    const ForwardEntry *entries_ = nullptr;
+    std::size_t size_ = 0;
+    const TermDictionary *terms_ = nullptr;
+    double inv_word_count_ = 0;
+};
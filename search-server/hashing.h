@@ -0,0 +1,89 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+
+// Finalizer of a 64-bit hash (SplitMix64)
+constexpr std::uint64_t MixHash(std::uint64_t value){
+    value ^= value >> 30;
+    value *= 0xBF58476D1CE4E5B9ULL;
+    value ^= value >> 27;
+    value *= 0x94D049BB133111EBULL;
+    value ^= value >> 31;
+    return value;
+}
+
+// Reads up to 8 bytes as a little-endian number. Written with shifts to stay
+// constexpr, compilers turn it into a single load.
+constexpr std::uint64_t LoadChunk(std::string_view str, std::size_t pos, std::size_t count){
+    std::uint64_t chunk = 0;
+    for (std::size_t i = 0; i < count; ++i){
+        chunk |= static_cast<std::uint64_t>(static_cast<unsigned char>(str[pos + i])) << (8 * i);
+    }
+    return chunk;
+}
+
+constexpr std::uint64_t HashString(std::string_view str, std::uint64_t seed = 0){
+    std::uint64_t hash = seed ^ (str.size() * 0x9E3779B97F4A7C15ULL);
+    std::size_t pos = 0;
+    for (; pos + 8 <= str.size(); pos += 8){
+        hash = MixHash(hash ^ LoadChunk(str, pos, 8));
+    }
+    if (pos < str.size()){
+        hash = MixHash(hash ^ LoadChunk(str, pos, str.size() - pos));
+    }
+    return MixHash(hash);
+}
+
+namespace hashing_detail {
+
+// Table k advances the CRC over a byte followed by k zero bytes, so eight
+// bytes are folded in at once (slicing-by-8)
+constexpr std::array<std::array<std::uint32_t, 256>, 8> MakeCrcTables(){
+    std::array<std::array<std::uint32_t, 256>, 8> tables{};
+    for (std::uint32_t i = 0; i < 256; ++i){
+        std::uint32_t crc = i;
+        for (int bit = 0; bit < 8; ++bit){
+            // Reflected Castagnoli polynomial
+            crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1u)));
+        }
+        tables[0][i] = crc;
+    }
+    for (std::size_t k = 1; k < 8; ++k){
+        for (std::uint32_t i = 0; i < 256; ++i){
+            tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xFFu];
+        }
+    }
+    return tables;
+}
+
+inline constexpr std::array<std::array<std::uint32_t, 256>, 8> CRC_TABLES = MakeCrcTables();
+
+} // namespace hashing_detail
+
+// CRC-32C of the data following the bytes crc was computed for, so
+// ExtendCrc32c(ComputeCrc32c(a), b) == ComputeCrc32c(a + b)
+constexpr std::uint32_t ExtendCrc32c(std::uint32_t crc, std::string_view data){
+    const auto &tables = hashing_detail::CRC_TABLES;
+    crc = ~crc;
+    std::size_t pos = 0;
+    for (; pos + 8 <= data.size(); pos += 8){
+        const std::uint64_t chunk = LoadChunk(data, pos, 8) ^ crc;
+        crc = tables[7][chunk & 0xFFu] ^ tables[6][(chunk >> 8) & 0xFFu]
+            ^ tables[5][(chunk >> 16) & 0xFFu] ^ tables[4][(chunk >> 24) & 0xFFu]
+            ^ tables[3][(chunk >> 32) & 0xFFu] ^ tables[2][(chunk >> 40) & 0xFFu]
+            ^ tables[1][(chunk >> 48) & 0xFFu] ^ tables[0][chunk >> 56];
+    }
+    for (; pos < data.size(); ++pos){
+        crc = (crc >> 8) ^ tables[0][(crc ^ static_cast<unsigned char>(data[pos])) & 0xFFu];
+    }
+    return ~crc;
+}
+
+constexpr std::uint32_t ComputeCrc32c(std::string_view data){
+    return ExtendCrc32c(0, data);
+}
+
+// Check value of the CRC-32C specification
+static_assert(ComputeCrc32c("123456789") == 0xE3069283u);
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include "inverted_index.h"
+#include "binary_io.h"
+
+namespace {
+
+bool ByDocumentId(const Posting &posting, int document_id){
+    return posting.document_id < document_id;
+}
+
+} // namespace
+
+void InvertedIndex::AddDocument(int document_id, const ForwardEntry *first, const ForwardEntry *last){
+    for (const ForwardEntry *entry = first; entry != last; ++entry){
+        Insert(entry->term, {document_id, entry->term_count});
+    }
+    live_postings_ += last - first;
+}
+
+void InvertedIndex::RemoveDocument(const std::execution::sequenced_policy&, int document_id,
+                                   const ForwardEntry *first, const ForwardEntry *last){
+    for (const ForwardEntry *entry = first; entry != last; ++entry){
+        Erase(entry->term, document_id);
+    }
+    live_postings_ -= last - first;
+    Compact();
+}
+
+void InvertedIndex::RemoveDocument(const std::execution::parallel_policy&, int document_id,
+                                   const ForwardEntry *first, const ForwardEntry *last){
+    std::for_each(std::execution::par, first, last, [this, document_id](const ForwardEntry &entry){
+        Erase(entry.term, document_id);
+    });
+    live_postings_ -= last - first;
+    Compact();
+}
+
+bool InvertedIndex::Contains(TermId term, int document_id) const{
+    const PostingRange postings = GetPostings(term);
+    const Posting *it = std::lower_bound(postings.begin(), postings.end(), document_id, ByDocumentId);
+    return it != postings.end() && it->document_id == document_id;
+}
+
+void InvertedIndex::Save(std::ostream &output) const{
+    std::vector<std::uint32_t> sizes;
+    sizes.reserve(lists_.size());
+    for (const PostingList &list : lists_){
+        sizes.push_back(list.size);
+    }
+    WriteVector(output, sizes);
+    WriteValue<std::uint64_t>(output, live_postings_);
+    for (const PostingList &list : lists_){
+        WriteArray(output, postings_.data() + list.offset, list.size);
+    }
+}
+
+void InvertedIndex::Load(std::istream &input){
+    const auto sizes = ReadVector<std::uint32_t>(input);
+    const auto posting_count = ReadValue<std::uint64_t>(input);
+    std::vector<PostingList> lists(sizes.size());
+    std::size_t offset = 0;
+    for (std::size_t term = 0; term < sizes.size(); ++term){
+        lists[term] = {offset, sizes[term], sizes[term]};
+        offset += sizes[term];
+    }
+    if (offset != posting_count){
+        throw std::invalid_argument("Posting list sizes do not match the postings");
+    }
+    postings_ = ReadVector<Posting>(input, posting_count);
+    lists_ = std::move(lists);
+    live_postings_ = postings_.size();
+}
+
+void InvertedIndex::Insert(TermId term, Posting posting){
+    if (term >= lists_.size()){
+        lists_.resize(term + 1);
+    }
+    PostingList &list = lists_[term];
+    if (list.size == list.capacity){
+        const std::size_t offset = postings_.size();
+        const std::uint32_t capacity = std::max<std::uint32_t>(4, list.capacity * 2);
+        postings_.resize(offset + capacity);
+        std::copy(postings_.begin() + list.offset, postings_.begin() + list.offset + list.size,
+                  postings_.begin() + offset);
+        list.offset = offset;
+        list.capacity = capacity;
+    }
+    // Documents mostly arrive in id order, then this is an append
+    Posting *first = postings_.data() + list.offset;
+    Posting *last = first + list.size;
+    Posting *position = std::lower_bound(first, last, posting.document_id, ByDocumentId);
+    std::copy_backward(position, last, last + 1);
+    *position = posting;
+    ++list.size;
+}
+
+void InvertedIndex::Erase(TermId term, int document_id){
+    PostingList &list = lists_[term];
+    Posting *first = postings_.data() + list.offset;
+    Posting *last = first + list.size;
+    Posting *position = std::lower_bound(first, last, document_id, ByDocumentId);
+    if (position != last && position->document_id == document_id){
+        std::copy(position + 1, last, position);
+        --list.size;
+    }
+}
+
+// Packs the lists without spare capacity once the arena is more than twice the live postings
+void InvertedIndex::Compact(){
+    if (postings_.size() <= 2 * live_postings_ + 1024){
+        return;
+    }
+    std::vector<Posting> postings;
+    postings.reserve(live_postings_);
+    for (PostingList &list : lists_){
+        const auto first = postings_.begin() + list.offset;
+        list.offset = postings.size();
+        list.capacity = list.size;
+        postings.insert(postings.end(), first, first + list.size);
+    }
+    postings_ = std::move(postings);
+}
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <execution>
+#include <istream>
+#include <ostream>
+#include <vector>
+#include "forward_index.h"
+#include "term_dictionary.h"
+
+// Eight bytes: the tf is rebuilt at score time from the count and
+// the document's word count
+struct Posting{
+    int document_id;
+    std::uint32_t term_count;
+};
+
+// Sorted by document id
+class PostingRange{
+public:
+    PostingRange() = default;
+    PostingRange(const Posting *first, const Posting *last)
+        : first_(first), last_(last){}
+
+    const Posting *begin() const{return first_;}
+    const Posting *end() const{return last_;}
+    std::size_t size() const{return last_ - first_;}
+    bool empty() const{return first_ == last_;}
+
+private:
+    const Posting *first_ = nullptr;
+    const Posting *last_ = nullptr;
+};
+
+// Posting lists of all terms in one arena. Every list owns a segment with
+// spare capacity; a full list moves to the end of the arena with twice the
+// capacity, like a vector would. Segments left behind are reclaimed once
+// they outweigh the live postings.
+class InvertedIndex{
+public:
+    struct PostingList{
+        std::size_t offset = 0;
+        std::uint32_t size = 0;
+        std::uint32_t capacity = 0;
+    };
+
+    // The entries are the document's forward index
+    void AddDocument(int document_id, const ForwardEntry *first, const ForwardEntry *last);
+    void RemoveDocument(const std::execution::sequenced_policy&, int document_id,
+                        const ForwardEntry *first, const ForwardEntry *last);
+    // Distinct terms own disjoint segments, so they are updated in parallel
+    void RemoveDocument(const std::execution::parallel_policy&, int document_id,
+                        const ForwardEntry *first, const ForwardEntry *last);
+
+    // Empty for terms without postings
+    PostingRange GetPostings(TermId term) const{
+        if (term >= lists_.size()){
+            return {};
+        }
+        const Posting *first = postings_.data() + lists_[term].offset;
+        return {first, first + lists_[term].size};
+    }
+    bool Contains(TermId term, int document_id) const;
+
+    std::size_t GetTermCount() const{return lists_.size();}
+    std::size_t GetPostingCount() const{return live_postings_;}
+    // Arena slots not holding a live posting: spare capacity of the lists
+    // and segments left behind by lists that grew or shrank
+    std::size_t GetDeadPostingCount() const{return postings_.size() - live_postings_;}
+    std::size_t GetMemoryBytes() const{
+        return postings_.capacity() * sizeof(Posting) + lists_.capacity() * sizeof(PostingList);
+    }
+
+    // Binary form: the list sizes, then all postings packed in term order.
+    // Load replaces the contents with two allocations in total.
+    void Save(std::ostream &output) const;
+    void Load(std::istream &input);
+
+private:
+    std::vector<Posting> postings_;
+    std::vector<PostingList> lists_;
+    std::size_t live_postings_ = 0;
+
+    void Insert(TermId term, Posting posting);
+    void Erase(TermId term, int document_id);
+    void Compact();
+};
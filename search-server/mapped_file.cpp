@@ -0,0 +1,83 @@
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+#include "mapped_file.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SEARCH_SERVER_HAS_MMAP 1
+#endif
+
+using namespace std::string_literals;
+
+MappedFile::MappedFile(const std::string &path){
+#ifdef SEARCH_SERVER_HAS_MMAP
+    const int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0){
+        throw std::runtime_error("Cannot open "s + path);
+    }
+    struct stat file_stat{};
+    if (fstat(descriptor, &file_stat) != 0){
+        close(descriptor);
+        throw std::runtime_error("Cannot stat "s + path);
+    }
+    size_ = static_cast<std::size_t>(file_stat.st_size);
+    if (size_ != 0){
+        void *address = mmap(nullptr, size_, PROT_READ, MAP_SHARED, descriptor, 0);
+        if (address == MAP_FAILED){
+            close(descriptor);
+            throw std::runtime_error("Cannot map "s + path);
+        }
+        data_ = static_cast<const char*>(address);
+        is_mapped_ = true;
+    }
+    // The mapping keeps the file referenced
+    close(descriptor);
+#else
+    std::ifstream input(path, std::ios::binary | std::ios::ate);
+    if (!input){
+        throw std::runtime_error("Cannot open "s + path);
+    }
+    buffer_.resize(static_cast<std::size_t>(input.tellg()));
+    input.seekg(0);
+    input.read(buffer_.data(), buffer_.size());
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+#endif
+}
+
+MappedFile::~MappedFile(){
+    Release();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept{
+    *this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept{
+    if (this != &other){
+        Release();
+        buffer_ = std::move(other.buffer_);
+        data_ = other.is_mapped_ ? other.data_ : buffer_.data();
+        size_ = other.size_;
+        is_mapped_ = other.is_mapped_;
+        other.data_ = nullptr;
+        other.size_ = 0;
+        other.is_mapped_ = false;
+    }
+    return *this;
+}
+
+void MappedFile::Release(){
+#ifdef SEARCH_SERVER_HAS_MMAP
+    if (is_mapped_){
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    is_mapped_ = false;
+    buffer_.clear();
+}
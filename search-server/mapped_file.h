@@ -0,0 +1,33 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Read-only view of a whole file. On POSIX systems the file is mapped with
+// mmap, so processes opening the same file share its page cache copy;
+// elsewhere it is read into memory.
+class MappedFile{
+public:
+    MappedFile() = default;
+    // Throws std::runtime_error when the file cannot be opened
+    explicit MappedFile(const std::string &path);
+    ~MappedFile();
+
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile &operator=(const MappedFile&) = delete;
+
+    const char *data() const{return data_;}
+    std::size_t size() const{return size_;}
+    std::string_view GetContents() const{return {data_, size_};}
+
+private:
+    const char *data_ = nullptr;
+    std::size_t size_ = 0;
+    bool is_mapped_ = false;
+    std::vector<char> buffer_;
+
+    void Release();
+};
@@ -0,0 +1,290 @@
+#include "mapped_index.h"
+#include <cstring>
+#include <stdexcept>
+#include "binary_io.h"
+#include "hashing.h"
+
+namespace {
+
+constexpr char MAPPED_INDEX_MAGIC[8] = {'S', 'R', 'C', 'H', 'M', 'A', 'P', '1'};
+constexpr std::uint32_t MAPPED_INDEX_VERSION = 2;
+constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+// Every section starts at a multiple of this, enough for all section types
+constexpr std::uint64_t SECTION_ALIGNMENT = 8;
+
+std::uint64_t AlignSection(std::uint64_t offset){
+    return (offset + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+// Writes sections one after another, padding each to the alignment
+class SectionWriter{
+public:
+    explicit SectionWriter(std::ostream &output)
+        : output_(output){
+    }
+
+    template <typename T>
+    std::uint64_t Write(const std::vector<T> &values){
+        return Write(values.data(), values.size() * sizeof(T));
+    }
+
+    std::uint64_t Write(const void *data, std::size_t size){
+        static const char PADDING[SECTION_ALIGNMENT] = {};
+        const std::uint64_t aligned = AlignSection(offset_);
+        output_.write(PADDING, aligned - offset_);
+        output_.write(static_cast<const char*>(data), size);
+        offset_ = aligned + size;
+        return aligned;
+    }
+
+private:
+    std::ostream &output_;
+    std::uint64_t offset_ = sizeof(MappedIndex::Header);
+};
+
+template <typename T>
+const T *GetSection(const MappedFile &file, std::uint64_t offset, std::uint64_t count){
+    if (offset % alignof(T) != 0 || offset > file.size()
+        || count > (file.size() - offset) / sizeof(T)){
+        throw std::invalid_argument("Mapped index section is out of bounds");
+    }
+    return reinterpret_cast<const T*>(file.data() + offset);
+}
+
+// Checks the first and the last of count + 1 offsets, the ones between
+// are checked on access by CheckRange
+void CheckOffsetBounds(const std::uint64_t *offsets, std::uint64_t count, std::uint64_t limit){
+    if (offsets[0] != 0 || offsets[count] != limit){
+        throw std::invalid_argument("Mapped index offsets are corrupted");
+    }
+}
+
+// Returns offsets[i] and offsets[i + 1] if they form a range within limit
+std::pair<std::uint64_t, std::uint64_t> CheckRange(const std::uint64_t *offsets, std::uint64_t i, std::uint64_t limit){
+    const std::uint64_t begin = offsets[i];
+    const std::uint64_t end = offsets[i + 1];
+    if (begin > end || end > limit){
+        throw std::invalid_argument("Mapped index offsets are corrupted");
+    }
+    return {begin, end};
+}
+
+} // namespace
+
+void MappedIndex::Write(const SearchServer &search_server, std::ostream &output){
+    Header header{};
+    std::memcpy(header.magic, MAPPED_INDEX_MAGIC, sizeof(header.magic));
+    header.version = MAPPED_INDEX_VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+
+    const TermDictionary &terms = search_server.terms_;
+    header.term_count = terms.size();
+    header.term_slot_count = 2;
+    while (header.term_slot_count < 2 * header.term_count){
+        header.term_slot_count *= 2;
+    }
+    std::vector<TermId> term_slots(header.term_slot_count, NO_TERM);
+    std::vector<std::uint64_t> term_hashes(header.term_slot_count, 0);
+    std::vector<std::uint64_t> term_text_offsets{0};
+    std::string term_text;
+    const std::uint64_t slot_mask = header.term_slot_count - 1;
+    for (TermId term = 0; term < header.term_count; ++term){
+        const std::uint64_t hash = terms.GetHash(term);
+        std::uint64_t slot = hash & slot_mask;
+        while (term_slots[slot] != NO_TERM){
+            slot = (slot + 1) & slot_mask;
+        }
+        term_slots[slot] = term;
+        term_hashes[slot] = hash;
+        term_text += terms.GetTerm(term);
+        term_text_offsets.push_back(term_text.size());
+    }
+
+    // Postings refer to documents by their position among the sorted ids
+    std::map<int, std::uint32_t> document_indexes;
+    std::vector<std::int32_t> document_ids;
+    std::vector<std::int32_t> document_ratings;
+    std::vector<std::int32_t> document_statuses;
+    std::vector<std::uint32_t> document_word_counts;
+    std::vector<std::uint64_t> forward_offsets{0};
+    std::vector<ForwardEntry> forward_entries;
+    for (const auto &[document_id, data] : search_server.documents_){
+        document_indexes.emplace(document_id, static_cast<std::uint32_t>(document_ids.size()));
+        document_ids.push_back(document_id);
+        document_ratings.push_back(data.rating);
+        document_statuses.push_back(static_cast<std::int32_t>(data.status));
+        document_word_counts.push_back(data.word_count);
+        const WordFrequencies entries = search_server.GetWordFrequencies(document_id);
+        forward_entries.insert(forward_entries.end(), entries.data(), entries.data() + entries.size());
+        forward_offsets.push_back(forward_entries.size());
+    }
+    header.document_count = document_ids.size();
+    header.forward_entry_count = forward_entries.size();
+
+    std::vector<std::uint64_t> posting_offsets{0};
+    std::vector<Posting> postings;
+    for (TermId term = 0; term < header.term_count; ++term){
+        for (const ::Posting &posting : search_server.inverted_index_.GetPostings(term)){
+            postings.push_back({document_indexes.at(posting.document_id), posting.term_count});
+        }
+        posting_offsets.push_back(postings.size());
+    }
+    header.posting_count = postings.size();
+
+    std::vector<std::uint64_t> stop_word_offsets{0};
+    std::string stop_word_text;
+    for (const std::string &word : search_server.stop_words_){
+        stop_word_text += word;
+        stop_word_offsets.push_back(stop_word_text.size());
+    }
+    header.stop_word_count = search_server.stop_words_.size();
+
+    // Offsets count from the header, which need not be at the start of the stream
+    const std::ostream::pos_type start = output.tellp();
+    if (start == std::ostream::pos_type(-1)){
+        throw std::runtime_error("Mapped index output is not seekable");
+    }
+    WriteValue(output, header);
+    SectionWriter writer(output);
+    header.term_slots_offset = writer.Write(term_slots);
+    header.term_hashes_offset = writer.Write(term_hashes);
+    header.term_text_offsets_offset = writer.Write(term_text_offsets);
+    header.term_text_offset = writer.Write(term_text.data(), term_text.size());
+    header.posting_offsets_offset = writer.Write(posting_offsets);
+    header.postings_offset = writer.Write(postings);
+    header.document_ids_offset = writer.Write(document_ids);
+    header.document_ratings_offset = writer.Write(document_ratings);
+    header.document_statuses_offset = writer.Write(document_statuses);
+    header.document_word_counts_offset = writer.Write(document_word_counts);
+    header.forward_offsets_offset = writer.Write(forward_offsets);
+    header.forward_entries_offset = writer.Write(forward_entries);
+    header.stop_word_offsets_offset = writer.Write(stop_word_offsets);
+    header.stop_word_text_offset = writer.Write(stop_word_text.data(), stop_word_text.size());
+
+    // The offsets are known only now, rewrite the header in place
+    output.seekp(start);
+    WriteValue(output, header);
+    output.seekp(0, std::ios_base::end);
+    if (!output){
+        throw std::runtime_error("Failed to write mapped index");
+    }
+}
+
+MappedIndex::MappedIndex(const std::string &path)
+    : file_(path){
+    header_ = GetSection<Header>(file_, 0, 1);
+    if (std::memcmp(header_->magic, MAPPED_INDEX_MAGIC, sizeof(header_->magic)) != 0){
+        throw std::invalid_argument("Not a mapped search index");
+    }
+    if (header_->version != MAPPED_INDEX_VERSION){
+        throw std::invalid_argument("Unsupported mapped index version");
+    }
+    if (header_->byte_order != BYTE_ORDER_MARK){
+        throw std::invalid_argument("Mapped index was written with another byte order");
+    }
+    const Header &header = *header_;
+    if (header.term_slot_count == 0 || (header.term_slot_count & (header.term_slot_count - 1)) != 0
+        || header.term_slot_count <= header.term_count || header.document_count > UINT32_MAX){
+        throw std::invalid_argument("Mapped index header is corrupted");
+    }
+
+    term_slots_ = GetSection<TermId>(file_, header.term_slots_offset, header.term_slot_count);
+    term_hashes_ = GetSection<std::uint64_t>(file_, header.term_hashes_offset, header.term_slot_count);
+    term_text_offsets_ = GetSection<std::uint64_t>(file_, header.term_text_offsets_offset, header.term_count + 1);
+    posting_offsets_ = GetSection<std::uint64_t>(file_, header.posting_offsets_offset, header.term_count + 1);
+    postings_ = GetSection<Posting>(file_, header.postings_offset, header.posting_count);
+    document_ids_ = GetSection<std::int32_t>(file_, header.document_ids_offset, header.document_count);
+    document_ratings_ = GetSection<std::int32_t>(file_, header.document_ratings_offset, header.document_count);
+    document_statuses_ = GetSection<std::int32_t>(file_, header.document_statuses_offset, header.document_count);
+    document_word_counts_ = GetSection<std::uint32_t>(file_, header.document_word_counts_offset, header.document_count);
+    forward_offsets_ = GetSection<std::uint64_t>(file_, header.forward_offsets_offset, header.document_count + 1);
+    forward_entries_ = GetSection<ForwardEntry>(file_, header.forward_entries_offset, header.forward_entry_count);
+    const std::uint64_t *stop_word_offsets = GetSection<std::uint64_t>(
+        file_, header.stop_word_offsets_offset, header.stop_word_count + 1);
+
+    CheckOffsetBounds(term_text_offsets_, header.term_count, term_text_offsets_[header.term_count]);
+    term_text_ = GetSection<char>(file_, header.term_text_offset, term_text_offsets_[header.term_count]);
+    CheckOffsetBounds(posting_offsets_, header.term_count, header.posting_count);
+    CheckOffsetBounds(forward_offsets_, header.document_count, header.forward_entry_count);
+    CheckOffsetBounds(stop_word_offsets, header.stop_word_count, stop_word_offsets[header.stop_word_count]);
+    const std::uint64_t stop_word_text_size = stop_word_offsets[header.stop_word_count];
+    const char *stop_word_text = GetSection<char>(file_, header.stop_word_text_offset, stop_word_text_size);
+
+    // Stop words are copied anyway, so they are the only section read in full
+    std::vector<std::string_view> stop_words;
+    stop_words.reserve(header.stop_word_count);
+    for (std::uint64_t i = 0; i < header.stop_word_count; ++i){
+        const auto [begin, end] = CheckRange(stop_word_offsets, i, stop_word_text_size);
+        stop_words.emplace_back(stop_word_text + begin, end - begin);
+    }
+    stop_words_ = StopWordSet(stop_words);
+}
+
+std::vector<Document> MappedIndex::FindTopDocuments(std::string_view raw_query) const{
+    return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
+}
+
+std::vector<Document> MappedIndex::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const{
+    return FindTopDocuments(raw_query, SearchServer::MakeStatusPredicate(status));
+}
+
+SearchServer::MatchedDoc MappedIndex::MatchDocument(std::string_view raw_query, int document_id) const{
+    const std::int32_t *ids_end = document_ids_ + header_->document_count;
+    const std::int32_t *found = std::lower_bound(document_ids_, ids_end, document_id);
+    if (found == ids_end || *found != document_id){
+        throw std::out_of_range("Document is not found");
+    }
+    const std::uint64_t index = found - document_ids_;
+    const DocumentStatus status = static_cast<DocumentStatus>(document_statuses_[index]);
+    const auto [begin, end] = CheckRange(forward_offsets_, index, header_->forward_entry_count);
+    const ForwardEntry *first = forward_entries_ + begin;
+    const ForwardEntry *last = forward_entries_ + end;
+    const auto contains = [first, last](TermId term){
+        const ForwardEntry *entry = std::lower_bound(first, last, term, [](const ForwardEntry &entry, TermId term){
+            return entry.term < term;
+        });
+        return entry != last && entry->term == term;
+    };
+
+    const QueryWords words = ParseQueryWords(raw_query, stop_words_);
+    std::vector<std::string_view> matched_words;
+    for (std::string_view word : words.minus_words){
+        const TermId term = FindTerm(word);
+        if (term != NO_TERM && contains(term)){
+            return {matched_words, status};
+        }
+    }
+    for (std::string_view word : words.plus_words){
+        const TermId term = FindTerm(word);
+        if (term != NO_TERM && contains(term)){
+            // Point into the mapping, the query text may not outlive the call
+            matched_words.push_back(GetTerm(term));
+        }
+    }
+    return {matched_words, status};
+}
+
+std::string_view MappedIndex::GetTerm(TermId term) const{
+    const auto [begin, end] = CheckRange(term_text_offsets_, term, term_text_offsets_[header_->term_count]);
+    return {term_text_ + begin, end - begin};
+}
+
+std::pair<const MappedIndex::Posting*, const MappedIndex::Posting*> MappedIndex::GetPostings(TermId term) const{
+    const auto [begin, end] = CheckRange(posting_offsets_, term, header_->posting_count);
+    return {postings_ + begin, postings_ + end};
+}
+
+TermId MappedIndex::FindTerm(std::string_view word) const{
+    const std::uint64_t hash = HashString(word);
+    const std::uint64_t slot_mask = header_->term_slot_count - 1;
+    // A valid table always has an empty slot, a corrupted one may not
+    std::uint64_t slot = hash & slot_mask;
+    for (std::uint64_t probe = 0; probe < header_->term_slot_count && term_slots_[slot] != NO_TERM;
+         ++probe, slot = (slot + 1) & slot_mask){
+        const TermId term = term_slots_[slot];
+        if (term_hashes_[slot] == hash && term < header_->term_count && GetTerm(term) == word){
+            return term;
+        }
+    }
+    return NO_TERM;
+}
@@ -0,0 +1,152 @@
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "document.h"
+#include "mapped_file.h"
+#include "query_parser.h"
+#include "search_server.h"
+#include "stop_words.h"
+
+// Read-only index queried in place from a memory mapped file.
+// Every section is an array addressed by its offset from the file start,
+// so the pages can be shared between all processes serving the same file.
+// Opening checks only the header and the section bounds and copies nothing
+// except the stop words, so it costs the same for any index size. Offsets
+// and positions read from the sections are checked when a query reaches
+// them; corruption found then throws std::invalid_argument.
+class MappedIndex{
+public:
+    struct Header{
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byte_order;
+        std::uint64_t term_count;
+        std::uint64_t term_slot_count;
+        std::uint64_t posting_count;
+        std::uint64_t document_count;
+        std::uint64_t forward_entry_count;
+        std::uint64_t stop_word_count;
+        // TermId per slot, open addressing with linear probing on the term hash
+        std::uint64_t term_slots_offset;
+        std::uint64_t term_hashes_offset;
+        // term_count + 1 offsets into the term text
+        std::uint64_t term_text_offsets_offset;
+        std::uint64_t term_text_offset;
+        // term_count + 1 offsets into the postings
+        std::uint64_t posting_offsets_offset;
+        std::uint64_t postings_offset;
+        // Document columns, sorted by document id
+        std::uint64_t document_ids_offset;
+        std::uint64_t document_ratings_offset;
+        std::uint64_t document_statuses_offset;
+        std::uint64_t document_word_counts_offset;
+        // document_count + 1 offsets into the forward entries
+        std::uint64_t forward_offsets_offset;
+        std::uint64_t forward_entries_offset;
+        std::uint64_t stop_word_offsets_offset;
+        std::uint64_t stop_word_text_offset;
+    };
+
+    struct Posting{
+        // Position in the document columns
+        std::uint32_t document_index;
+        std::uint32_t term_count;
+    };
+
+    // Throws std::runtime_error if the file cannot be read and
+    // std::invalid_argument if its header or section bounds are invalid
+    explicit MappedIndex(const std::string &path);
+
+    // Writes the index at the current position of output, which must be
+    // seekable: the header is rewritten once the section offsets are known.
+    // Offsets count from that position, so the file to map must start there.
+    // Throws std::runtime_error on write errors.
+    static void Write(const SearchServer &search_server, std::ostream &output);
+
+    int GetDocumentCount() const{return static_cast<int>(header_->document_count);}
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const{
+        const QueryWords words = ParseQueryWords(raw_query, stop_words_);
+        // Ordered by document index, which is the order of ids
+        std::map<std::uint32_t, double> document_to_relevance;
+        for (std::string_view word : words.plus_words){
+            const TermId term = FindTerm(word);
+            if (term == NO_TERM){
+                continue;
+            }
+            const auto [first, last] = GetPostings(term);
+            const double inverse_document_freq = std::log(GetDocumentCount() * 1.0 / (last - first));
+            for (const Posting *posting = first; posting != last; ++posting){
+                const std::uint32_t index = CheckDocumentIndex(posting->document_index);
+                if (document_predicate(document_ids_[index], static_cast<DocumentStatus>(document_statuses_[index]),
+                                       document_ratings_[index])){
+                    const double term_freq = posting->term_count * (1.0 / document_word_counts_[index]);
+                    document_to_relevance[index] += term_freq * inverse_document_freq;
+                }
+            }
+        }
+        for (std::string_view word : words.minus_words){
+            const TermId term = FindTerm(word);
+            if (term == NO_TERM){
+                continue;
+            }
+            const auto [first, last] = GetPostings(term);
+            for (const Posting *posting = first; posting != last; ++posting){
+                document_to_relevance.erase(posting->document_index);
+            }
+        }
+
+        std::vector<Document> matched_documents;
+        matched_documents.reserve(document_to_relevance.size());
+        for (const auto [index, relevance] : document_to_relevance){
+            matched_documents.push_back({document_ids_[index], relevance, document_ratings_[index]});
+        }
+        std::sort(matched_documents.begin(), matched_documents.end(), HasHigherRank);
+        if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT){
+            matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+        }
+        return matched_documents;
+    }
+
+    // Throws std::out_of_range for unknown documents
+    SearchServer::MatchedDoc MatchDocument(std::string_view raw_query, int document_id) const;
+
+private:
+    MappedFile file_;
+    const Header *header_ = nullptr;
+    const TermId *term_slots_ = nullptr;
+    const std::uint64_t *term_hashes_ = nullptr;
+    const std::uint64_t *term_text_offsets_ = nullptr;
+    const char *term_text_ = nullptr;
+    const std::uint64_t *posting_offsets_ = nullptr;
+    const Posting *postings_ = nullptr;
+    const std::int32_t *document_ids_ = nullptr;
+    const std::int32_t *document_ratings_ = nullptr;
+    const std::int32_t *document_statuses_ = nullptr;
+    const std::uint32_t *document_word_counts_ = nullptr;
+    const std::uint64_t *forward_offsets_ = nullptr;
+    const ForwardEntry *forward_entries_ = nullptr;
+    StopWordSet stop_words_;
+
+    // Accessors below validate what they read from the file
+    std::string_view GetTerm(TermId term) const;
+    std::pair<const Posting*, const Posting*> GetPostings(TermId term) const;
+    std::uint32_t CheckDocumentIndex(std::uint32_t index) const{
+        if (index >= header_->document_count){
+            throw std::invalid_argument("Mapped index posting is corrupted");
+        }
+        return index;
+    }
+    TermId FindTerm(std::string_view word) const;
+};
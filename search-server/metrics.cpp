@@ -0,0 +1,240 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include "metrics.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+int FloorLog2(std::uint64_t value){
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(value);
+#else
+    int result = 0;
+    while (value >>= 1){
+        ++result;
+    }
+    return result;
+#endif
+}
+
+// Only the owning thread writes a shard, a relaxed load and store is enough
+void Increase(std::atomic<std::uint64_t> &cell, std::uint64_t value){
+    cell.store(cell.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+} // namespace
+
+std::size_t HistogramSnapshot::GetBucket(std::uint64_t value){
+    if (value < LINEAR_BUCKETS){
+        return static_cast<std::size_t>(value);
+    }
+    const std::size_t exponent = FloorLog2(value);
+    if (exponent > MAX_EXPONENT){
+        return BUCKET_COUNT - 1;
+    }
+    const std::size_t sub_bucket = (value >> (exponent - SUB_BUCKET_BITS)) & ((1u << SUB_BUCKET_BITS) - 1);
+    return LINEAR_BUCKETS + ((exponent - 4) << SUB_BUCKET_BITS) + sub_bucket;
+}
+
+std::uint64_t HistogramSnapshot::GetBucketLow(std::size_t bucket){
+    if (bucket < LINEAR_BUCKETS){
+        return bucket;
+    }
+    const std::size_t exponent = ((bucket - LINEAR_BUCKETS) >> SUB_BUCKET_BITS) + 4;
+    const std::uint64_t sub_bucket = (bucket - LINEAR_BUCKETS) & ((1u << SUB_BUCKET_BITS) - 1);
+    return ((std::uint64_t{1} << SUB_BUCKET_BITS) + sub_bucket) << (exponent - SUB_BUCKET_BITS);
+}
+
+std::uint64_t HistogramSnapshot::GetBucketHigh(std::size_t bucket){
+    if (bucket < LINEAR_BUCKETS){
+        return bucket;
+    }
+    if (bucket == BUCKET_COUNT - 1){
+        return UINT64_MAX;
+    }
+    return GetBucketLow(bucket + 1) - 1;
+}
+
+std::uint64_t HistogramSnapshot::GetPercentile(double percent) const{
+    if (count == 0){
+        return 0;
+    }
+    const auto rank = std::clamp<std::uint64_t>(static_cast<std::uint64_t>(std::ceil(percent / 100 * count)), 1, count);
+    std::uint64_t seen = 0;
+    for (std::size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket){
+        seen += buckets[bucket];
+        if (seen >= rank){
+            return std::min(GetBucketHigh(bucket), max);
+        }
+    }
+    return max;
+}
+
+void HistogramSnapshot::Add(std::uint64_t value){
+    ++count;
+    sum += value;
+    max = std::max(max, value);
+    ++buckets[GetBucket(value)];
+}
+
+void HistogramSnapshot::Merge(const HistogramSnapshot &other){
+    count += other.count;
+    sum += other.sum;
+    max = std::max(max, other.max);
+    for (std::size_t bucket = 0; bucket < BUCKET_COUNT; ++bucket){
+        buckets[bucket] += other.buckets[bucket];
+    }
+}
+
+class MetricsRegistry::ShardOwner{
+public:
+    explicit ShardOwner(MetricsRegistry &registry)
+        : registry_(registry),
+        shard_(new Shard()){
+        const std::lock_guard guard(registry_.mutex_);
+        registry_.shards_.push_back(shard_);
+    }
+
+    ~ShardOwner(){
+        registry_.Retire(shard_);
+    }
+
+    Shard &GetShard(){return *shard_;}
+
+private:
+    MetricsRegistry &registry_;
+    Shard *shard_;
+};
+
+MetricsRegistry &MetricsRegistry::Instance(){
+    // Never destroyed, threads may still retire their shards during exit
+    static MetricsRegistry *registry = new MetricsRegistry();
+    return *registry;
+}
+
+CounterId MetricsRegistry::GetCounter(std::string_view name){
+    thread_local std::map<std::string, CounterId, std::less<>> cache;
+    if (const auto it = cache.find(name); it != cache.end()){
+        return it->second;
+    }
+    const std::lock_guard guard(mutex_);
+    auto it = counter_ids_.find(name);
+    if (it == counter_ids_.end()){
+        if (counter_names_.size() == MAX_COUNTERS){
+            throw std::out_of_range("Too many counters"s);
+        }
+        it = counter_ids_.emplace(std::string{name}, static_cast<CounterId>(counter_names_.size())).first;
+        counter_names_.emplace_back(name);
+    }
+    cache.emplace(it->first, it->second);
+    return it->second;
+}
+
+HistogramId MetricsRegistry::GetHistogram(std::string_view name){
+    thread_local std::map<std::string, HistogramId, std::less<>> cache;
+    if (const auto it = cache.find(name); it != cache.end()){
+        return it->second;
+    }
+    const std::lock_guard guard(mutex_);
+    auto it = histogram_ids_.find(name);
+    if (it == histogram_ids_.end()){
+        if (histogram_names_.size() == MAX_HISTOGRAMS){
+            throw std::out_of_range("Too many histograms"s);
+        }
+        it = histogram_ids_.emplace(std::string{name}, static_cast<HistogramId>(histogram_names_.size())).first;
+        histogram_names_.emplace_back(name);
+    }
+    cache.emplace(it->first, it->second);
+    return it->second;
+}
+
+void MetricsRegistry::Add(CounterId counter, std::uint64_t value){
+    Increase(GetThreadShard().counters[counter], value);
+}
+
+void MetricsRegistry::Record(HistogramId histogram, std::uint64_t value){
+    HistogramCells &cells = GetThreadShard().histograms[histogram];
+    Increase(cells.count, 1);
+    Increase(cells.sum, value);
+    Increase(cells.buckets[HistogramSnapshot::GetBucket(value)], 1);
+    if (value > cells.max.load(std::memory_order_relaxed)){
+        cells.max.store(value, std::memory_order_relaxed);
+    }
+}
+
+MetricsSnapshot MetricsRegistry::GetSnapshot() const{
+    MetricsSnapshot snapshot;
+    const std::lock_guard guard(mutex_);
+    for (const std::string &name : counter_names_){
+        snapshot.counters[name] = 0;
+    }
+    for (const std::string &name : histogram_names_){
+        snapshot.histograms[name];
+    }
+    AddShard(retired_, snapshot, *this);
+    for (const Shard *shard : shards_){
+        AddShard(*shard, snapshot, *this);
+    }
+    return snapshot;
+}
+
+MetricsRegistry::Shard &MetricsRegistry::GetThreadShard(){
+    thread_local ShardOwner owner(*this);
+    return owner.GetShard();
+}
+
+void MetricsRegistry::Retire(Shard *shard){
+    {
+        const std::lock_guard guard(mutex_);
+        for (std::size_t i = 0; i < MAX_COUNTERS; ++i){
+            Increase(retired_.counters[i], shard->counters[i].load(std::memory_order_relaxed));
+        }
+        for (std::size_t i = 0; i < MAX_HISTOGRAMS; ++i){
+            HistogramCells &target = retired_.histograms[i];
+            const HistogramCells &source = shard->histograms[i];
+            Increase(target.count, source.count.load(std::memory_order_relaxed));
+            Increase(target.sum, source.sum.load(std::memory_order_relaxed));
+            target.max.store(std::max(target.max.load(std::memory_order_relaxed),
+                                      source.max.load(std::memory_order_relaxed)), std::memory_order_relaxed);
+            for (std::size_t bucket = 0; bucket < HistogramSnapshot::BUCKET_COUNT; ++bucket){
+                Increase(target.buckets[bucket], source.buckets[bucket].load(std::memory_order_relaxed));
+            }
+        }
+        shards_.erase(std::find(shards_.begin(), shards_.end(), shard));
+    }
+    delete shard;
+}
+
+void MetricsRegistry::AddShard(const Shard &shard, MetricsSnapshot &snapshot, const MetricsRegistry &registry){
+    for (std::size_t i = 0; i < registry.counter_names_.size(); ++i){
+        snapshot.counters[registry.counter_names_[i]] += shard.counters[i].load(std::memory_order_relaxed);
+    }
+    for (std::size_t i = 0; i < registry.histogram_names_.size(); ++i){
+        HistogramSnapshot &target = snapshot.histograms[registry.histogram_names_[i]];
+        const HistogramCells &source = shard.histograms[i];
+        target.count += source.count.load(std::memory_order_relaxed);
+        target.sum += source.sum.load(std::memory_order_relaxed);
+        target.max = std::max(target.max, source.max.load(std::memory_order_relaxed));
+        for (std::size_t bucket = 0; bucket < HistogramSnapshot::BUCKET_COUNT; ++bucket){
+            target.buckets[bucket] += source.buckets[bucket].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+const QueryStageMetrics &GetQueryStageMetrics(){
+    static const QueryStageMetrics metrics = []{
+        MetricsRegistry &registry = MetricsRegistry::Instance();
+        return QueryStageMetrics{
+            registry.GetHistogram("search.parse_ns"),
+            registry.GetHistogram("search.term_lookup_ns"),
+            registry.GetHistogram("search.accumulation_ns"),
+            registry.GetHistogram("search.minus_filtering_ns"),
+            registry.GetHistogram("search.top_k_ns"),
+            registry.GetHistogram("search.result_building_ns"),
+            registry.GetCounter("search.queries"),
+        };
+    }();
+    return metrics;
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "log_duration.h"
+
+using CounterId = std::uint32_t;
+using HistogramId = std::uint32_t;
+
+// Log-linear latency histogram in the spirit of HDR histograms: values
+// below 16 get exact buckets, larger ones 8 buckets per power of two,
+// so every recorded value is known within 12.5%.
+struct HistogramSnapshot{
+    static constexpr std::size_t LINEAR_BUCKETS = 16;
+    static constexpr std::size_t SUB_BUCKET_BITS = 3;
+    static constexpr std::size_t MAX_EXPONENT = 47;
+    static constexpr std::size_t BUCKET_COUNT =
+        LINEAR_BUCKETS + (MAX_EXPONENT - 3) * (std::size_t{1} << SUB_BUCKET_BITS);
+
+    std::uint64_t count = 0;
+    std::uint64_t sum = 0;
+    std::uint64_t max = 0;
+    std::array<std::uint64_t, BUCKET_COUNT> buckets{};
+
+    static std::size_t GetBucket(std::uint64_t value);
+    // Smallest and largest value counted in a bucket
+    static std::uint64_t GetBucketLow(std::size_t bucket);
+    static std::uint64_t GetBucketHigh(std::size_t bucket);
+
+    // Upper bound of the bucket holding the given percentile, 0 when empty
+    std::uint64_t GetPercentile(double percent) const;
+    double GetMean() const{return count == 0 ? 0 : static_cast<double>(sum) / count;}
+
+    // For histograms filled outside the registry, like one per worker thread
+    void Add(std::uint64_t value);
+    void Merge(const HistogramSnapshot &other);
+};
+
+struct MetricsSnapshot{
+    std::map<std::string, std::uint64_t> counters;
+    std::map<std::string, HistogramSnapshot> histograms;
+};
+
+// Process-wide registry of named counters and latency histograms.
+// Each thread writes to its own shard with plain relaxed stores, so
+// recording takes no locks and no contended cache lines; GetSnapshot
+// sums the shards of live threads and of finished ones.
+class MetricsRegistry{
+public:
+    static constexpr std::size_t MAX_COUNTERS = 128;
+    static constexpr std::size_t MAX_HISTOGRAMS = 32;
+
+    static MetricsRegistry &Instance();
+
+    // Return the id of the metric, registering it on first use.
+    // Throw std::out_of_range when the registry is full.
+    CounterId GetCounter(std::string_view name);
+    HistogramId GetHistogram(std::string_view name);
+
+    void Add(CounterId counter, std::uint64_t value = 1);
+    void Record(HistogramId histogram, std::uint64_t value);
+
+    MetricsSnapshot GetSnapshot() const;
+
+    MetricsRegistry(const MetricsRegistry&) = delete;
+    MetricsRegistry &operator=(const MetricsRegistry&) = delete;
+
+private:
+    struct HistogramCells{
+        std::atomic<std::uint64_t> count;
+        std::atomic<std::uint64_t> sum;
+        std::atomic<std::uint64_t> max;
+        std::array<std::atomic<std::uint64_t>, HistogramSnapshot::BUCKET_COUNT> buckets;
+    };
+
+    struct Shard{
+        std::array<std::atomic<std::uint64_t>, MAX_COUNTERS> counters;
+        std::array<HistogramCells, MAX_HISTOGRAMS> histograms;
+    };
+
+    // Owns the shard of one thread and retires it when the thread ends
+    class ShardOwner;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, CounterId, std::less<>> counter_ids_;
+    std::map<std::string, HistogramId, std::less<>> histogram_ids_;
+    std::vector<std::string> counter_names_;
+    std::vector<std::string> histogram_names_;
+    std::vector<Shard*> shards_;
+    // Totals of the threads that have ended
+    Shard retired_{};
+
+    MetricsRegistry() = default;
+
+    Shard &GetThreadShard();
+    void Retire(Shard *shard);
+    static void AddShard(const Shard &shard, MetricsSnapshot &snapshot, const MetricsRegistry &registry);
+};
+
+// Records the time from construction to destruction, or to Finish, into
+// a histogram with nanosecond resolution, and into elapsed_ns if given
+class ScopedLatency{
+public:
+    explicit ScopedLatency(HistogramId histogram, std::uint64_t *elapsed_ns = nullptr)
+        : histogram_(histogram),
+        elapsed_ns_(elapsed_ns){
+    }
+
+    ~ScopedLatency(){
+        Finish();
+    }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency &operator=(const ScopedLatency&) = delete;
+
+    void Finish(){
+        if (!is_finished_){
+            is_finished_ = true;
+            const auto duration = std::chrono::steady_clock::now() - start_time_;
+            const std::uint64_t nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+            MetricsRegistry::Instance().Record(histogram_, nanoseconds);
+            if (elapsed_ns_ != nullptr){
+                *elapsed_ns_ = nanoseconds;
+            }
+        }
+    }
+
+private:
+    HistogramId histogram_;
+    std::uint64_t *elapsed_ns_;
+    bool is_finished_ = false;
+    std::chrono::steady_clock::time_point start_time_ = std::chrono::steady_clock::now();
+};
+
+// Drop-in for LOG_DURATION(x) that records into the histogram named x
+// instead of printing
+#define RECORD_DURATION(x) ScopedLatency UNIQUE_VAR_NAME_PROFILE(MetricsRegistry::Instance().GetHistogram(x))
+
+// Histograms of the stages of FindTopDocuments, its batch form and pages,
+// in nanoseconds. MatchDocument, CompileQuery and ExplainQuery parse
+// queries too but are not recorded here.
+struct QueryStageMetrics{
+    HistogramId parse;
+    HistogramId term_lookup;
+    HistogramId accumulation;
+    HistogramId minus_filtering;
+    HistogramId top_k;
+    HistogramId result_building;
+    CounterId queries;
+};
+
+const QueryStageMetrics &GetQueryStageMetrics();
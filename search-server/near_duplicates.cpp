@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+#include "hashing.h"
+#include "near_duplicates.h"
+
+namespace {
+
+struct DocumentTerms{
+    int document_id;
+    const ForwardEntry *first;
+    const ForwardEntry *last;
+};
+
+double ComputeJaccard(const DocumentTerms &lhs, const DocumentTerms &rhs){
+    std::size_t common = 0;
+    const ForwardEntry *left = lhs.first;
+    const ForwardEntry *right = rhs.first;
+    while (left != lhs.last && right != rhs.last){
+        if (left->term < right->term){
+            ++left;
+        }else if (right->term < left->term){
+            ++right;
+        }else{
+            ++common;
+            ++left;
+            ++right;
+        }
+    }
+    const std::size_t total = (lhs.last - lhs.first) + (rhs.last - rhs.first) - common;
+    return static_cast<double>(common) / total;
+}
+
+class DisjointSets{
+public:
+    explicit DisjointSets(std::size_t size)
+        : parents_(size){
+        std::iota(parents_.begin(), parents_.end(), 0);
+    }
+
+    std::size_t Find(std::size_t item){
+        while (parents_[item] != item){
+            parents_[item] = parents_[parents_[item]];
+            item = parents_[item];
+        }
+        return item;
+    }
+
+    void Unite(std::size_t lhs, std::size_t rhs){
+        lhs = Find(lhs);
+        rhs = Find(rhs);
+        // The smaller index, i.e. the smaller document id, becomes the root
+        if (lhs != rhs){
+            parents_[std::max(lhs, rhs)] = std::min(lhs, rhs);
+        }
+    }
+
+private:
+    std::vector<std::size_t> parents_;
+};
+
+template <typename Policy>
+std::vector<std::vector<int>> FindNearDuplicatesImpl(Policy policy, const SearchServer &search_server,
+                                                     const NearDuplicateOptions &options){
+    if (options.band_count <= 0 || options.rows_per_band <= 0){
+        throw std::invalid_argument("Invalid LSH band layout");
+    }
+    const std::size_t band_count = options.band_count;
+    const std::size_t rows_per_band = options.rows_per_band;
+    const std::size_t signature_size = band_count * rows_per_band;
+
+    std::vector<DocumentTerms> documents;
+    documents.reserve(search_server.GetDocumentCount());
+    for (int document_id : search_server){
+        const auto entries = search_server.GetWordFrequencies(document_id);
+        if (!entries.empty()){
+            documents.push_back({document_id, entries.data(), entries.data() + entries.size()});
+        }
+    }
+    std::sort(documents.begin(), documents.end(), [](const DocumentTerms &lhs, const DocumentTerms &rhs){
+        return lhs.document_id < rhs.document_id;
+    });
+
+    // Row i of a signature is the minimum of the i-th hash function over the document's terms
+    std::vector<std::uint64_t> signatures(documents.size() * signature_size);
+    std::vector<std::size_t> indexes(documents.size());
+    std::iota(indexes.begin(), indexes.end(), 0);
+    std::for_each(policy, indexes.begin(), indexes.end(), [&](std::size_t index){
+        std::uint64_t *signature = signatures.data() + index * signature_size;
+        std::fill(signature, signature + signature_size, UINT64_MAX);
+        for (const ForwardEntry *entry = documents[index].first; entry != documents[index].last; ++entry){
+            const std::uint64_t term_hash = MixHash(entry->term);
+            for (std::size_t row = 0; row < signature_size; ++row){
+                signature[row] = std::min(signature[row], MixHash(term_hash + row * 0x9E3779B97F4A7C15ULL));
+            }
+        }
+    });
+
+    // Documents sharing a band bucket are compared with the first and the
+    // previous document of the bucket, which keeps large buckets linear
+    std::vector<std::size_t> bands(band_count);
+    std::iota(bands.begin(), bands.end(), 0);
+    std::vector<std::vector<std::pair<std::size_t, std::size_t>>> band_candidates(band_count);
+    std::for_each(policy, bands.begin(), bands.end(), [&](std::size_t band){
+        std::vector<std::pair<std::uint64_t, std::size_t>> buckets(documents.size());
+        for (std::size_t index = 0; index < documents.size(); ++index){
+            const std::uint64_t *rows = signatures.data() + index * signature_size + band * rows_per_band;
+            std::uint64_t key = band;
+            for (std::size_t row = 0; row < rows_per_band; ++row){
+                key = MixHash(key ^ rows[row]);
+            }
+            buckets[index] = {key, index};
+        }
+        std::sort(buckets.begin(), buckets.end());
+        auto &candidates = band_candidates[band];
+        for (std::size_t first = 0, i = 1; i < buckets.size(); ++i){
+            if (buckets[i].first != buckets[first].first){
+                first = i;
+                continue;
+            }
+            candidates.emplace_back(buckets[first].second, buckets[i].second);
+            if (i - 1 != first){
+                candidates.emplace_back(buckets[i - 1].second, buckets[i].second);
+            }
+        }
+    });
+
+    std::vector<std::pair<std::size_t, std::size_t>> candidates;
+    for (const auto &band : band_candidates){
+        candidates.insert(candidates.end(), band.begin(), band.end());
+    }
+    std::sort(candidates.begin(), candidates.end());
+    candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+    std::vector<char> is_similar(candidates.size());
+    std::transform(policy, candidates.begin(), candidates.end(), is_similar.begin(),
+                   [&](const std::pair<std::size_t, std::size_t> &candidate){
+        return ComputeJaccard(documents[candidate.first], documents[candidate.second]) >= options.min_similarity;
+    });
+
+    DisjointSets clusters(documents.size());
+    for (std::size_t i = 0; i < candidates.size(); ++i){
+        if (is_similar[i]){
+            clusters.Unite(candidates[i].first, candidates[i].second);
+        }
+    }
+    std::vector<std::vector<int>> groups(documents.size());
+    for (std::size_t index = 0; index < documents.size(); ++index){
+        groups[clusters.Find(index)].push_back(documents[index].document_id);
+    }
+    std::vector<std::vector<int>> result;
+    for (auto &group : groups){
+        if (group.size() > 1){
+            result.push_back(std::move(group));
+        }
+    }
+    return result;
+}
+
+} // namespace
+
+std::vector<std::vector<int>> FindNearDuplicates(const SearchServer &search_server,
+                                                 const NearDuplicateOptions &options){
+    return FindNearDuplicatesImpl(std::execution::seq, search_server, options);
+}
+
+std::vector<std::vector<int>> FindNearDuplicates(const std::execution::sequenced_policy&,
+                                                 const SearchServer &search_server,
+                                                 const NearDuplicateOptions &options){
+    return FindNearDuplicatesImpl(std::execution::seq, search_server, options);
+}
+
+std::vector<std::vector<int>> FindNearDuplicates(const std::execution::parallel_policy&,
+                                                 const SearchServer &search_server,
+                                                 const NearDuplicateOptions &options){
+    return FindNearDuplicatesImpl(std::execution::par, search_server, options);
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <execution>
+#include <vector>
+#include "search_server.h"
+
+struct NearDuplicateOptions{
+    // The MinHash signature has band_count * rows_per_band values. Two documents
+    // become candidates when all rows of at least one band agree, which is likely
+    // above a Jaccard similarity of about (1 / band_count) ^ (1 / rows_per_band).
+    int band_count = 16;
+    int rows_per_band = 4;
+    // Candidates are confirmed by the exact Jaccard similarity of their word sets
+    double min_similarity = 0.8;
+};
+
+// Clusters of documents whose sets of words are similar, each cluster sorted by
+// id and of two documents or more, clusters ordered by their smallest id.
+// Documents without words are skipped. Runs in about O(N) for N documents:
+// MinHash signatures are bucketed with locality sensitive hashing and only
+// documents sharing a bucket are compared.
+std::vector<std::vector<int>> FindNearDuplicates(const SearchServer &search_server,
+                                                 const NearDuplicateOptions &options = {});
+std::vector<std::vector<int>> FindNearDuplicates(const std::execution::sequenced_policy&,
+                                                 const SearchServer &search_server,
+                                                 const NearDuplicateOptions &options = {});
+std::vector<std::vector<int>> FindNearDuplicates(const std::execution::parallel_policy&,
+                                                 const SearchServer &search_server,
+                                                 const NearDuplicateOptions &options = {});
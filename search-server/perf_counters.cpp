@@ -0,0 +1,127 @@
+#include <cstdint>
+#include "perf_counters.h"
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+#if defined(__linux__)
+
+struct EventConfig{
+    std::uint32_t type;
+    std::uint64_t config;
+};
+
+constexpr std::array<EventConfig, PERF_EVENT_COUNT> EVENT_CONFIGS{{
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                         | (PERF_COUNT_HW_CACHE_RESULT_ACCESS << 16)},
+}};
+
+// Layout of read() with TOTAL_TIME_ENABLED and TOTAL_TIME_RUNNING
+struct CounterValue{
+    std::uint64_t value;
+    std::uint64_t time_enabled;
+    std::uint64_t time_running;
+};
+
+int OpenCounter(const EventConfig &event){
+    perf_event_attr attributes{};
+    attributes.size = sizeof(attributes);
+    attributes.type = event.type;
+    attributes.config = event.config;
+    attributes.disabled = 1;
+    // Allowed up to perf_event_paranoid 2 and keeps syscalls out of the numbers
+    attributes.exclude_kernel = 1;
+    attributes.exclude_hv = 1;
+    attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+}
+
+#endif
+
+} // namespace
+
+PerfCounters::PerfCounters(){
+    fds_.fill(-1);
+#if defined(__linux__)
+    for (std::size_t i = 0; i < PERF_EVENT_COUNT; ++i){
+        fds_[i] = OpenCounter(EVENT_CONFIGS[i]);
+    }
+#endif
+}
+
+PerfCounters::~PerfCounters(){
+#if defined(__linux__)
+    for (int fd : fds_){
+        if (fd >= 0){
+            close(fd);
+        }
+    }
+#endif
+}
+
+bool PerfCounters::IsAvailable() const{
+    for (int fd : fds_){
+        if (fd >= 0){
+            return true;
+        }
+    }
+    return false;
+}
+
+void PerfCounters::Start(){
+#if defined(__linux__)
+    for (int fd : fds_){
+        if (fd >= 0){
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+PerfReading PerfCounters::Stop(){
+    PerfReading reading;
+#if defined(__linux__)
+    for (int fd : fds_){
+        if (fd >= 0){
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (std::size_t i = 0; i < PERF_EVENT_COUNT; ++i){
+        CounterValue counter{};
+        if (fds_[i] < 0 || read(fds_[i], &counter, sizeof(counter)) != sizeof(counter)
+            || counter.time_running == 0){
+            continue;
+        }
+        reading.values[i] = static_cast<double>(counter.value) * counter.time_enabled / counter.time_running;
+        reading.is_counted[i] = true;
+    }
+#endif
+    return reading;
+}
+
+const char *PerfCounters::GetName(PerfEvent event){
+    switch (event){
+    case PerfEvent::CYCLES:
+        return "cycles";
+    case PerfEvent::INSTRUCTIONS:
+        return "instructions";
+    case PerfEvent::CACHE_MISSES:
+        return "cache_misses";
+    case PerfEvent::BRANCH_MISSES:
+        return "branch_misses";
+    case PerfEvent::LLC_LOADS:
+        return "llc_loads";
+    }
+    return "unknown";
+}
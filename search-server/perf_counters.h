@@ -0,0 +1,52 @@
+#pragma once
+#include <array>
+#include <cstddef>
+
+// Hardware events counted around benchmark regions
+enum class PerfEvent{
+    CYCLES,
+    INSTRUCTIONS,
+    CACHE_MISSES,
+    BRANCH_MISSES,
+    LLC_LOADS,
+};
+
+constexpr std::size_t PERF_EVENT_COUNT = 5;
+
+struct PerfReading{
+    // Counts scaled up for the time the kernel multiplexed the counter out
+    std::array<double, PERF_EVENT_COUNT> values{};
+    // False for events that could not be opened or never got scheduled
+    std::array<bool, PERF_EVENT_COUNT> is_counted{};
+
+    double Get(PerfEvent event) const{return values[static_cast<std::size_t>(event)];}
+    bool IsCounted(PerfEvent event) const{return is_counted[static_cast<std::size_t>(event)];}
+};
+
+// Thin wrapper over Linux perf_event_open counting user-space events of the
+// calling thread. Work that parallel algorithms hand to other threads is not
+// counted. Events the kernel refuses (no PMU in a VM or container,
+// perf_event_paranoid, other systems) are skipped: IsAvailable tells whether
+// anything is counted at all and Stop marks the missing events.
+class PerfCounters{
+public:
+    PerfCounters();
+    ~PerfCounters();
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters &operator=(const PerfCounters&) = delete;
+
+    bool IsAvailable() const;
+    bool IsAvailable(PerfEvent event) const{return fds_[static_cast<std::size_t>(event)] >= 0;}
+
+    // Resets and enables the counters
+    void Start();
+    // Disables the counters and returns the counts since Start
+    PerfReading Stop();
+
+    // Short snake_case name for reports, like "llc_loads"
+    static const char *GetName(PerfEvent event);
+
+private:
+    std::array<int, PERF_EVENT_COUNT> fds_;
+};
@@ -7,11 +7,8 @@
         const SearchServer &search_server,
         const std::vector<std::string> &queries)
     {
-        std::vector<std::vector<Document>> result(queries.size());
-        std::transform(std::execution::par, queries.begin(),
-                    queries.end(), result.begin(), [&search_server](const std::string &s)
-                    { return search_server.FindTopDocuments(s); });
-        return result;
+        // Shared scan: queries with common terms walk their posting lists once
+        return search_server.FindTopDocumentsBatch(std::execution::par, queries);
     }
 
     std::vector<Document> ProcessQueriesJoined(
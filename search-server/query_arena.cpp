@@ -0,0 +1,43 @@
+#include <cstddef>
+#include <memory>
+#include "query_arena.h"
+
+namespace {
+
+// Most queries fit in the initial buffer
+constexpr std::size_t INITIAL_BUFFER_SIZE = 64 * 1024;
+
+struct ThreadArena{
+    ThreadArena()
+        : buffer(std::make_unique<std::byte[]>(INITIAL_BUFFER_SIZE)),
+        // Buffers of larger queries come from a pool that keeps them after
+        // the release, so the thread stops calling the global allocator
+        pool(std::pmr::pool_options{0, std::size_t{1} << 22}),
+        resource(buffer.get(), INITIAL_BUFFER_SIZE, &pool){
+    }
+
+    std::unique_ptr<std::byte[]> buffer;
+    std::pmr::unsynchronized_pool_resource pool;
+    std::pmr::monotonic_buffer_resource resource;
+    int depth = 0;
+};
+
+ThreadArena &GetThreadArena(){
+    thread_local ThreadArena arena;
+    return arena;
+}
+
+} // namespace
+
+QueryArena::QueryArena(){
+    ThreadArena &arena = GetThreadArena();
+    ++arena.depth;
+    resource_ = &arena.resource;
+}
+
+QueryArena::~QueryArena(){
+    ThreadArena &arena = GetThreadArena();
+    if (--arena.depth == 0){
+        arena.resource.release();
+    }
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <memory_resource>
+
+// Arena for the temporaries of one query. Every thread owns a monotonic
+// buffer that all its queries reuse: allocation is a pointer bump without
+// locks, and the outermost QueryArena of a thread releases everything at
+// once when it ends. Nested scopes (a query that runs another) share it.
+// Nothing allocated from the arena may outlive the scope.
+class QueryArena{
+public:
+    QueryArena();
+    ~QueryArena();
+
+    QueryArena(const QueryArena&) = delete;
+    QueryArena &operator=(const QueryArena&) = delete;
+
+    std::pmr::memory_resource *GetResource() const{return resource_;}
+
+private:
+    std::pmr::memory_resource *resource_;
+};
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "mapped_file.h"
+#include "query_log.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+constexpr char LOG_MAGIC[8] = {'S', 'R', 'C', 'H', 'Q', 'L', 'G', '1'};
+constexpr std::size_t HEADER_SIZE = sizeof(LOG_MAGIC) + sizeof(std::int64_t);
+// Buffered bytes that trigger a write
+constexpr std::size_t FLUSH_SIZE = 64 * 1024;
+
+// LEB128: seven bits per byte, the high bit marks a continuation
+void AppendVarint(std::string &output, std::uint64_t value){
+    while (value >= 0x80){
+        output.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    output.push_back(static_cast<char>(value));
+}
+
+bool ReadVarint(std::string_view &input, std::uint64_t &value){
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7){
+        if (input.empty()){
+            return false;
+        }
+        const auto byte = static_cast<unsigned char>(input.front());
+        input.remove_prefix(1);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0){
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+QueryLogWriter::QueryLogWriter(const std::string &path)
+    : file_(std::fopen(path.c_str(), "wb")){
+    if (file_ == nullptr){
+        throw std::runtime_error("Cannot create query log "s + path);
+    }
+    const std::int64_t start_time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    buffer_.append(LOG_MAGIC, sizeof(LOG_MAGIC));
+    buffer_.append(reinterpret_cast<const char*>(&start_time_ns), sizeof(start_time_ns));
+    // A log cut short before its first flush is still a log
+    try{
+        FlushBuffer();
+    }catch (const std::exception&){
+        std::fclose(file_);
+        throw;
+    }
+}
+
+QueryLogWriter::~QueryLogWriter(){
+    try{
+        Flush();
+    }catch (const std::exception&){
+    }
+    std::fclose(file_);
+}
+
+void QueryLogWriter::Record(std::string_view raw_query, DocumentStatus status){
+    const auto now = std::chrono::steady_clock::now();
+    const std::lock_guard guard(mutex_);
+    // Taken under the lock, so the times never go back
+    const std::uint64_t time_ns = std::max<std::uint64_t>(last_time_ns_,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_time_).count());
+    AppendVarint(buffer_, time_ns - last_time_ns_);
+    buffer_.push_back(static_cast<char>(status));
+    AppendVarint(buffer_, raw_query.size());
+    buffer_.append(raw_query);
+    last_time_ns_ = time_ns;
+    ++record_count_;
+    if (buffer_.size() >= FLUSH_SIZE){
+        FlushBuffer();
+    }
+}
+
+void QueryLogWriter::Flush(){
+    const std::lock_guard guard(mutex_);
+    FlushBuffer();
+}
+
+std::size_t QueryLogWriter::GetRecordCount() const{
+    const std::lock_guard guard(mutex_);
+    return record_count_;
+}
+
+void QueryLogWriter::FlushBuffer(){
+    if (std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size() || std::fflush(file_) != 0){
+        throw std::runtime_error("Cannot write the query log"s);
+    }
+    buffer_.clear();
+}
+
+QueryLog ReadQueryLog(const std::string &path){
+    const MappedFile file(path);
+    std::string_view contents = file.GetContents();
+    if (contents.size() < HEADER_SIZE || !std::equal(LOG_MAGIC, LOG_MAGIC + sizeof(LOG_MAGIC), contents.data())){
+        throw std::invalid_argument("Not a query log: "s + path);
+    }
+    std::int64_t start_time_ns = 0;
+    std::memcpy(&start_time_ns, contents.data() + sizeof(LOG_MAGIC), sizeof(start_time_ns));
+    contents.remove_prefix(HEADER_SIZE);
+
+    QueryLog log;
+    log.start_time = std::chrono::system_clock::time_point(
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds(start_time_ns)));
+    std::uint64_t time_ns = 0;
+    while (!contents.empty()){
+        std::uint64_t delta_ns = 0;
+        std::uint64_t size = 0;
+        if (!ReadVarint(contents, delta_ns) || contents.empty()){
+            break;
+        }
+        const auto status = static_cast<unsigned char>(contents.front());
+        contents.remove_prefix(1);
+        if (status > static_cast<unsigned char>(DocumentStatus::REMOVED)){
+            throw std::invalid_argument("Damaged query log: "s + path);
+        }
+        if (!ReadVarint(contents, size) || size > contents.size()){
+            break;
+        }
+        time_ns += delta_ns;
+        log.queries.push_back({time_ns, static_cast<DocumentStatus>(status), std::string{contents.substr(0, size)}});
+        contents.remove_prefix(size);
+    }
+    return log;
+}
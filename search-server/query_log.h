@@ -0,0 +1,59 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "search_server.h"
+
+// A query as it arrived: time since the log was started, status filter, text
+struct LoggedQuery{
+    std::uint64_t time_ns = 0;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::string raw_query;
+};
+
+struct QueryLog{
+    // Wall clock time of the first record's zero
+    std::chrono::system_clock::time_point start_time;
+    std::vector<LoggedQuery> queries;
+};
+
+// Records FindTopDocuments requests into a compact binary log: a header with
+// the start time, then per query a varint time delta, the status byte, a
+// varint length and the text. Records are buffered; a log cut short by a
+// crash loses only its tail. Record is thread-safe.
+class QueryLogWriter{
+public:
+    // Creates or truncates the file. Throws std::runtime_error on I/O errors.
+    explicit QueryLogWriter(const std::string &path);
+    // Flushes, errors are ignored
+    ~QueryLogWriter();
+
+    QueryLogWriter(const QueryLogWriter&) = delete;
+    QueryLogWriter &operator=(const QueryLogWriter&) = delete;
+
+    void Record(std::string_view raw_query, DocumentStatus status);
+    // Writes the buffered records to the file
+    void Flush();
+
+    std::size_t GetRecordCount() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::FILE *file_ = nullptr;
+    std::string buffer_;
+    std::chrono::steady_clock::time_point start_time_ = std::chrono::steady_clock::now();
+    std::uint64_t last_time_ns_ = 0;
+    std::size_t record_count_ = 0;
+
+    void FlushBuffer();
+};
+
+// Reads a whole log, stopping at a truncated last record. Throws
+// std::runtime_error if the file cannot be read and std::invalid_argument
+// if it is not a query log.
+QueryLog ReadQueryLog(const std::string &path);
@@ -0,0 +1,35 @@
+#include <algorithm>
+#include <stdexcept>
+#include "query_parser.h"
+#include "string_processing.h"
+
+using namespace std::string_literals;
+
+QueryWords ParseQueryWords(std::string_view text, const StopWordSet &stop_words,
+                           std::pmr::memory_resource *resource){
+    std::pmr::vector<std::string_view> words(resource);
+    ForEachWord(text, [&words](std::string_view word, bool is_valid){
+        if (!is_valid){
+            throw std::invalid_argument("Query word is invalid"s);
+        }
+        words.push_back(word);
+    });
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    QueryWords result(resource);
+    for (std::string_view word : words){
+        const bool is_minus = word[0] == '-';
+        if (is_minus){
+            word.remove_prefix(1);
+        }
+        if (word.empty() || word[0] == '-'){
+            throw std::invalid_argument("Query word is invalid"s);
+        }
+        if (stop_words.Contains(word)){
+            continue;
+        }
+        is_minus ? result.minus_words.push_back(word) : result.plus_words.push_back(word);
+    }
+    return result;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <memory_resource>
+#include <string_view>
+#include <vector>
+#include "stop_words.h"
+
+// Words of a raw query, each list sorted and without repeats or stop words
+struct QueryWords{
+    explicit QueryWords(std::pmr::memory_resource *resource = std::pmr::get_default_resource())
+        : plus_words(resource),
+        minus_words(resource){
+    }
+
+    std::pmr::vector<std::string_view> plus_words;
+    std::pmr::vector<std::string_view> minus_words;
+};
+
+// Minus words are written as -word. Throws std::invalid_argument on words
+// with control characters, on a lone '-' and on words starting with "--".
+// All memory comes from resource.
+QueryWords ParseQueryWords(std::string_view text, const StopWordSet &stop_words,
+                           std::pmr::memory_resource *resource = std::pmr::get_default_resource());
@@ -0,0 +1,28 @@
+#include <sstream>
+#include "query_planner.h"
+
+const char *GetStrategyName(QueryStrategy strategy){
+    switch (strategy){
+    case QueryStrategy::TAAT:
+        return "TAAT";
+    case QueryStrategy::BITMAP:
+        return "BITMAP";
+    case QueryStrategy::WAND:
+        return "WAND";
+    }
+    return "UNKNOWN";
+}
+
+std::string QueryPlan::ToString() const{
+    std::ostringstream output;
+    output << GetStrategyName(strategy) << ": " << plus_postings << " plus postings, "
+           << minus_postings << " minus postings\n";
+    for (const PlannedTerm &term : terms){
+        output << "  " << (term.is_minus ? "-" : "+") << term.word << " df=" << term.document_freq;
+        if (!term.is_minus){
+            output << " idf=" << term.inverse_document_freq << " max_relevance=" << term.max_relevance;
+        }
+        output << '\n';
+    }
+    return output.str();
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// How a sequential FindTopDocuments evaluates a query
+enum class QueryStrategy{
+    // Term at a time into an ordered map, for queries matching few documents
+    TAAT,
+    // Term at a time into an array indexed by document id, with a bitmap of
+    // the matched documents, when they fill a good part of the id range
+    BITMAP,
+    // Document at a time over posting cursors: documents whose bound on the
+    // relevance cannot reach the current top are skipped
+    WAND,
+};
+
+const char *GetStrategyName(QueryStrategy strategy);
+
+struct PlannedTerm{
+    std::string_view word;
+    bool is_minus = false;
+    // Number of documents holding the term
+    std::size_t document_freq = 0;
+    double inverse_document_freq = 0;
+    // Bound of the term's contribution to a relevance, 0 for minus terms
+    double max_relevance = 0;
+};
+
+// What SearchServer::ExplainQuery reports. Terms are listed rarest first,
+// plus terms before minus terms; words unknown to the index are left out.
+struct QueryPlan{
+    QueryStrategy strategy = QueryStrategy::TAAT;
+    std::vector<PlannedTerm> terms;
+    std::size_t plus_postings = 0;
+    std::size_t minus_postings = 0;
+
+    // Multi-line text for logs and debugging
+    std::string ToString() const;
+};
@@ -0,0 +1,41 @@
+#include <stdexcept>
+#include "query_stats.h"
+
+using namespace std::string_literals;
+
+SlowQueryLog::SlowQueryLog(SlowQueryLogOptions options)
+    : options_(options){
+    if (options_.capacity == 0){
+        throw std::invalid_argument("Slow query log capacity must be positive"s);
+    }
+}
+
+bool SlowQueryLog::Record(std::string_view raw_query, const QueryStats &stats){
+    if (std::chrono::nanoseconds(stats.total_ns) < options_.threshold){
+        return false;
+    }
+    SlowQuery query{std::string{raw_query}, stats, std::chrono::system_clock::now()};
+    const std::lock_guard guard(mutex_);
+    if (queries_.size() == options_.capacity){
+        queries_.pop_front();
+    }
+    queries_.push_back(std::move(query));
+    ++slow_query_count_;
+    return true;
+}
+
+std::vector<SlowQuery> SlowQueryLog::GetQueries() const{
+    const std::lock_guard guard(mutex_);
+    return {queries_.begin(), queries_.end()};
+}
+
+std::uint64_t SlowQueryLog::GetSlowQueryCount() const{
+    const std::lock_guard guard(mutex_);
+    return slow_query_count_;
+}
+
+void SlowQueryLog::Clear(){
+    const std::lock_guard guard(mutex_);
+    queries_.clear();
+    slow_query_count_ = 0;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "query_planner.h"
+
+// What one FindTopDocuments call did, filled by the overloads taking a QueryStats
+struct QueryStats{
+    // Query words found in the index
+    std::size_t plus_terms = 0;
+    std::size_t minus_terms = 0;
+    // Postings read for plus and minus terms, WAND counts the ones its cursors stopped at
+    std::size_t postings_scanned = 0;
+    // Postings of plus terms whose document the predicate rejected, a document
+    // is counted once per term it holds
+    std::size_t postings_rejected_by_predicate = 0;
+    // Distinct documents that got a relevance
+    std::size_t documents_scored = 0;
+    std::size_t documents_removed_by_minus = 0;
+    std::size_t documents_returned = 0;
+    // Chosen by the planner, the parallel policy always runs TAAT
+    QueryStrategy strategy = QueryStrategy::TAAT;
+
+    // Stage durations in nanoseconds, parse includes the term lookup
+    std::uint64_t parse_ns = 0;
+    std::uint64_t accumulation_ns = 0;
+    std::uint64_t minus_filtering_ns = 0;
+    std::uint64_t result_building_ns = 0;
+    std::uint64_t top_k_ns = 0;
+    std::uint64_t total_ns = 0;
+};
+
+struct SlowQueryLogOptions{
+    // Queries that take at least this long are captured
+    std::chrono::nanoseconds threshold = std::chrono::milliseconds(100);
+    // Only the most recent queries are kept
+    std::size_t capacity = 256;
+};
+
+struct SlowQuery{
+    std::string raw_query;
+    QueryStats stats;
+    std::chrono::system_clock::time_point time;
+};
+
+// Keeps the latest queries over a latency threshold with their statistics.
+// Attach it with SearchServer::SetSlowQueryLog; Record is thread-safe, so one
+// log can serve parallel queries and several servers.
+class SlowQueryLog{
+public:
+    explicit SlowQueryLog(SlowQueryLogOptions options = {});
+
+    // Returns whether the query was slow enough to be kept
+    bool Record(std::string_view raw_query, const QueryStats &stats);
+
+    // Oldest first
+    std::vector<SlowQuery> GetQueries() const;
+    // Number of slow queries seen, including those pushed out by newer ones
+    std::uint64_t GetSlowQueryCount() const;
+    void Clear();
+
+private:
+    const SlowQueryLogOptions options_;
+    mutable std::mutex mutex_;
+    std::deque<SlowQuery> queries_;
+    std::uint64_t slow_query_count_ = 0;
+};
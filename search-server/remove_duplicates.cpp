@@ -0,0 +1,9 @@
+#include <iostream>
+#include "remove_duplicates.h"
+
+void RemoveDuplicates(SearchServer &search_server){
+    for (int document_id : search_server.FindDuplicates()){
+        std::cout << "Found duplicate document id " << document_id << std::endl;
+        search_server.RemoveDocument(document_id);
+    }
+}
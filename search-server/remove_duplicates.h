@@ -0,0 +1,6 @@
+#pragma once
+#include "search_server.h"
+
+// Removes every document whose set of words equals the one of a document
+// with a smaller id, reporting each removed id to std::cout
+void RemoveDuplicates(SearchServer &search_server);
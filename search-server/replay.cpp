@@ -0,0 +1,186 @@
+// Replays a query log recorded by QueryLogWriter against an index, to
+// reproduce production load on an isolated machine.
+//
+// Usage: search_server_replay log=PATH (snapshot=PATH | corpus=PATH [stop_words=a,b,c])
+//     threads=1 speed=1 format=json|csv
+//
+// speed multiplies the recorded rate: 1 keeps the original pacing, 2 sends
+// queries twice as fast, 0 as fast as the threads take them. Prints the
+// throughput and histograms of the execution time and of the delay behind
+// schedule, which shows when the workers cannot keep up with the rate.
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "corpus_loader.h"
+#include "metrics.h"
+#include "query_log.h"
+#include "search_server.h"
+#include "tool_common.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+struct ReplayOptions{
+    std::string log_path;
+    std::string snapshot_path;
+    std::string corpus_path;
+    std::string stop_words;
+    int thread_count = 1;
+    double speed = 1.0;
+    OutputFormat format = OutputFormat::JSON;
+};
+
+struct ReplayReport{
+    std::size_t query_count = 0;
+    std::size_t failed_query_count = 0;
+    std::size_t result_count = 0;
+    double seconds = 0;
+    // FindTopDocuments alone
+    HistogramSnapshot latency;
+    // Start of a query behind its scheduled time, empty at the maximum rate
+    HistogramSnapshot delay;
+};
+
+using Clock = std::chrono::steady_clock;
+
+ReplayOptions ParseOptions(int argc, char **argv){
+    ReplayOptions options;
+    ParseKeyValueOptions(argc, argv, [&options](const std::string &key, const std::string &value){
+        if (key == "log"){
+            options.log_path = value;
+        }else if (key == "snapshot"){
+            options.snapshot_path = value;
+        }else if (key == "corpus"){
+            options.corpus_path = value;
+        }else if (key == "stop_words"){
+            options.stop_words = value;
+            std::replace(options.stop_words.begin(), options.stop_words.end(), ',', ' ');
+        }else if (key == "threads"){
+            options.thread_count = std::stoi(value);
+        }else if (key == "speed"){
+            options.speed = std::stod(value);
+        }else if (key == "format"){
+            options.format = ParseOutputFormat(value);
+        }else{
+            return false;
+        }
+        return true;
+    });
+    if (options.log_path.empty() || options.snapshot_path.empty() == options.corpus_path.empty()){
+        throw std::invalid_argument("Expected log and either snapshot or corpus"s);
+    }
+    if (options.thread_count <= 0 || options.speed < 0){
+        throw std::invalid_argument("Inconsistent options"s);
+    }
+    return options;
+}
+
+SearchServer LoadIndex(const ReplayOptions &options){
+    if (!options.snapshot_path.empty()){
+        std::ifstream input(options.snapshot_path, std::ios::binary);
+        if (!input){
+            throw std::runtime_error("Cannot open snapshot "s + options.snapshot_path);
+        }
+        return SearchServer::Load(input);
+    }
+    SearchServer search_server(options.stop_words);
+    LoadCorpus(search_server, options.corpus_path);
+    return search_server;
+}
+
+// Workers take the queries in log order. A query is started no earlier
+// than its recorded time divided by speed, so a slow server falls behind
+// schedule instead of lowering the offered rate.
+ReplayReport Replay(const SearchServer &search_server, const std::vector<LoggedQuery> &queries,
+                    int thread_count, double speed){
+    struct WorkerReport{
+        std::size_t failed_query_count = 0;
+        std::size_t result_count = 0;
+        HistogramSnapshot latency;
+        HistogramSnapshot delay;
+    };
+    std::vector<WorkerReport> worker_reports(thread_count);
+    std::atomic<std::size_t> next_query{0};
+    const auto start = Clock::now();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < thread_count; ++i){
+        threads.emplace_back([&, &report = worker_reports[i]]{
+            for (std::size_t index = next_query++; index < queries.size(); index = next_query++){
+                const LoggedQuery &query = queries[index];
+                const auto scheduled = start + std::chrono::duration_cast<Clock::duration>(
+                    std::chrono::duration<double, std::nano>(speed > 0 ? query.time_ns / speed : 0));
+                if (speed > 0){
+                    std::this_thread::sleep_until(scheduled);
+                }
+                const auto query_start = Clock::now();
+                try{
+                    report.result_count += search_server.FindTopDocuments(query.raw_query, query.status).size();
+                }catch (const std::invalid_argument&){
+                    ++report.failed_query_count;
+                }
+                const auto query_end = Clock::now();
+                report.latency.Add(std::chrono::duration_cast<std::chrono::nanoseconds>(query_end - query_start).count());
+                if (speed > 0){
+                    report.delay.Add(std::chrono::duration_cast<std::chrono::nanoseconds>(query_start - scheduled).count());
+                }
+            }
+        });
+    }
+    for (std::thread &thread : threads){
+        thread.join();
+    }
+
+    ReplayReport report;
+    report.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    report.query_count = queries.size();
+    for (const WorkerReport &worker_report : worker_reports){
+        report.failed_query_count += worker_report.failed_query_count;
+        report.result_count += worker_report.result_count;
+        report.latency.Merge(worker_report.latency);
+        report.delay.Merge(worker_report.delay);
+    }
+    return report;
+}
+
+Metrics RunReplay(const ReplayOptions &options){
+    const QueryLog log = ReadQueryLog(options.log_path);
+    const SearchServer search_server = LoadIndex(options);
+
+    Metrics metrics;
+    metrics.emplace_back("config.threads", options.thread_count);
+    metrics.emplace_back("config.speed", options.speed);
+    metrics.emplace_back("index.documents", search_server.GetDocumentCount());
+    metrics.emplace_back("log.queries", log.queries.size());
+    metrics.emplace_back("log.seconds", log.queries.empty() ? 0 : log.queries.back().time_ns / 1e9);
+
+    const ReplayReport report = Replay(search_server, log.queries, options.thread_count, options.speed);
+    metrics.emplace_back("replay.seconds", report.seconds);
+    metrics.emplace_back("replay.qps", report.query_count / std::max(report.seconds, 1e-9));
+    metrics.emplace_back("replay.failed_queries", report.failed_query_count);
+    metrics.emplace_back("replay.results", report.result_count);
+    AddHistogramMetrics(metrics, "replay.latency", report.latency);
+    if (options.speed > 0){
+        AddHistogramMetrics(metrics, "replay.delay", report.delay);
+    }
+    return metrics;
+}
+
+} // namespace
+
+int main(int argc, char **argv){
+    try{
+        const ReplayOptions options = ParseOptions(argc, argv);
+        PrintMetrics(RunReplay(options), options.format);
+    }catch (const std::exception &error){
+        std::cerr << "search_server_replay: " << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
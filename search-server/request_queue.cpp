@@ -7,11 +7,19 @@
 
 void RequestQueue::AddFindRequest(const std::string &raw_query, DocumentStatus status)
 {
+    if (query_log_ != nullptr)
+    {
+        query_log_->Record(raw_query, status);
+    }
     std::vector<Document> result = search_server.FindTopDocuments(raw_query, status);
     PushDocument(result);
 }
 void RequestQueue::AddFindRequest(const std::string &raw_query)
 {
+    if (query_log_ != nullptr)
+    {
+        query_log_->Record(raw_query, DocumentStatus::ACTUAL);
+    }
     std::vector<Document> result = search_server.FindTopDocuments(raw_query);
     PushDocument(result);
 }
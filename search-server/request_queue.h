@@ -3,6 +3,7 @@
 #include <vector>
 #include <deque>
 #include "search_server.h"
+#include "query_log.h"
 
 class RequestQueue
 {
@@ -18,6 +19,13 @@ public:
 
     int GetNoResultRequests() const;
 
+    // Requests made through the public AddFindRequest are recorded into the
+    // log, which must outlive the queue; nullptr stops recording
+    void SetQueryLog(QueryLogWriter *query_log)
+    {
+        query_log_ = query_log;
+    }
+
 private:
     struct QueryResult
     {
@@ -32,6 +40,7 @@ private:
     std::deque<QueryResult> requests_;
     std::deque<QueryResult> requests_successful_;
     const SearchServer &search_server;
+    QueryLogWriter *query_log_ = nullptr;
     const static int min_in_day_ = 1440;
 
     void PushDocument(const std::vector<Document> &result);
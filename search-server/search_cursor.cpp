@@ -0,0 +1,70 @@
+#include <cstring>
+#include <stdexcept>
+#include "search_cursor.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+// The token is the hex dump of this record, relevance keeps all its bits
+struct CursorRecord{
+    std::uint64_t generation;
+    std::uint64_t query_key;
+    double relevance;
+    std::int32_t document_id;
+    std::int32_t rating;
+    std::uint32_t flags;
+    std::uint32_t reserved;
+};
+
+constexpr std::uint32_t HAS_POSITION = 1;
+constexpr std::uint32_t IS_END = 2;
+constexpr char HEX_DIGITS[] = "0123456789abcdef";
+
+int ParseHexDigit(char c){
+    if (c >= '0' && c <= '9'){
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f'){
+        return c - 'a' + 10;
+    }
+    throw std::invalid_argument("Invalid search cursor"s);
+}
+
+} // namespace
+
+std::string SearchCursor::ToString() const{
+    const CursorRecord record{generation_, query_key_, last_document_.relevance, last_document_.id, last_document_.rating,
+                              (has_position_ ? HAS_POSITION : 0) | (is_end_ ? IS_END : 0), 0};
+    char bytes[sizeof(CursorRecord)];
+    std::memcpy(bytes, &record, sizeof(record));
+    std::string token;
+    token.reserve(2 * sizeof(bytes));
+    for (unsigned char byte : bytes){
+        token.push_back(HEX_DIGITS[byte >> 4]);
+        token.push_back(HEX_DIGITS[byte & 0xF]);
+    }
+    return token;
+}
+
+SearchCursor SearchCursor::Parse(std::string_view token){
+    char bytes[sizeof(CursorRecord)];
+    if (token.size() != 2 * sizeof(bytes)){
+        throw std::invalid_argument("Invalid search cursor"s);
+    }
+    for (std::size_t i = 0; i < sizeof(bytes); ++i){
+        bytes[i] = static_cast<char>(ParseHexDigit(token[2 * i]) << 4 | ParseHexDigit(token[2 * i + 1]));
+    }
+    CursorRecord record;
+    std::memcpy(&record, bytes, sizeof(record));
+    if ((record.flags & ~(HAS_POSITION | IS_END)) != 0 || record.reserved != 0){
+        throw std::invalid_argument("Invalid search cursor"s);
+    }
+    SearchCursor cursor;
+    cursor.generation_ = record.generation;
+    cursor.query_key_ = record.query_key;
+    cursor.last_document_ = Document(record.document_id, record.relevance, record.rating);
+    cursor.has_position_ = (record.flags & HAS_POSITION) != 0;
+    cursor.is_end_ = (record.flags & IS_END) != 0;
+    return cursor;
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "document.h"
+
+// Position in the ranked results of a query for search-after pagination:
+// the rank of the last document returned, the index generation it was
+// ranked in and a hash of the query text and filter it belongs to. Default
+// constructed, it points before the first result of any query.
+class SearchCursor{
+public:
+    SearchCursor() = default;
+
+    // No documents follow the cursor
+    bool IsEnd() const{return is_end_;}
+
+    // Opaque token to hand to clients; Parse throws std::invalid_argument
+    // on a token that ToString did not produce
+    std::string ToString() const;
+    static SearchCursor Parse(std::string_view token);
+
+private:
+    friend class SearchServer;
+
+    bool has_position_ = false;
+    bool is_end_ = false;
+    Document last_document_;
+    std::uint64_t generation_ = 0;
+    std::uint64_t query_key_ = 0;
+};
+
+struct SearchPage{
+    std::vector<Document> documents;
+    // Cursor of the next page
+    SearchCursor next;
+};
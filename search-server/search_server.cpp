@@ -10,9 +10,15 @@
 #include <string_view>
 #include <numeric>
 #include <stdexcept>
+#include <atomic>
+#include <functional>
+#include <optional>
+#include <limits>
 #include "document.h"
 #include "string_processing.h"
 #include "search_server.h"
+#include "query_parser.h"
+#include "hashing.h"
 using namespace std::string_literals;
 
 void SearchServer::AddDocument(int document_id, std::string_view document, DocumentStatus status,
@@ -21,15 +27,157 @@ void SearchServer::AddDocument(int document_id, std::string_view document, Docum
         throw std::invalid_argument("Invalid document_id"s);
     }
 
-    const auto words = SplitIntoWordsNoStop(document);
+    IndexDocument(document_id, SplitIntoWordsNoStop(document), status, ratings);
+    generation_ = NextGeneration();
+}
+
+void SearchServer::AddDocument(int document_id, const char *document, DocumentStatus status,
+                               const std::vector<int> &ratings){
+    AddDocument(document_id, std::string_view{document}, status, ratings);
+}
+
+void SearchServer::BorrowText(std::string_view text){
+    borrowed_texts_.push_back(text);
+}
+
+void SearchServer::AddDocuments(const std::vector<DocumentInput> &documents){
+    AddDocumentsImpl(std::execution::seq, documents);
+}
+
+void SearchServer::AddDocuments(const std::execution::sequenced_policy&, const std::vector<DocumentInput> &documents){
+    AddDocumentsImpl(std::execution::seq, documents);
+}
+
+void SearchServer::AddDocuments(const std::execution::parallel_policy&, const std::vector<DocumentInput> &documents){
+    AddDocumentsImpl(std::execution::par, documents);
+}
+
+template <typename Policy>
+void SearchServer::AddDocumentsImpl(Policy policy, const std::vector<DocumentInput> &documents){
+    // Exceptions must not leave a parallel algorithm, invalid texts are marked instead
+    std::vector<std::optional<std::vector<std::string_view>>> document_words(documents.size());
+    std::transform(policy, documents.begin(), documents.end(), document_words.begin(),
+        [this](const DocumentInput &document) -> std::optional<std::vector<std::string_view>>{
+            try{
+                return SplitIntoWordsNoStop(document.text);
+            }catch (const std::invalid_argument&){
+                return std::nullopt;
+            }
+        });
+
+    for (std::size_t i = 0; i < documents.size(); ++i){
+        const DocumentInput &document = documents[i];
+        if ((document.document_id < 0) || (documents_.count(document.document_id) > 0)){
+            throw std::invalid_argument("Invalid document_id"s);
+        }
+        if (!document_words[i]){
+            throw std::invalid_argument("Word  is invalid"s);
+        }
+        IndexDocument(document.document_id, *document_words[i], document.status, document.ratings);
+        generation_ = NextGeneration();
+    }
+}
+
+void SearchServer::IndexDocument(int document_id, const std::vector<std::string_view> &words,
+                                 DocumentStatus status, const std::vector<int> &ratings){
     const double inv_word_count = 1.0 / words.size();
+    std::vector<TermId> word_terms;
+    word_terms.reserve(words.size());
     for (std::string_view word : words){
-        words_.push_back(std::move(std::string{word}));
-        word_to_document_freqs_[words_.back()][document_id] += inv_word_count;
-        document_words[document_id][words_.back()] += inv_word_count;
+        word_terms.push_back(IsBorrowedText(word) ? terms_.InsertBorrowed(word) : terms_.Insert(word));
     }
+    std::sort(word_terms.begin(), word_terms.end());
+
+    std::vector<TermId> distinct_terms(word_terms);
+    distinct_terms.erase(std::unique(distinct_terms.begin(), distinct_terms.end()), distinct_terms.end());
+    const DocumentFingerprint fingerprint = ComputeFingerprint(distinct_terms);
+    bool is_duplicate = false;
+    if (duplicate_policy_ != DuplicatePolicy::ALLOW){
+        const auto [first, last] = fingerprint_documents_.equal_range(fingerprint);
+        is_duplicate = std::any_of(first, last, [this, &distinct_terms](const auto &entry){
+            return HasSameTerms(documents_.at(entry.second), distinct_terms);
+        });
+        if (is_duplicate && duplicate_policy_ == DuplicatePolicy::REJECT){
+            throw std::invalid_argument("Duplicate document"s);
+        }
+        fingerprint_documents_.emplace(fingerprint, document_id);
+    }
+
+    const std::size_t forward_offset = forward_entries_.size();
+    for (std::size_t i = 0; i < word_terms.size(); ){
+        const TermId term = word_terms[i];
+        std::uint32_t term_count = 0;
+        for (; i < word_terms.size() && word_terms[i] == term; ++i){
+            ++term_count;
+        }
+        forward_entries_.push_back({term, term_count});
+    }
+    inverted_index_.AddDocument(document_id, forward_entries_.data() + forward_offset,
+                                forward_entries_.data() + forward_entries_.size());
+    RaiseTermBounds(forward_entries_.data() + forward_offset, forward_entries_.data() + forward_entries_.size(),
+                    inv_word_count);
     document_ids_.push_back(document_id);
-    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status});
+    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status,
+                                                 forward_offset, forward_entries_.size() - forward_offset,
+                                                 fingerprint, is_duplicate,
+                                                 static_cast<std::uint32_t>(words.size()), inv_word_count});
+}
+
+SearchServer::CompiledQuery SearchServer::CompileQuery(std::string_view raw_query) const{
+    CompiledQuery query = ParseQuery(std::execution::seq, raw_query);
+    query.raw_query_ = std::string{raw_query};
+    return query;
+}
+
+QueryPlan SearchServer::ExplainQuery(std::string_view raw_query) const{
+    const QueryArena arena;
+    const CompiledQuery query = ParseQuery(std::execution::seq, raw_query, arena.GetResource());
+    QueryPlan plan;
+    plan.strategy = ChooseStrategy(query, true);
+    for (const auto [term, inverse_document_freq] : query.plus_terms_){
+        const std::size_t document_freq = inverted_index_.GetPostings(term).size();
+        plan.terms.push_back({terms_.GetTerm(term), false, document_freq, inverse_document_freq,
+                              document_freq > 0 ? inverse_document_freq * max_term_freqs_[term] : 0.0});
+        plan.plus_postings += document_freq;
+    }
+    for (TermId term : query.minus_terms_){
+        const std::size_t document_freq = inverted_index_.GetPostings(term).size();
+        plan.terms.push_back({terms_.GetTerm(term), true, document_freq});
+        plan.minus_postings += document_freq;
+    }
+    std::stable_sort(plan.terms.begin(), plan.terms.end(), [](const PlannedTerm &lhs, const PlannedTerm &rhs){
+        return std::tie(lhs.is_minus, lhs.document_freq) < std::tie(rhs.is_minus, rhs.document_freq);
+    });
+    return plan;
+}
+
+// WAND pays off when a rare term lets the cursors skip over most of the
+// postings of a frequent one. The exhaustive strategies keep the query word
+// order, which fixes the order relevances are summed in.
+QueryStrategy SearchServer::ChooseStrategy(const CompiledQuery &query, bool is_top_k) const{
+    if (documents_.empty()){
+        return QueryStrategy::TAAT;
+    }
+    std::size_t plus_postings = 0;
+    std::size_t min_document_freq = std::numeric_limits<std::size_t>::max();
+    std::size_t max_document_freq = 0;
+    for (const auto &plus_term : query.plus_terms_){
+        const std::size_t document_freq = inverted_index_.GetPostings(plus_term.term).size();
+        if (document_freq == 0){
+            continue;
+        }
+        plus_postings += document_freq;
+        min_document_freq = std::min(min_document_freq, document_freq);
+        max_document_freq = std::max(max_document_freq, document_freq);
+    }
+    if (is_top_k && plus_postings >= WAND_MIN_POSTINGS && max_document_freq >= WAND_MIN_SKEW * min_document_freq){
+        return QueryStrategy::WAND;
+    }
+    const auto id_count = static_cast<std::size_t>(documents_.rbegin()->first) + 1;
+    if (plus_postings * BITMAP_MAX_IDS_PER_POSTING >= id_count){
+        return QueryStrategy::BITMAP;
+    }
+    return QueryStrategy::TAAT;
 }
     
     //Normal FTD
@@ -43,107 +191,601 @@ std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query)
     return FindTopDocuments(std::execution::seq,raw_query);
 }
 
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, QueryStats &stats) const{
+    return FindTopDocuments(std::execution::seq, raw_query, stats);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status,
+                                                     QueryStats &stats) const{
+    return FindTopDocuments(std::execution::seq, raw_query, status, stats);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(const CompiledQuery &query, DocumentStatus status) const{
+    return FindTopDocuments(std::execution::seq, query, status);
+}
+
+std::vector<Document> SearchServer::FindTopDocuments(const CompiledQuery &query) const{
+    return FindTopDocuments(std::execution::seq, query);
+}
+
+std::vector<std::vector<Document>> SearchServer::FindTopDocumentsBatch(const std::vector<std::string> &raw_queries,
+                                                                       DocumentStatus status) const{
+    return FindTopDocumentsBatchImpl(std::execution::seq, raw_queries, status);
+}
+
+std::vector<std::vector<Document>> SearchServer::FindTopDocumentsBatch(const std::execution::sequenced_policy&,
+                                                                       const std::vector<std::string> &raw_queries,
+                                                                       DocumentStatus status) const{
+    return FindTopDocumentsBatchImpl(std::execution::seq, raw_queries, status);
+}
+
+std::vector<std::vector<Document>> SearchServer::FindTopDocumentsBatch(const std::execution::parallel_policy&,
+                                                                       const std::vector<std::string> &raw_queries,
+                                                                       DocumentStatus status) const{
+    return FindTopDocumentsBatchImpl(std::execution::par, raw_queries, status);
+}
+
+template <typename Policy>
+std::vector<std::vector<Document>> SearchServer::FindTopDocumentsBatchImpl(Policy policy,
+                                                                           const std::vector<std::string> &raw_queries,
+                                                                           DocumentStatus status) const{
+    const TraceSpan batch_span("FindTopDocumentsBatch", "queries", static_cast<std::int64_t>(raw_queries.size()));
+    // Exceptions must not leave a parallel algorithm, invalid queries are marked instead
+    std::vector<std::optional<CompiledQuery>> parsed_queries(raw_queries.size());
+    std::transform(policy, raw_queries.begin(), raw_queries.end(), parsed_queries.begin(),
+        [this](const std::string &raw_query) -> std::optional<CompiledQuery>{
+            try{
+                return ParseQuery(std::execution::seq, raw_query, std::pmr::get_default_resource(),
+                                  &GetQueryStageMetrics());
+            }catch (const std::invalid_argument&){
+                return std::nullopt;
+            }
+        });
+    std::vector<CompiledQuery> queries;
+    queries.reserve(raw_queries.size());
+    for (std::size_t i = 0; i < raw_queries.size(); ++i){
+        if (!parsed_queries[i]){
+            // Throws the error of the query
+            ParseQuery(std::execution::seq, raw_queries[i]);
+        }
+        queries.push_back(std::move(*parsed_queries[i]));
+    }
+    MetricsRegistry::Instance().Add(GetQueryStageMetrics().queries, queries.size());
+
+    // Blocks of consecutive queries, cut by query count and posting volume.
+    // A query over the volume on its own gets a block of its own.
+    std::vector<std::pair<std::size_t, std::size_t>> blocks;
+    std::size_t block_first = 0;
+    std::size_t block_postings = 0;
+    for (std::size_t query = 0; query < queries.size(); ++query){
+        std::size_t postings = 0;
+        for (const CompiledQuery::PlusTerm &plus_term : queries[query].plus_terms_){
+            postings += inverted_index_.GetPostings(plus_term.term).size();
+        }
+        for (TermId term : queries[query].minus_terms_){
+            postings += inverted_index_.GetPostings(term).size();
+        }
+        if (query > block_first && (query - block_first == BATCH_BLOCK_SIZE
+                                    || block_postings + postings > BATCH_MAX_POSTINGS)){
+            blocks.emplace_back(block_first, query);
+            block_first = query;
+            block_postings = 0;
+        }
+        block_postings += postings;
+    }
+    if (block_first < queries.size()){
+        blocks.emplace_back(block_first, queries.size());
+    }
+
+    std::vector<std::vector<Document>> results(queries.size());
+    std::for_each(policy, blocks.begin(), blocks.end(), [&](const std::pair<std::size_t, std::size_t> &block){
+        EvaluateQueryBlock(queries, block.first, block.second, status, results);
+    });
+    return results;
+}
+
+void SearchServer::EvaluateQueryBlock(const std::vector<CompiledQuery> &queries, std::size_t first,
+                                      std::size_t last, DocumentStatus status,
+                                      std::vector<std::vector<Document>> &results) const{
+    // A term of one query of the block, position is its place among the plus terms
+    struct TermUse{
+        TermId term;
+        std::uint32_t query;
+        std::uint32_t position;
+        double inverse_document_freq;
+    };
+    // Remembering the position lets every query add up its contributions in
+    // its own term order, so relevances match FindTopDocuments to the bit
+    struct Contribution{
+        int document_id;
+        std::uint32_t position;
+        double relevance;
+    };
+    const auto by_term = [](const TermUse &lhs, const TermUse &rhs){return lhs.term < rhs.term;};
+
+    const QueryArena arena;
+    std::pmr::memory_resource *resource = arena.GetResource();
+    if (last - first == 1){
+        std::vector<Document> &matched_documents = results[first];
+        matched_documents = FindAllDocuments(std::execution::seq, queries[first], MakeStatusPredicate(status),
+                                             resource, nullptr);
+        std::sort(matched_documents.begin(), matched_documents.end(), HasHigherRank);
+        if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT){
+            matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+        }
+        return;
+    }
+    std::pmr::vector<TermUse> plus_uses(resource);
+    std::pmr::vector<TermUse> minus_uses(resource);
+    for (std::size_t query = first; query < last; ++query){
+        const auto index = static_cast<std::uint32_t>(query - first);
+        for (std::size_t position = 0; position < queries[query].plus_terms_.size(); ++position){
+            const auto [term, inverse_document_freq] = queries[query].plus_terms_[position];
+            plus_uses.push_back({term, index, static_cast<std::uint32_t>(position), inverse_document_freq});
+        }
+        for (TermId term : queries[query].minus_terms_){
+            minus_uses.push_back({term, index, 0, 0});
+        }
+    }
+    std::sort(plus_uses.begin(), plus_uses.end(), by_term);
+    std::sort(minus_uses.begin(), minus_uses.end(), by_term);
+
+    const StageTimer accumulation_timer(GetQueryStageMetrics().accumulation, "search.accumulation");
+    std::pmr::vector<std::pmr::vector<Contribution>> contributions(last - first, resource);
+    for (auto group = plus_uses.begin(); group != plus_uses.end();){
+        const auto group_end = std::upper_bound(group, plus_uses.end(), *group, by_term);
+        // The same term has the same inverse document frequency in every query
+        const double inverse_document_freq = group->inverse_document_freq;
+        for (const auto [document_id, term_count] : inverted_index_.GetPostings(group->term)){
+            const auto &document_data = documents_.at(document_id);
+            if (document_data.status != status){
+                continue;
+            }
+            const double term_freq = term_count * document_data.inv_word_count;
+            const double relevance = term_freq * inverse_document_freq;
+            for (auto use = group; use != group_end; ++use){
+                contributions[use->query].push_back({document_id, use->position, relevance});
+            }
+        }
+        group = group_end;
+    }
+
+    std::pmr::vector<std::pmr::vector<int>> minus_documents(last - first, resource);
+    for (auto group = minus_uses.begin(); group != minus_uses.end();){
+        const auto group_end = std::upper_bound(group, minus_uses.end(), *group, by_term);
+        for (const auto [document_id, _] : inverted_index_.GetPostings(group->term)){
+            for (auto use = group; use != group_end; ++use){
+                minus_documents[use->query].push_back(document_id);
+            }
+        }
+        group = group_end;
+    }
+
+    for (std::size_t query = first; query < last; ++query){
+        auto &query_contributions = contributions[query - first];
+        auto &excluded = minus_documents[query - first];
+        std::sort(query_contributions.begin(), query_contributions.end(),
+                  [](const Contribution &lhs, const Contribution &rhs){
+            return std::tie(lhs.document_id, lhs.position) < std::tie(rhs.document_id, rhs.position);
+        });
+        std::sort(excluded.begin(), excluded.end());
+
+        std::vector<Document> &matched_documents = results[query];
+        for (auto it = query_contributions.begin(); it != query_contributions.end();){
+            const int document_id = it->document_id;
+            double relevance = 0;
+            for (; it != query_contributions.end() && it->document_id == document_id; ++it){
+                relevance += it->relevance;
+            }
+            if (!std::binary_search(excluded.begin(), excluded.end(), document_id)){
+                matched_documents.push_back({document_id, relevance, documents_.at(document_id).rating});
+            }
+        }
+        // The same selection as FindTopDocuments, so ties come out in the same order
+        std::sort(matched_documents.begin(), matched_documents.end(), HasHigherRank);
+        if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT){
+            matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+        }
+    }
+}
+
+SearchPage SearchServer::FindTopDocumentsPage(std::string_view raw_query, const SearchCursor &cursor,
+                                              int page_size) const{
+    return FindTopDocumentsPage(raw_query, DocumentStatus::ACTUAL, cursor, page_size);
+}
+
+SearchPage SearchServer::FindTopDocumentsPage(std::string_view raw_query, DocumentStatus status,
+                                              const SearchCursor &cursor, int page_size) const{
+    return FindTopDocumentsPageImpl(raw_query, MakeStatusPredicate(status), static_cast<std::uint64_t>(status),
+                                    cursor, page_size);
+}
+
 int SearchServer::GetDocumentCount() const{
     return document_ids_.size();
 }
 
-std::deque<int>::const_iterator SearchServer::begin() const{return document_ids_.begin();}
-std::deque<int>::const_iterator SearchServer::end() const{return document_ids_.end();}
-std::deque<int>::iterator SearchServer::begin(){return document_ids_.begin();}
-std::deque<int>::iterator SearchServer::end(){return document_ids_.end();}
+MemoryStats SearchServer::GetMemoryStats() const{
+    MemoryStats stats;
+    stats.term_dictionary_bytes = terms_.GetTableBytes() + max_term_freqs_.capacity() * sizeof(double);
+    stats.term_text_bytes = terms_.GetTextBytes();
+    stats.borrowed_text_list_bytes = borrowed_texts_.capacity() * sizeof(std::string_view);
+    stats.posting_bytes = inverted_index_.GetMemoryBytes();
+    stats.forward_index_bytes = forward_entries_.capacity() * sizeof(ForwardEntry);
+    stats.document_metadata_bytes = documents_.get_allocator().GetBytes()
+        + fingerprint_documents_.get_allocator().GetBytes();
+    stats.document_id_bytes = document_ids_.get_allocator().GetBytes();
+
+    stats.term_count = terms_.size();
+    stats.posting_count = inverted_index_.GetPostingCount();
+    stats.dead_posting_count = inverted_index_.GetDeadPostingCount();
+    stats.forward_entry_count = forward_entries_.size() - dead_forward_entries_;
+    stats.dead_forward_entry_count = dead_forward_entries_;
+    stats.document_count = documents_.size();
+    return stats;
+}
+
+SearchServer::DocumentIds::const_iterator SearchServer::begin() const{return document_ids_.begin();}
+SearchServer::DocumentIds::const_iterator SearchServer::end() const{return document_ids_.end();}
+SearchServer::DocumentIds::iterator SearchServer::begin(){return document_ids_.begin();}
+SearchServer::DocumentIds::iterator SearchServer::end(){return document_ids_.end();}
 
-const std::map<std::string_view, double> &SearchServer::GetWordFrequencies(int document_id) const{   
-    if (document_words.count(document_id) == 0){
-        static std::map<std::string_view, double> empty_result;
-        return empty_result;
+WordFrequencies SearchServer::GetWordFrequencies(int document_id) const{
+    const auto it = documents_.find(document_id);
+    if (it == documents_.end()){
+        return {};
     }
-    return document_words.at(document_id);
+    return {forward_entries_.data() + it->second.forward_offset, it->second.forward_size, &terms_,
+            it->second.inv_word_count};
 }
 
 void SearchServer::RemoveDocument(int document_id){
-    {
-    auto it = find(document_ids_.begin(), document_ids_.end(), document_id);
-    document_ids_.erase(it);
+    const auto it = find(document_ids_.begin(), document_ids_.end(), document_id);
+    if (it == document_ids_.end()){
+        return;
     }
-    std::vector <std::string> words;
+    document_ids_.erase(it);
+    const auto entries = GetWordFrequencies(document_id);
+    inverted_index_.RemoveDocument(std::execution::seq, document_id,
+                                   entries.data(), entries.data() + entries.size());
+    dead_forward_entries_ += entries.size();
+    ForgetFingerprint(document_id);
     documents_.erase(document_id);
-    auto it = document_words[document_id].begin();
-    while(it != document_words[document_id].end()){
-        words.push_back(std::string{it->first});
-        ++it;
-    }
-    for (const auto& [word, d] : document_words[document_id]){
-        word_to_document_freqs_[word].erase(document_id);
-    };
-    document_words.erase(document_id);
+    CompactForwardIndex();
+    generation_ = NextGeneration();
 }
 
-void SearchServer::RemoveDocument(const std::execution::sequenced_policy&,int document_id){   
+void SearchServer::RemoveDocument(const std::execution::sequenced_policy&,int document_id){
     RemoveDocument(document_id);
 }
 
-void SearchServer::RemoveDocument(const std::execution::parallel_policy&, int document_id){   
-    {
-    auto it = find(std::execution::par,document_ids_.begin(), document_ids_.end(), document_id);
-    document_ids_.erase(it);
+void SearchServer::RemoveDocument(const std::execution::parallel_policy&, int document_id){
+    const auto it = find(std::execution::par, document_ids_.begin(), document_ids_.end(), document_id);
+    if (it == document_ids_.end()){
+        return;
     }
+    document_ids_.erase(it);
+    const auto entries = GetWordFrequencies(document_id);
+    inverted_index_.RemoveDocument(std::execution::par, document_id,
+                                   entries.data(), entries.data() + entries.size());
+    dead_forward_entries_ += entries.size();
+    ForgetFingerprint(document_id);
     documents_.erase(document_id);
-    std::for_each(std::execution::par,document_words[document_id].begin(), 
-                     document_words[document_id].end(), [&](auto& items){
-       word_to_document_freqs_[items.first].erase(document_id);
-    });
-//
-    document_words.erase(document_id);
+    CompactForwardIndex();
+    generation_ = NextGeneration();
+}
+
+void SearchServer::SetDuplicatePolicy(DuplicatePolicy policy){
+    duplicate_policy_ = policy;
+    fingerprint_documents_.clear();
+    if (policy == DuplicatePolicy::ALLOW){
+        return;
+    }
+    fingerprint_documents_.reserve(documents_.size());
+    for (const auto &[document_id, document_data] : documents_){
+        fingerprint_documents_.emplace(document_data.fingerprint, document_id);
+    }
+}
+
+DuplicatePolicy SearchServer::GetDuplicatePolicy() const{
+    return duplicate_policy_;
+}
+
+bool SearchServer::IsDuplicate(int document_id) const{
+    return documents_.at(document_id).is_duplicate;
+}
+
+DocumentFingerprint SearchServer::GetDocumentFingerprint(int document_id) const{
+    return documents_.at(document_id).fingerprint;
+}
+
+std::vector<int> SearchServer::FindDuplicates() const{
+    // Per fingerprint, the first document of every distinct word set having it
+    std::unordered_map<DocumentFingerprint, std::vector<const DocumentData*>, DocumentFingerprintHasher> kept;
+    kept.reserve(documents_.size());
+    std::vector<int> duplicates;
+    // documents_ is ordered by id, so the first document of a word set is kept
+    for (const auto &[document_id, document_data] : documents_){
+        std::vector<const DocumentData*> &candidates = kept[document_data.fingerprint];
+        const bool is_duplicate = std::any_of(candidates.begin(), candidates.end(),
+            [this, &document_data = document_data](const DocumentData *candidate){
+                return HaveSameTerms(*candidate, document_data);
+            });
+        if (is_duplicate){
+            duplicates.push_back(document_id);
+        }else{
+            candidates.push_back(&document_data);
+        }
+    }
+    return duplicates;
+}
+
+// Order independent: the sum of well mixed per-word hashes, in two independent lanes
+DocumentFingerprint SearchServer::ComputeFingerprint(const std::vector<TermId> &sorted_terms) const{
+    DocumentFingerprint fingerprint{sorted_terms.size(), ~std::uint64_t{0}};
+    for (TermId term : sorted_terms){
+        const std::uint64_t hash = terms_.GetHash(term);
+        fingerprint.low += MixHash(hash + 0x9E3779B97F4A7C15ULL);
+        fingerprint.high += MixHash(hash ^ 0xC2B2AE3D27D4EB4FULL);
+    }
+    return fingerprint;
+}
+
+void SearchServer::ForgetFingerprint(int document_id){
+    auto [first, last] = fingerprint_documents_.equal_range(documents_.at(document_id).fingerprint);
+    for (; first != last; ++first){
+        if (first->second == document_id){
+            fingerprint_documents_.erase(first);
+            return;
+        }
+    }
+}
+
+// Forward indexes are sorted by term, so equal word sets give equal term sequences
+bool SearchServer::HasSameTerms(const DocumentData &document_data, const std::vector<TermId> &sorted_terms) const{
+    const ForwardEntry *first = forward_entries_.data() + document_data.forward_offset;
+    return std::equal(first, first + document_data.forward_size, sorted_terms.begin(), sorted_terms.end(),
+                      [](const ForwardEntry &entry, TermId term){return entry.term == term;});
+}
+
+bool SearchServer::HaveSameTerms(const DocumentData &lhs, const DocumentData &rhs) const{
+    const ForwardEntry *lhs_first = forward_entries_.data() + lhs.forward_offset;
+    const ForwardEntry *rhs_first = forward_entries_.data() + rhs.forward_offset;
+    return std::equal(lhs_first, lhs_first + lhs.forward_size, rhs_first, rhs_first + rhs.forward_size,
+                      [](const ForwardEntry &lhs_entry, const ForwardEntry &rhs_entry){
+                          return lhs_entry.term == rhs_entry.term;
+                      });
+}
+
+// Rewrites the forward index without dead entries once they make up half of it
+void SearchServer::CompactForwardIndex(){
+    if (dead_forward_entries_ * 2 <= forward_entries_.size()){
+        return;
+    }
+    std::vector<ForwardEntry> entries;
+    entries.reserve(forward_entries_.size() - dead_forward_entries_);
+    for (auto &[_, document_data] : documents_){
+        const auto first = forward_entries_.begin() + document_data.forward_offset;
+        document_data.forward_offset = entries.size();
+        entries.insert(entries.end(), first, first + document_data.forward_size);
+    }
+    forward_entries_ = std::move(entries);
+    dead_forward_entries_ = 0;
+    RebuildTermBounds();
+}
+
+void SearchServer::RaiseTermBounds(const ForwardEntry *first, const ForwardEntry *last, double inv_word_count){
+    if (max_term_freqs_.size() < terms_.size()){
+        max_term_freqs_.resize(terms_.size(), 0.0);
+    }
+    for (; first != last; ++first){
+        double &max_term_freq = max_term_freqs_[first->term];
+        max_term_freq = std::max(max_term_freq, first->term_count * inv_word_count);
+    }
+}
+
+void SearchServer::RebuildTermBounds(){
+    max_term_freqs_.assign(terms_.size(), 0.0);
+    for (const auto &[_, document_data] : documents_){
+        const ForwardEntry *first = forward_entries_.data() + document_data.forward_offset;
+        RaiseTermBounds(first, first + document_data.forward_size, document_data.inv_word_count);
+    }
 }
 
 SearchServer::MatchedDoc SearchServer::MatchDocument(std::string_view raw_query, int document_id) const{
-    const auto query = ParseQuery(std::execution::seq,raw_query);
-    
+    const QueryArena arena;
+    return MatchDocument(ParseQuery(std::execution::seq, raw_query, arena.GetResource()), document_id);
+}
+
+SearchServer::MatchedDoc SearchServer::MatchDocument(const std::execution::sequenced_policy&,std::string_view raw_query,
+                                                                                    int document_id) const{
+   return MatchDocument(raw_query, document_id);
+}
+
+SearchServer::MatchedDoc SearchServer::MatchDocument(const std::execution::parallel_policy&,std::string_view raw_query,
+                                                                                int document_id) const{
+    return MatchDocument(std::execution::par, ParseQuery(std::execution::par, raw_query), document_id);
+}
+
+SearchServer::MatchedDoc SearchServer::MatchDocument(const CompiledQuery &query, int document_id) const{
+    if (query.generation_ != generation_){
+        return MatchDocument(query.raw_query_, document_id);
+    }
+
     std::vector<std::string_view> matched_words;
-        for (std::string_view w : query.minus_words){
-        if (word_to_document_freqs_.count(w) != 0 && word_to_document_freqs_.at(w).count(document_id)){
+    for (TermId term : query.minus_terms_){
+        if (DocumentHasTerm(term, document_id)){
             return {matched_words, documents_.at(document_id).status};
         }
     }
-    for (std::string_view w : query.plus_words){
-        if (word_to_document_freqs_.count(w) != 0 && word_to_document_freqs_.at(w).count(document_id)){
-            matched_words.push_back(w);
+    // plus_terms_ are already in word order
+    for (const auto &plus_term : query.plus_terms_){
+        if (DocumentHasTerm(plus_term.term, document_id)){
+            matched_words.push_back(terms_.GetTerm(plus_term.term));
         }
     }
-        std::sort(matched_words.begin(),matched_words.end());
-    matched_words.erase(std::unique(matched_words.begin(),matched_words.end()),matched_words.end());
     return {matched_words, documents_.at(document_id).status};
 }
 
-SearchServer::MatchedDoc SearchServer::MatchDocument(const std::execution::sequenced_policy&,std::string_view raw_query, 
+SearchServer::MatchedDoc SearchServer::MatchDocument(const std::execution::sequenced_policy&, const CompiledQuery &query,
                                                                                     int document_id) const{
-   return MatchDocument(raw_query, document_id);
+    return MatchDocument(query, document_id);
 }
 
-SearchServer::MatchedDoc SearchServer::MatchDocument(const std::execution::parallel_policy&,std::string_view raw_query, 
+SearchServer::MatchedDoc SearchServer::MatchDocument(const std::execution::parallel_policy&, const CompiledQuery &query,
                                                                                 int document_id) const{
-    const auto query = ParseQuery(std::execution::par,raw_query);
+    if (query.generation_ != generation_){
+        return MatchDocument(std::execution::par, std::string_view{query.raw_query_}, document_id);
+    }
 
     std::vector<std::string_view> matched_words;
-    if(std::any_of(std::execution::par,query.minus_words.begin(),query.minus_words.end(),[this, document_id](const auto& str){
-        return word_to_document_freqs_.count(str) != 0 && word_to_document_freqs_.at(str).count(document_id)!= 0;}))
-    { 
+    if(std::any_of(std::execution::par,query.minus_terms_.begin(),query.minus_terms_.end(),[this, document_id](TermId term){
+        return DocumentHasTerm(term, document_id);}))
+    {
             return {matched_words, documents_.at(document_id).status};
     }
 
-    matched_words.reserve(query.plus_words.size());
-    auto last_copy = std::copy_if(std::execution::par, query.plus_words.begin(), query.plus_words.end(), matched_words.begin(),
-    [this,document_id](const auto& w){
-    return word_to_document_freqs_.count(w) != 0 && word_to_document_freqs_.at(w).count(document_id);
+    std::vector<CompiledQuery::PlusTerm> matched_terms(query.plus_terms_.size());
+    auto last_copy = std::copy_if(std::execution::par, query.plus_terms_.begin(), query.plus_terms_.end(), matched_terms.begin(),
+    [this,document_id](const auto &plus_term){
+        return DocumentHasTerm(plus_term.term, document_id);
     });
-    matched_words.erase(last_copy,matched_words.end());
-    std::sort(matched_words.begin(),matched_words.end());
-    matched_words.erase(std::unique(matched_words.begin(),matched_words.end()),matched_words.end());
+    matched_terms.erase(last_copy,matched_terms.end());
+    matched_words.reserve(matched_terms.size());
+    for (const auto &plus_term : matched_terms){
+        matched_words.push_back(terms_.GetTerm(plus_term.term));
+    }
     return {matched_words, documents_.at(document_id).status};
 }
 
+SearchServer::MatchTerms SearchServer::MakeMatchTerms(const CompiledQuery &query) const{
+    MatchTerms terms;
+    terms.plus_terms.reserve(query.plus_terms_.size());
+    for (const auto &plus_term : query.plus_terms_){
+        terms.plus_terms.push_back(plus_term.term);
+    }
+    terms.minus_terms.assign(query.minus_terms_.begin(), query.minus_terms_.end());
+    std::sort(terms.plus_terms.begin(), terms.plus_terms.end());
+    std::sort(terms.minus_terms.begin(), terms.minus_terms.end());
+    return terms;
+}
+
+namespace {
+
+// Calls action(term) for every query term present in the document's entries,
+// stops early once action returns true. Short queries against long documents
+// use binary search, otherwise a linear merge.
+template <typename Action>
+bool IntersectTerms(const std::vector<TermId> &query_terms, const ForwardEntry *first,
+                    const ForwardEntry *last, Action action){
+    const auto by_term = [](const ForwardEntry &entry, TermId term){
+        return entry.term < term;
+    };
+    if (query_terms.size() * 8 < static_cast<std::size_t>(last - first)){
+        for (TermId term : query_terms){
+            first = std::lower_bound(first, last, term, by_term);
+            if (first == last){
+                break;
+            }
+            if (first->term == term && action(term)){
+                return true;
+            }
+        }
+        return false;
+    }
+    auto query_it = query_terms.begin();
+    while (query_it != query_terms.end() && first != last){
+        if (*query_it < first->term){
+            ++query_it;
+        }else if (first->term < *query_it){
+            ++first;
+        }else{
+            if (action(*query_it)){
+                return true;
+            }
+            ++query_it;
+            ++first;
+        }
+    }
+    return false;
+}
+
+} // namespace
+
+SearchServer::MatchedDoc SearchServer::MatchForwardIndex(const MatchTerms &terms, int document_id) const{
+    const DocumentStatus status = documents_.at(document_id).status;
+    const auto entries = GetWordFrequencies(document_id);
+    const ForwardEntry *first = entries.data();
+    const ForwardEntry *last = entries.data() + entries.size();
+    std::vector<std::string_view> matched_words;
+    const bool has_minus_word = IntersectTerms(terms.minus_terms, first, last, [](TermId){
+        return true;
+    });
+    if (has_minus_word){
+        return {matched_words, status};
+    }
+    IntersectTerms(terms.plus_terms, first, last, [this, &matched_words](TermId term){
+        matched_words.push_back(terms_.GetTerm(term));
+        return false;
+    });
+    std::sort(matched_words.begin(), matched_words.end());
+    return {matched_words, status};
+}
+
+bool SearchServer::IsRankedBefore(const Document &lhs, const Document &rhs){
+    // Higher relevance, then higher rating, then lower id first
+    return std::tie(rhs.relevance, rhs.rating, lhs.id) < std::tie(lhs.relevance, lhs.rating, rhs.id);
+}
+
+std::uint64_t SearchServer::MakeCursorQueryKey(std::string_view raw_query, std::uint64_t filter_key){
+    return HashString(raw_query, MixHash(filter_key));
+}
+
+void SearchServer::CheckCursor(const SearchCursor &cursor, std::uint64_t query_key, int page_size) const{
+    if (page_size <= 0){
+        throw std::invalid_argument("Page size must be positive"s);
+    }
+    if (!cursor.has_position_ && !cursor.is_end_){
+        return;
+    }
+    // Relevances change with the index, an old position means nothing
+    if (cursor.has_position_ && cursor.generation_ != generation_){
+        throw std::invalid_argument("Search cursor is stale"s);
+    }
+    if (cursor.query_key_ != query_key){
+        throw std::invalid_argument("Search cursor belongs to another query"s);
+    }
+}
+
+SearchPage SearchServer::MakePage(std::pmr::vector<Document> &heap, std::uint64_t query_key, int page_size) const{
+    std::sort_heap(heap.begin(), heap.end(), IsRankedBefore);
+    SearchPage page;
+    page.next.generation_ = generation_;
+    page.next.query_key_ = query_key;
+    if (heap.size() > static_cast<std::size_t>(page_size)){
+        heap.pop_back();
+        page.next.has_position_ = true;
+        page.next.last_document_ = heap.back();
+    }else{
+        page.next.is_end_ = true;
+    }
+    page.documents.assign(heap.begin(), heap.end());
+    return page;
+}
+
+std::uint64_t SearchServer::NextGeneration(){
+    static std::atomic<std::uint64_t> last_generation{0};
+    return ++last_generation;
+}
+
+bool SearchServer::IsBorrowedText(std::string_view word) const{
+    const std::less_equal<const char*> not_after;
+    return std::any_of(borrowed_texts_.begin(), borrowed_texts_.end(), [&not_after, word](std::string_view text){
+        return not_after(text.data(), word.data()) && not_after(word.data() + word.size(), text.data() + text.size());
+    });
+}
+
 bool SearchServer::IsStopWord(std::string_view word) const{
-    return stop_words_.count(word) > 0;
+    return stop_words_.Contains(word);
 }
 
 bool SearchServer::IsValidWord(std::string_view word){
@@ -152,16 +794,16 @@ bool SearchServer::IsValidWord(std::string_view word){
                    { return c >= '\0' && c < ' '; });
 }
 
-std::deque<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_view text) const{
-    std::deque<std::string_view> words;
-    for (const auto &word : SplitIntoWords(text)){
-        if (!IsValidWord(word)){
+std::vector<std::string_view> SearchServer::SplitIntoWordsNoStop(std::string_view text) const{
+    std::vector<std::string_view> words;
+    ForEachWord(text, [this, &words](std::string_view word, bool is_valid){
+        if (!is_valid){
             throw std::invalid_argument("Word  is invalid"s);
         }
         if (!IsStopWord(word)){
             words.push_back(word);
         }
-    }
+    });
     return words;
 }
 
@@ -176,63 +818,62 @@ int SearchServer::ComputeAverageRating(const std::vector<int> &ratings){
 
 
 
-SearchServer::Query SearchServer::ParseQuery(const std::execution::sequenced_policy&, std::string_view text) const{
-    Query result;
-        auto words = SplitIntoWords(text);
-        result.minus_words.reserve(words.size());
-        result.plus_words.reserve(words.size());
-        std::sort(words.begin(),words.end());
-        words.erase(std::unique(words.begin(),words.end()),words.end());
+SearchServer::CompiledQuery SearchServer::ParseQuery(const std::execution::sequenced_policy&, std::string_view text,
+                                                     std::pmr::memory_resource *resource,
+                                                     const QueryStageMetrics *stages) const{
+    CompiledQuery result(resource);
+    result.generation_ = generation_;
+    const TraceSpan query_span("ParseQuery");
+    std::optional<StageTimer> parse_timer;
+    if (stages != nullptr){
+        parse_timer.emplace(stages->parse, "search.parse");
+    }
+    const QueryWords words = ParseQueryWords(text, stop_words_, resource);
+    parse_timer.reset();
 
-    std::for_each(words.begin(),words.end(),[this, &result](std::string_view  word){
-        const auto query_word = ParseQueryWord(word);
-        
-        if (!query_word.is_stop){
-            query_word.is_minus ?   result.minus_words.push_back(query_word.data) : 
-                                    result.plus_words.push_back(query_word.data);
-        }
-    });
-    result.minus_words.shrink_to_fit();
-    result.plus_words.shrink_to_fit();
-    return result;
-}
+    std::optional<StageTimer> term_lookup_timer;
+    if (stages != nullptr){
+        term_lookup_timer.emplace(stages->term_lookup, "search.term_lookup");
+    }
 
-SearchServer::Query SearchServer::ParseQuery(const std::execution::parallel_policy&,std::string_view text) const{
-    Query result;
-    auto words = SplitIntoWords(text);
-    result.minus_words.reserve(words.size());
-    result.plus_words.reserve(words.size());
-    std::sort(words.begin(),words.end());
-    words.erase(std::unique(words.begin(),words.end()),words.end());
-    for (std::string_view word : words){
-        const auto query_word = ParseQueryWord(word);
-        if (!query_word.is_stop){
-            query_word.is_minus ?   result.minus_words.push_back(query_word.data) : 
-                                    result.plus_words.push_back(query_word.data);
+    // Every word is resolved to its term once, words unknown to the index are dropped
+    for (std::string_view word : words.plus_words){
+        const TermId term = terms_.Find(word);
+        if (term != NO_TERM){
+            result.plus_terms_.push_back({term, ComputeWordInverseDocumentFreq(term)});
+        }
+    }
+    for (std::string_view word : words.minus_words){
+        const TermId term = terms_.Find(word);
+        if (term != NO_TERM){
+            result.minus_terms_.push_back(term);
         }
     }
-    result.minus_words.shrink_to_fit();
-    result.plus_words.shrink_to_fit();
     return result;
 }
 
-SearchServer::QueryWord SearchServer::ParseQueryWord(std::string_view text) const{
-    if (text.size() == 0){
-        throw std::invalid_argument("Query word is empty"s);
-    }
-    std::string_view word =text;
-    bool is_minus = false;
-    if (word[0] == '-'){
-        is_minus = true;
-        word = word.substr(1);
+SearchServer::CompiledQuery SearchServer::ParseQuery(const std::execution::parallel_policy&, std::string_view text,
+                                                     std::pmr::memory_resource *resource,
+                                                     const QueryStageMetrics *stages) const{
+    return ParseQuery(std::execution::seq, text, resource, stages);
+}
+
+bool SearchServer::DocumentHasTerm(TermId term, int document_id) const{
+    return inverted_index_.Contains(term, document_id);
+}
+
+void SearchServer::CountQueryPostings(const CompiledQuery &query, QueryStats &stats) const{
+    stats.plus_terms = query.plus_terms_.size();
+    stats.minus_terms = query.minus_terms_.size();
+    stats.postings_scanned = 0;
+    for (const CompiledQuery::PlusTerm &plus_term : query.plus_terms_){
+        stats.postings_scanned += inverted_index_.GetPostings(plus_term.term).size();
     }
-    if (word.empty() || word[0] == '-' || !IsValidWord(word)){
-        throw std::invalid_argument("Query word is invalid");
+    for (TermId term : query.minus_terms_){
+        stats.postings_scanned += inverted_index_.GetPostings(term).size();
     }
-
-    return {word, is_minus, IsStopWord(word)};
 }
-// Existence required
-double SearchServer::ComputeWordInverseDocumentFreq(std::string_view word) const{
-    return log(GetDocumentCount() * 1.0 / word_to_document_freqs_.at(word).size());
+
+double SearchServer::ComputeWordInverseDocumentFreq(TermId term) const{
+    return log(GetDocumentCount() * 1.0 / inverted_index_.GetPostings(term).size());
 }
@@ -8,13 +8,35 @@
 #include <tuple>
 #include <stdexcept>
 #include <algorithm>
+#include <atomic>
 #include <execution>
+#include <type_traits>
 #include "document.h"
 #include "string_processing.h"
 #include "concurrent_map.h"
+#include "stop_words.h"
+#include "term_dictionary.h"
+#include "forward_index.h"
+#include "inverted_index.h"
+#include "document_fingerprint.h"
+#include "counting_allocator.h"
+#include "search_cursor.h"
+#include "query_stats.h"
+#include "query_planner.h"
+#include "query_arena.h"
+#include "metrics.h"
+#include "tracing.h"
 #include "log_duration.h"
 #include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <istream>
+#include <memory_resource>
+#include <optional>
+#include <ostream>
+#include <typeinfo>
+#include <unordered_map>
 
 constexpr double ACCURACY = 1e-6;
 enum class DocumentStatus{
@@ -25,10 +47,72 @@ enum class DocumentStatus{
 };
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 
+// Order of search results: by relevance, documents of equal relevance by rating
+inline bool HasHigherRank(const Document &lhs, const Document &rhs){
+    if (std::abs(lhs.relevance - rhs.relevance) < ACCURACY){
+        return lhs.rating > rhs.rating;
+    }else{
+        return lhs.relevance > rhs.relevance;
+    }
+}
+
+// What AddDocument does with a document whose set of words is already indexed
+enum class DuplicatePolicy{
+    ALLOW,
+    // The document is added and IsDuplicate reports it
+    FLAG,
+    // AddDocument throws std::invalid_argument
+    REJECT,
+};
+
+// One document of an AddDocuments batch, the text is only read during the call
+struct DocumentInput{
+    int document_id;
+    std::string_view text;
+    DocumentStatus status;
+    std::vector<int> ratings;
+};
+
+// Heap bytes held by the index, from container capacities and counting
+// allocators, so they match what was allocated short of malloc overhead.
+// String storage is term_text_bytes; borrowed texts belong to the caller
+// and are not counted.
+struct MemoryStats{
+    // Swiss table, term views, hashes and term frequency bounds
+    std::size_t term_dictionary_bytes = 0;
+    // Chunks with the copied text of terms
+    std::size_t term_text_bytes = 0;
+    // The list of borrowed texts
+    std::size_t borrowed_text_list_bytes = 0;
+    std::size_t posting_bytes = 0;
+    std::size_t forward_index_bytes = 0;
+    // Document data and the fingerprint index
+    std::size_t document_metadata_bytes = 0;
+    std::size_t document_id_bytes = 0;
+
+    std::size_t term_count = 0;
+    std::size_t posting_count = 0;
+    // Posting arena slots not holding a live posting
+    std::size_t dead_posting_count = 0;
+    std::size_t forward_entry_count = 0;
+    // Entries of removed documents awaiting compaction
+    std::size_t dead_forward_entry_count = 0;
+    std::size_t document_count = 0;
+
+    std::size_t GetTotalBytes() const{
+        return term_dictionary_bytes + term_text_bytes + borrowed_text_list_bytes + posting_bytes
+            + forward_index_bytes + document_metadata_bytes + document_id_bytes;
+    }
+};
 
 class SearchServer{
 public:
     SearchServer() = default;
+    // Not copyable, as the term dictionary is not
+    SearchServer(const SearchServer&) = delete;
+    SearchServer &operator=(const SearchServer&) = delete;
+    SearchServer(SearchServer&&) = default;
+    SearchServer &operator=(SearchServer&&) = default;
 
     explicit SearchServer(const std::string &stop_words_text)
         : SearchServer(SplitIntoWords(stop_words_text)) {}
@@ -44,17 +128,92 @@ public:
         }
     }
 
+    // A query parsed once and resolved against the index, accepted by
+    // FindTopDocuments and MatchDocument in place of the raw query text.
+    // After AddDocument or RemoveDocument it is transparently parsed again.
+    class CompiledQuery{
+    public:
+        CompiledQuery() = default;
+
+        std::string_view GetRawQuery() const{return raw_query_;}
+
+    private:
+        friend class SearchServer;
+
+        struct PlusTerm{
+            TermId term;
+            double inverse_document_freq;
+        };
+
+        std::string raw_query_;
+        std::uint64_t generation_ = 0;
+        // Terms known to the index, in word order and without repeats
+        // Queries parsed inside FindTopDocuments live in the query arena, a copy
+        // always uses the default resource
+        std::pmr::vector<PlusTerm> plus_terms_;
+        std::pmr::vector<TermId> minus_terms_;
+
+        explicit CompiledQuery(std::pmr::memory_resource *resource)
+            : plus_terms_(resource),
+            minus_terms_(resource){
+        }
+    };
+
+    CompiledQuery CompileQuery(std::string_view raw_query) const;
+    // The strategy and term statistics a sequential FindTopDocuments would use.
+    // Throws std::invalid_argument for an invalid query.
+    QueryPlan ExplainQuery(std::string_view raw_query) const;
+
+    // The text is only read during the call: the terms new to the index are
+    // copied into the dictionary chunks, or kept as views into a borrowed text
     void AddDocument(int document_id, std::string_view document, DocumentStatus status,
                      const std::vector<int> &ratings);
+    // Keeps calls with string literals unambiguous
+    void AddDocument(int document_id, const char *document, DocumentStatus status,
+                     const std::vector<int> &ratings);
+
+    // Borrowed corpus mode: new terms found inside text, e.g. a mapped corpus
+    // file, are stored as views instead of copies. The caller guarantees that
+    // text outlives the server.
+    void BorrowText(std::string_view text);
+
+    // Adds the documents in order with the checks of AddDocument. The texts are
+    // tokenized up front, in parallel for the parallel policy, so a batch is
+    // faster than single calls. If a document is rejected the exception is
+    // thrown after the documents before it were added.
+    void AddDocuments(const std::vector<DocumentInput> &documents);
+    void AddDocuments(const std::execution::sequenced_policy&, const std::vector<DocumentInput> &documents);
+    void AddDocuments(const std::execution::parallel_policy&, const std::vector<DocumentInput> &documents);
+
+    // Versioned binary snapshot of the whole index: stop words, terms, postings,
+    // forward indexes and document data. Load reads each part in one block and
+    // throws std::invalid_argument on a damaged or foreign snapshot.
+    void Save(std::ostream &output) const;
+    static SearchServer Load(std::istream &input);
 
     int GetDocumentCount() const;
+    MemoryStats GetMemoryStats() const;
 
-    const std::map<std::string_view, double> &GetWordFrequencies(int document_id) const;
+    // Empty for unknown documents
+    WordFrequencies GetWordFrequencies(int document_id) const;
 
-    std::deque<int>::const_iterator begin() const;
-    std::deque<int>::const_iterator end() const;
-    std::deque<int>::iterator begin();
-    std::deque<int>::iterator end();
+    using DocumentIds = std::deque<int, CountingAllocator<int>>;
+
+    DocumentIds::const_iterator begin() const;
+    DocumentIds::const_iterator end() const;
+    DocumentIds::iterator begin();
+    DocumentIds::iterator end();
+
+    // Starts tracking the fingerprints of indexed documents unless the policy is ALLOW
+    void SetDuplicatePolicy(DuplicatePolicy policy);
+    DuplicatePolicy GetDuplicatePolicy() const;
+    // Whether an equal set of words was already indexed when the document was
+    // added under DuplicatePolicy::FLAG
+    bool IsDuplicate(int document_id) const;
+    DocumentFingerprint GetDocumentFingerprint(int document_id) const;
+    // Ids of documents whose set of words equals the one of a document with
+    // a smaller id, in ascending order. O(N) in the number of documents.
+    std::vector<int> FindDuplicates() const;
 
     void RemoveDocument(int document_id);
     void RemoveDocument(const std::execution::sequenced_policy&, int document_id);
@@ -66,6 +225,40 @@ public:
     MatchedDoc MatchDocument(const std::execution::parallel_policy&, std::string_view raw_query, 
                                                                         int document_id) const;
     MatchedDoc MatchDocument(std::string_view raw_query, int document_id) const;
+    MatchedDoc MatchDocument(const std::execution::sequenced_policy&, const CompiledQuery &query,
+                                                                        int document_id) const;
+    MatchedDoc MatchDocument(const std::execution::parallel_policy&, const CompiledQuery &query,
+                                                                        int document_id) const;
+    MatchedDoc MatchDocument(const CompiledQuery &query, int document_id) const;
+
+    // Matches one query against many documents, result i belongs to the i-th id.
+    // Every document's words are intersected with the sorted query words.
+    // Throws std::out_of_range before any matching if an id is unknown.
+    template <typename Policy, typename DocumentIds>
+    std::vector<MatchedDoc> MatchDocuments(Policy policy, const CompiledQuery &query,
+                                           const DocumentIds &document_ids) const{
+        if (query.generation_ != generation_){
+            return MatchDocuments(policy, ParseQuery(policy, query.raw_query_), document_ids);
+        }
+        std::vector<int> ids(document_ids.begin(), document_ids.end());
+        for (int document_id : ids){
+            if (documents_.count(document_id) == 0){
+                throw std::out_of_range("Invalid document_id");
+            }
+        }
+        const MatchTerms terms = MakeMatchTerms(query);
+        std::vector<MatchedDoc> result(ids.size());
+        std::transform(policy, ids.begin(), ids.end(), result.begin(), [this, &terms](int document_id){
+            return MatchForwardIndex(terms, document_id);
+        });
+        return result;
+    }
+
+    template <typename Policy, typename DocumentIds>
+    std::vector<MatchedDoc> MatchDocuments(Policy policy, std::string_view raw_query,
+                                           const DocumentIds &document_ids) const{
+        return MatchDocuments(policy, ParseQuery(policy, raw_query), document_ids);
+    }
     
     //Normal FTD
     std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
@@ -79,8 +272,7 @@ public:
     //Policy FTD
     template <typename Policy> 
     std::vector<Document> FindTopDocuments(Policy policy,std::string_view raw_query, DocumentStatus status) const{
-    return FindTopDocuments(policy,raw_query,[status](int document_id, DocumentStatus document_status, int rating){
-        return document_status == status;});
+    return FindTopDocuments(policy, raw_query, MakeStatusPredicate(status));
     }       
     
     template <typename Policy>                
@@ -88,126 +280,640 @@ public:
         return FindTopDocuments(policy ,raw_query, DocumentStatus::ACTUAL); 
     }
 
-    template <typename Policy, typename DocumentPredicate>         
-    std::vector<Document> FindTopDocuments(Policy policy, std::string_view raw_query, 
+    template <typename Policy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(Policy policy, std::string_view raw_query,
                                         DocumentPredicate document_predicate) const{
-        const auto query = ParseQuery(policy,raw_query);
-        auto matched_documents = FindAllDocuments(policy, query, document_predicate);
-        sort(policy, matched_documents.begin(), matched_documents.end(), [](const Document &lhs, const Document &rhs){
-                 if (std::abs(lhs.relevance - rhs.relevance) < ACCURACY){
-                     return lhs.rating > rhs.rating;
-                 }else{
-                     return lhs.relevance > rhs.relevance;
-                 }
-             });
-        if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT){
-            matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+        if (slow_query_log_ != nullptr){
+            QueryStats stats;
+            return FindTopDocuments(policy, raw_query, document_predicate, stats);
         }
+        const QueryArena arena;
+        return FindTopDocuments(policy, ParseQuery(policy, raw_query, arena.GetResource(), &GetQueryStageMetrics()),
+                                document_predicate);
+    }
 
-        return matched_documents;
+    //FTD with execution statistics, stats is overwritten
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, QueryStats &stats) const;
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status, QueryStats &stats) const;
+
+    template <typename Policy>
+    std::vector<Document> FindTopDocuments(Policy policy, std::string_view raw_query, QueryStats &stats) const{
+        return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL, stats);
     }
 
+    template <typename Policy>
+    std::vector<Document> FindTopDocuments(Policy policy, std::string_view raw_query, DocumentStatus status,
+                                           QueryStats &stats) const{
+        return FindTopDocuments(policy, raw_query, MakeStatusPredicate(status), stats);
+    }
+
+    template <typename Policy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(Policy policy, std::string_view raw_query,
+                                           DocumentPredicate document_predicate, QueryStats &stats) const{
+        const auto start_time = std::chrono::steady_clock::now();
+        stats = {};
+        const QueryArena arena;
+        const CompiledQuery query = ParseQuery(policy, raw_query, arena.GetResource(), &GetQueryStageMetrics());
+        stats.parse_ns = ElapsedNanoseconds(start_time);
+        auto result = FindTopDocumentsImpl(policy, query, document_predicate, arena.GetResource(), &stats);
+        stats.total_ns = ElapsedNanoseconds(start_time);
+        if (slow_query_log_ != nullptr){
+            slow_query_log_->Record(raw_query, stats);
+        }
+        return result;
+    }
+
+    //Compiled query FTD
+    std::vector<Document> FindTopDocuments(const CompiledQuery &query, DocumentStatus status) const;
+    std::vector<Document> FindTopDocuments(const CompiledQuery &query) const;
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(const CompiledQuery &query, DocumentPredicate document_predicate) const{
+        return FindTopDocuments(std::execution::seq, query, document_predicate);
+    }
+
+    template <typename Policy>
+    std::vector<Document> FindTopDocuments(Policy policy, const CompiledQuery &query, DocumentStatus status) const{
+        return FindTopDocuments(policy, query, MakeStatusPredicate(status));
+    }
+
+    template <typename Policy>
+    std::vector<Document> FindTopDocuments(Policy policy, const CompiledQuery &query) const{
+        return FindTopDocuments(policy, query, DocumentStatus::ACTUAL);
+    }
+
+    template <typename Policy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(Policy policy, const CompiledQuery &query,
+                                        DocumentPredicate document_predicate) const{
+        if (query.generation_ != generation_){
+            return FindTopDocuments(policy, query.raw_query_, document_predicate);
+        }
+        const QueryArena arena;
+        if (slow_query_log_ == nullptr){
+            return FindTopDocumentsImpl(policy, query, document_predicate, arena.GetResource(), nullptr);
+        }
+        const auto start_time = std::chrono::steady_clock::now();
+        QueryStats stats;
+        auto result = FindTopDocumentsImpl(policy, query, document_predicate, arena.GetResource(), &stats);
+        stats.total_ns = ElapsedNanoseconds(start_time);
+        slow_query_log_->Record(query.raw_query_, stats);
+        return result;
+    }
+
+    // Results of FindTopDocuments(raw_query, status) for every query, evaluated
+    // by shared scan: queries are taken in blocks, and a posting list used by
+    // several queries of a block is walked once, its contributions scattered
+    // to each of them. The parallel policy runs the blocks concurrently.
+    // Throws std::invalid_argument for the first invalid query.
+    std::vector<std::vector<Document>> FindTopDocumentsBatch(const std::vector<std::string> &raw_queries,
+                                                             DocumentStatus status = DocumentStatus::ACTUAL) const;
+    std::vector<std::vector<Document>> FindTopDocumentsBatch(const std::execution::sequenced_policy&,
+                                                             const std::vector<std::string> &raw_queries,
+                                                             DocumentStatus status = DocumentStatus::ACTUAL) const;
+    std::vector<std::vector<Document>> FindTopDocumentsBatch(const std::execution::parallel_policy&,
+                                                             const std::vector<std::string> &raw_queries,
+                                                             DocumentStatus status = DocumentStatus::ACTUAL) const;
+
+    // Search-after pagination: up to page_size documents ranked right after the
+    // cursor, a default cursor starts from the top. Matches are kept in a heap
+    // of page_size + 1 documents as they are built, those not after the cursor
+    // are skipped, so a page costs memory for one page whatever the number of
+    // matches. Pages follow the exact (relevance, rating, id) order rather
+    // than HasHigherRank, whose ACCURACY tolerance is not transitive and
+    // could skip or repeat documents between pages. Throws
+    // std::invalid_argument for a cursor made before the index changed or
+    // for another query text or filter; predicates are told apart by type.
+    SearchPage FindTopDocumentsPage(std::string_view raw_query, const SearchCursor &cursor, int page_size) const;
+    SearchPage FindTopDocumentsPage(std::string_view raw_query, DocumentStatus status,
+                                    const SearchCursor &cursor, int page_size) const;
+    template <typename DocumentPredicate>
+    SearchPage FindTopDocumentsPage(std::string_view raw_query, DocumentPredicate document_predicate,
+                                    const SearchCursor &cursor, int page_size) const{
+        return FindTopDocumentsPageImpl(raw_query, document_predicate, typeid(DocumentPredicate).hash_code(),
+                                        cursor, page_size);
+    }
+
+    // Queries at or over the log's threshold are recorded in it, nullptr
+    // turns the log off. The log must outlive the server or be detached.
+    // While a log is set every query collects its statistics.
+    void SetSlowQueryLog(SlowQueryLog *slow_query_log){slow_query_log_ = slow_query_log;}
+
 private:
+    // Reads the index to write its memory mapped form
+    friend class MappedIndex;
+
     struct DocumentData{
         int rating;
         DocumentStatus status;
+        // Position of the document's entries in forward_entries_
+        std::size_t forward_offset;
+        std::size_t forward_size;
+        DocumentFingerprint fingerprint;
+        bool is_duplicate;
+        // Number of indexed words, tf = term_count * inv_word_count
+        std::uint32_t word_count;
+        double inv_word_count;
     };
 
-    struct Query{
-        std::vector<std::string_view> plus_words;
-        std::vector<std::string_view> minus_words;
+    // Query terms in the order of the forward index
+    struct MatchTerms{
+        std::vector<TermId> plus_terms;
+        std::vector<TermId> minus_terms;
     };
 
-    struct QueryWord{
-        std::string_view data;
-        bool is_minus;
-        bool is_stop;
-    };
-    const std::set<std::string, std::less<>> stop_words_;
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, std::map<std::string_view, double>> document_words;
-    std::map<int, DocumentData> documents_;
-    std::deque<int> document_ids_;
-    std::deque<std::string> words_;
+    StopWordSet stop_words_;
+    TermDictionary terms_;
+    std::vector<std::string_view> borrowed_texts_;
+    InvertedIndex inverted_index_;
+    // Forward indexes of all documents back to back, removed documents
+    // leave dead entries until the next compaction
+    std::vector<ForwardEntry> forward_entries_;
+    std::size_t dead_forward_entries_ = 0;
+    DuplicatePolicy duplicate_policy_ = DuplicatePolicy::ALLOW;
+    // Indexed documents by fingerprint, kept unless the policy is ALLOW
+    std::unordered_multimap<DocumentFingerprint, int, DocumentFingerprintHasher, std::equal_to<DocumentFingerprint>,
+                            CountingAllocator<std::pair<const DocumentFingerprint, int>>> fingerprint_documents_;
+    std::map<int, DocumentData, std::less<int>, CountingAllocator<std::pair<const int, DocumentData>>> documents_;
+    DocumentIds document_ids_;
+    // Unique across all servers and changed by every AddDocument and
+    // RemoveDocument, compiled queries made for another generation are parsed again
+    std::uint64_t generation_ = NextGeneration();
+    SlowQueryLog *slow_query_log_ = nullptr;
+    // Per term, at least the largest term frequency among the documents holding
+    // it. Removals leave it as is, forward index compaction tightens it.
+    std::vector<double> max_term_freqs_;
+
+    // Planner thresholds: WAND needs enough postings and a frequent term at
+    // least this many times longer than the rarest; BITMAP needs at least one
+    // plus posting per that many ids
+    static constexpr std::size_t WAND_MIN_POSTINGS = 1024;
+    static constexpr std::size_t WAND_MIN_SKEW = 2;
+    static constexpr std::size_t BITMAP_MAX_IDS_PER_POSTING = 16;
+
+    static std::uint64_t NextGeneration();
+    // Document predicate of the overloads taking a status
+    static auto MakeStatusPredicate(DocumentStatus status){
+        return [status](int, DocumentStatus document_status, int){
+            return document_status == status;
+        };
+    }
+    static std::uint64_t ElapsedNanoseconds(std::chrono::steady_clock::time_point start_time){
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start_time).count();
+    }
+
+    // Exact comparison, so that the cursor key is a strict total order
+    static bool IsRankedBefore(const Document &lhs, const Document &rhs);
+    static std::uint64_t MakeCursorQueryKey(std::string_view raw_query, std::uint64_t filter_key);
+    void CheckCursor(const SearchCursor &cursor, std::uint64_t query_key, int page_size) const;
+    // Sorts a heap of IsRankedBefore holding up to page_size + 1 documents
+    // into a page, the extra document only tells that another page follows
+    SearchPage MakePage(std::pmr::vector<Document> &heap, std::uint64_t query_key, int page_size) const;
+
+    // filter_key tells the filters apart in the cursor
+    template <typename DocumentPredicate>
+    SearchPage FindTopDocumentsPageImpl(std::string_view raw_query, DocumentPredicate document_predicate,
+                                        std::uint64_t filter_key, const SearchCursor &cursor, int page_size) const{
+        const std::uint64_t query_key = MakeCursorQueryKey(raw_query, filter_key);
+        CheckCursor(cursor, query_key, page_size);
+        if (cursor.IsEnd()){
+            return {{}, cursor};
+        }
+        const QueryArena arena;
+        const std::size_t heap_size = static_cast<std::size_t>(page_size) + 1;
+        // The document ranked last is on top
+        std::pmr::vector<Document> heap(arena.GetResource());
+        ForEachMatchedDocument(ParseQuery(std::execution::seq, raw_query, arena.GetResource(),
+                                          &GetQueryStageMetrics()),
+                               document_predicate, [&heap, &cursor, heap_size](const Document &document){
+            if (cursor.has_position_ && !IsRankedBefore(cursor.last_document_, document)){
+                return;
+            }
+            if (heap.size() == heap_size){
+                if (!IsRankedBefore(document, heap.front())){
+                    return;
+                }
+                std::pop_heap(heap.begin(), heap.end(), IsRankedBefore);
+                heap.back() = document;
+            }else{
+                heap.push_back(document);
+            }
+            std::push_heap(heap.begin(), heap.end(), IsRankedBefore);
+        }, arena.GetResource(), nullptr);
+        return MakePage(heap, query_key, page_size);
+    }
 
     bool IsStopWord(std::string_view word) const;
     static bool IsValidWord(std::string_view word);
 
-    std::deque<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
+    std::vector<std::string_view> SplitIntoWordsNoStop(std::string_view text) const;
+    // Indexes the words of a document whose id was checked. New terms are
+    // borrowed when they lie in a borrowed text.
+    void IndexDocument(int document_id, const std::vector<std::string_view> &words, DocumentStatus status,
+                       const std::vector<int> &ratings);
+    bool IsBorrowedText(std::string_view word) const;
+    template <typename Policy>
+    void AddDocumentsImpl(Policy policy, const std::vector<DocumentInput> &documents);
 
     static int ComputeAverageRating(const std::vector<int> &ratings);
 
-    Query ParseQuery(const std::execution::sequenced_policy&,std::string_view text) const;
-    Query ParseQuery(const std::execution::parallel_policy&,std::string_view text) const;
+    // Records the parse and term lookup stages when stages is given. Only
+    // searches pass it, so MatchDocument, CompileQuery and the other callers
+    // stay out of the FindTopDocuments histograms.
+    CompiledQuery ParseQuery(const std::execution::sequenced_policy&, std::string_view text,
+                             std::pmr::memory_resource *resource = std::pmr::get_default_resource(),
+                             const QueryStageMetrics *stages = nullptr) const;
+    CompiledQuery ParseQuery(const std::execution::parallel_policy&, std::string_view text,
+                             std::pmr::memory_resource *resource = std::pmr::get_default_resource(),
+                             const QueryStageMetrics *stages = nullptr) const;
+
+    bool DocumentHasTerm(TermId term, int document_id) const;
+    MatchTerms MakeMatchTerms(const CompiledQuery &query) const;
+    MatchedDoc MatchForwardIndex(const MatchTerms &terms, int document_id) const;
+    void CompactForwardIndex();
+    void RaiseTermBounds(const ForwardEntry *first, const ForwardEntry *last, double inv_word_count);
+    void RebuildTermBounds();
+    // WAND only for top-k selection, the other strategies produce every match
+    QueryStrategy ChooseStrategy(const CompiledQuery &query, bool is_top_k) const;
+    DocumentFingerprint ComputeFingerprint(const std::vector<TermId> &sorted_terms) const;
+    void ForgetFingerprint(int document_id);
+    // Fingerprints may collide, documents are duplicates only if these agree
+    bool HasSameTerms(const DocumentData &document_data, const std::vector<TermId> &sorted_terms) const;
+    bool HaveSameTerms(const DocumentData &lhs, const DocumentData &rhs) const;
+    double ComputeWordInverseDocumentFreq(TermId term) const;
+
+    // The query must be of the current generation, stats may be nullptr
+    template <typename Policy, typename DocumentPredicate>
+    std::vector<Document> FindTopDocumentsImpl(Policy policy, const CompiledQuery &query,
+                                               DocumentPredicate document_predicate,
+                                               std::pmr::memory_resource *resource, QueryStats *stats) const{
+        const TraceSpan query_span("FindTopDocuments");
+        const QueryStageMetrics &stages = GetQueryStageMetrics();
+        MetricsRegistry::Instance().Add(stages.queries);
+        std::vector<Document> matched_documents;
+        if constexpr (std::is_same_v<Policy, std::execution::sequenced_policy>){
+            if (ChooseStrategy(query, true) == QueryStrategy::WAND){
+                matched_documents = FindTopDocumentsWand(query, document_predicate, resource, stats);
+            }else{
+                matched_documents = FindAllDocuments(policy, query, document_predicate, resource, stats);
+            }
+        }else{
+            matched_documents = FindAllDocuments(policy, query, document_predicate, resource, stats);
+        }
+        StageTimer top_k_timer(stages.top_k, "search.top_k", stats != nullptr ? &stats->top_k_ns : nullptr);
+        sort(policy, matched_documents.begin(), matched_documents.end(), HasHigherRank);
+        if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT){
+            matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+        }
+        top_k_timer.Finish();
+        if (stats != nullptr){
+            stats->documents_returned = matched_documents.size();
+        }
 
-    QueryWord ParseQueryWord(std::string_view text) const;
-    
-    double ComputeWordInverseDocumentFreq(std::string_view word) const;
+        return matched_documents;
+    }
 
+    // A block of FindTopDocumentsBatch holds at most this many queries, and
+    // at most BATCH_MAX_POSTINGS postings of their terms: a block keeps a
+    // contribution per plus posting and a document per minus posting, so
+    // each block in flight takes up to about 4 MiB
+    static constexpr std::size_t BATCH_BLOCK_SIZE = 256;
+    static constexpr std::size_t BATCH_MAX_POSTINGS = std::size_t{1} << 18;
+
+    template <typename Policy>
+    std::vector<std::vector<Document>> FindTopDocumentsBatchImpl(Policy policy,
+                                                                 const std::vector<std::string> &raw_queries,
+                                                                 DocumentStatus status) const;
+    // Evaluates queries [first, last) into results. A query alone in its
+    // block gains nothing from sharing and goes through FindAllDocuments,
+    // which holds one accumulator per document rather than per posting.
+    void EvaluateQueryBlock(const std::vector<CompiledQuery> &queries, std::size_t first, std::size_t last,
+                            DocumentStatus status, std::vector<std::vector<Document>> &results) const;
+
+    // Fills the term and posting counts of stats
+    void CountQueryPostings(const CompiledQuery &query, QueryStats &stats) const;
+
+    // Only the returned vector is allocated outside of resource
     template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy&, const Query &query,
-                                                            DocumentPredicate document_predicate) const{
-        std::map<int, double> document_to_relevance;
-            for (std::string_view word : query.plus_words){
-                if (word_to_document_freqs_.count(word) == 0){continue;}
-
-                const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-                for (const auto [document_id, term_freq] : word_to_document_freqs_.at(word)){
-                    const auto &document_data = documents_.at(document_id);
-                    if (document_predicate(document_id, document_data.status, document_data.rating)){
-                        document_to_relevance[document_id] += term_freq * inverse_document_freq;
-                    }   
+    std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy&, const CompiledQuery &query,
+                                           DocumentPredicate document_predicate,
+                                           std::pmr::memory_resource *resource, QueryStats *stats) const{
+        std::vector<Document> matched_documents;
+        ForEachMatchedDocument(query, document_predicate, [&matched_documents](const Document &document){
+            matched_documents.push_back(document);
+        }, resource, stats);
+        return matched_documents;
+    }
+
+    // Passes every match to consume while the results are built, so callers
+    // that keep only some of them need not hold them all
+    template <typename DocumentPredicate, typename DocumentConsumer>
+    void ForEachMatchedDocument(const CompiledQuery &query, DocumentPredicate document_predicate,
+                                DocumentConsumer consume, std::pmr::memory_resource *resource,
+                                QueryStats *stats) const{
+        if (ChooseStrategy(query, false) == QueryStrategy::BITMAP){
+            ForEachMatchedDocumentBitmap(query, document_predicate, consume, resource, stats);
+            return;
+        }
+        const TraceSpan find_span("FindAllDocuments");
+        const QueryStageMetrics &stages = GetQueryStageMetrics();
+        StageTimer accumulation_timer(stages.accumulation, "search.accumulation",
+                                      stats != nullptr ? &stats->accumulation_ns : nullptr);
+        std::pmr::map<int, double> document_to_relevance(resource);
+        std::size_t rejected_postings = 0;
+        for (const auto [term, inverse_document_freq] : query.plus_terms_){
+            for (const auto [document_id, term_count] : inverted_index_.GetPostings(term)){
+                const auto &document_data = documents_.at(document_id);
+                if (document_predicate(document_id, document_data.status, document_data.rating)){
+                    const double term_freq = term_count * document_data.inv_word_count;
+                    document_to_relevance[document_id] += term_freq * inverse_document_freq;
+                }else{
+                    ++rejected_postings;
                 }
             }
+        }
 
-        for (std::string_view word : query.minus_words){
-            if (word_to_document_freqs_.count(word) != 0){
-                for (const auto [document_id, _] : word_to_document_freqs_.at(word)){
-                    document_to_relevance.erase(document_id);
-                    }
+        accumulation_timer.Finish();
+        const std::size_t scored_documents = document_to_relevance.size();
+
+        StageTimer minus_filtering_timer(stages.minus_filtering, "search.minus_filtering",
+                                         stats != nullptr ? &stats->minus_filtering_ns : nullptr);
+        for (TermId term : query.minus_terms_){
+            for (const auto [document_id, _] : inverted_index_.GetPostings(term)){
+                document_to_relevance.erase(document_id);
+            }
+        }
+        minus_filtering_timer.Finish();
+
+        if (stats != nullptr){
+            CountQueryPostings(query, *stats);
+            stats->postings_rejected_by_predicate = rejected_postings;
+            stats->documents_scored = scored_documents;
+            stats->documents_removed_by_minus = scored_documents - document_to_relevance.size();
+        }
+
+        StageTimer result_building_timer(stages.result_building, "search.result_building",
+                                         stats != nullptr ? &stats->result_building_ns : nullptr);
+        for (const auto [document_id, relevance] : document_to_relevance){
+            consume(Document{document_id, relevance, documents_.at(document_id).rating});
+        }
+    }
+
+    // Like the map version, with relevances summed in the same order and
+    // documents coming out in id order, so the results are identical
+    template <typename DocumentPredicate, typename DocumentConsumer>
+    void ForEachMatchedDocumentBitmap(const CompiledQuery &query, DocumentPredicate document_predicate,
+                                      DocumentConsumer consume, std::pmr::memory_resource *resource,
+                                      QueryStats *stats) const{
+        const TraceSpan find_span("FindAllDocuments");
+        const QueryStageMetrics &stages = GetQueryStageMetrics();
+        StageTimer accumulation_timer(stages.accumulation, "search.accumulation",
+                                      stats != nullptr ? &stats->accumulation_ns : nullptr);
+        const std::size_t id_count = static_cast<std::size_t>(documents_.rbegin()->first) + 1;
+        std::pmr::vector<double> relevances(id_count, 0.0, resource);
+        std::pmr::vector<std::uint64_t> matched((id_count + 63) / 64, 0, resource);
+        std::size_t rejected_postings = 0;
+        for (const auto [term, inverse_document_freq] : query.plus_terms_){
+            for (const auto [document_id, term_count] : inverted_index_.GetPostings(term)){
+                const auto &document_data = documents_.at(document_id);
+                if (document_predicate(document_id, document_data.status, document_data.rating)){
+                    const double term_freq = term_count * document_data.inv_word_count;
+                    relevances[document_id] += term_freq * inverse_document_freq;
+                    matched[document_id >> 6] |= std::uint64_t{1} << (document_id & 63);
+                }else{
+                    ++rejected_postings;
                 }
             }
+        }
+        accumulation_timer.Finish();
+
+        StageTimer minus_filtering_timer(stages.minus_filtering, "search.minus_filtering",
+                                         stats != nullptr ? &stats->minus_filtering_ns : nullptr);
+        std::size_t removed_documents = 0;
+        for (TermId term : query.minus_terms_){
+            for (const auto [document_id, _] : inverted_index_.GetPostings(term)){
+                std::uint64_t &word = matched[document_id >> 6];
+                const std::uint64_t bit = std::uint64_t{1} << (document_id & 63);
+                removed_documents += (word & bit) != 0;
+                word &= ~bit;
+            }
+        }
+        minus_filtering_timer.Finish();
+
+        StageTimer result_building_timer(stages.result_building, "search.result_building",
+                                         stats != nullptr ? &stats->result_building_ns : nullptr);
+        std::size_t matched_count = 0;
+        for (std::size_t index = 0; index < matched.size(); ++index){
+            for (std::uint64_t word = matched[index]; word != 0; word &= word - 1){
+                const int document_id = static_cast<int>(index * 64 + __builtin_ctzll(word));
+                consume(Document{document_id, relevances[document_id], documents_.at(document_id).rating});
+                ++matched_count;
+            }
+        }
+        if (stats != nullptr){
+            CountQueryPostings(query, *stats);
+            stats->strategy = QueryStrategy::BITMAP;
+            stats->postings_rejected_by_predicate = rejected_postings;
+            stats->documents_scored = matched_count + removed_documents;
+            stats->documents_removed_by_minus = removed_documents;
+        }
+    }
 
-        std::vector<Document> matched_documents;
-            for (const auto [document_id, relevance] : document_to_relevance){
-                matched_documents.push_back(
-                        {document_id, relevance, documents_.at(document_id).rating});
+    // Top documents by WAND over cursors on the plus terms' posting lists.
+    // A term contributes at most idf * max_term_freqs_[term], so once
+    // MAX_RESULT_DOCUMENT_COUNT documents are held, the documents whose
+    // terms' bounds add up to less than the lowest relevance held (minus
+    // ACCURACY, for HasHigherRank) are skipped. A document that is
+    // evaluated gets every contribution, summed in query word order, so its
+    // relevance is the one of the exhaustive strategies.
+    template <typename DocumentPredicate>
+    std::vector<Document> FindTopDocumentsWand(const CompiledQuery &query, DocumentPredicate document_predicate,
+                                               std::pmr::memory_resource *resource, QueryStats *stats) const{
+        struct Cursor{
+            const Posting *current;
+            const Posting *end;
+            double max_relevance;
+            double inverse_document_freq;
+            std::uint32_t position;
+        };
+        const TraceSpan find_span("FindTopDocumentsWand");
+        const QueryStageMetrics &stages = GetQueryStageMetrics();
+        StageTimer accumulation_timer(stages.accumulation, "search.accumulation",
+                                      stats != nullptr ? &stats->accumulation_ns : nullptr);
+        std::pmr::vector<Cursor> cursors(resource);
+        for (std::size_t position = 0; position < query.plus_terms_.size(); ++position){
+            const auto [term, inverse_document_freq] = query.plus_terms_[position];
+            const PostingRange postings = inverted_index_.GetPostings(term);
+            if (!postings.empty()){
+                cursors.push_back({postings.begin(), postings.end(), inverse_document_freq * max_term_freqs_[term],
+                                   inverse_document_freq, static_cast<std::uint32_t>(position)});
+            }
+        }
+        const auto by_document = [](const Cursor &lhs, const Cursor &rhs){
+            return lhs.current->document_id < rhs.current->document_id;
+        };
+        const auto is_exhausted = [](const Cursor &cursor){return cursor.current == cursor.end;};
+        std::pmr::vector<double> contributions(query.plus_terms_.size(), 0.0, resource);
+        std::pmr::vector<char> has_contribution(query.plus_terms_.size(), 0, resource);
+
+        std::vector<Document> top_documents;
+        double threshold = 0;
+        std::size_t scanned_postings = 0;
+        std::size_t rejected_postings = 0;
+        std::size_t scored_documents = 0;
+        std::size_t removed_documents = 0;
+        while (!cursors.empty()){
+            std::sort(cursors.begin(), cursors.end(), by_document);
+            // The first cursor at which the documents may reach the top
+            std::size_t pivot = 0;
+            double bound = 0;
+            for (; pivot < cursors.size(); ++pivot){
+                bound += cursors[pivot].max_relevance;
+                if (top_documents.size() < MAX_RESULT_DOCUMENT_COUNT || bound > threshold - ACCURACY){
+                    break;
+                }
+            }
+            if (pivot == cursors.size()){
+                break;
+            }
+            const int pivot_document = cursors[pivot].current->document_id;
+            if (cursors.front().current->document_id != pivot_document){
+                // Documents before the pivot are held by too few terms to make the top
+                for (std::size_t i = 0; i < pivot; ++i){
+                    cursors[i].current = std::lower_bound(cursors[i].current, cursors[i].end, pivot_document,
+                        [](const Posting &posting, int document_id){return posting.document_id < document_id;});
+                    ++scanned_postings;
+                }
+                cursors.erase(std::remove_if(cursors.begin(), cursors.end(), is_exhausted), cursors.end());
+                continue;
             }
 
-        return matched_documents;
-    }
+            const auto &document_data = documents_.at(pivot_document);
+            const bool is_accepted = document_predicate(pivot_document, document_data.status, document_data.rating);
+            for (Cursor &cursor : cursors){
+                if (cursor.current->document_id != pivot_document){
+                    break;
+                }
+                if (is_accepted){
+                    const double term_freq = cursor.current->term_count * document_data.inv_word_count;
+                    contributions[cursor.position] = term_freq * cursor.inverse_document_freq;
+                    has_contribution[cursor.position] = 1;
+                }else{
+                    ++rejected_postings;
+                }
+                ++cursor.current;
+                ++scanned_postings;
+            }
+            cursors.erase(std::remove_if(cursors.begin(), cursors.end(), is_exhausted), cursors.end());
+            if (!is_accepted){
+                continue;
+            }
+            double relevance = 0;
+            for (std::size_t position = 0; position < contributions.size(); ++position){
+                if (has_contribution[position]){
+                    relevance += contributions[position];
+                    has_contribution[position] = 0;
+                }
+            }
+            ++scored_documents;
+            if (std::any_of(query.minus_terms_.begin(), query.minus_terms_.end(), [&](TermId term){
+                    return inverted_index_.Contains(term, pivot_document);
+                })){
+                ++removed_documents;
+                continue;
+            }
 
-        template <typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(std::execution::parallel_policy,const Query &query,
-                                           DocumentPredicate document_predicate) const{
-        ConcurrentMap<int, double> document_to_relevance(100);
-        for_each(std::execution::par, query.plus_words.begin(),query.plus_words.end(), 
-                [&](std::string_view word ){
-            if (word_to_document_freqs_.count(word) != 0){
-                const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-                for_each (word_to_document_freqs_.at(word).begin(),word_to_document_freqs_.at(word).end(),
-                [&](auto it){
-                    const auto &document_data = documents_.at(it.first);
-                if (document_predicate(it.first, document_data.status, document_data.rating)){
-                       document_to_relevance[it.first].ref_to_value += it.second * inverse_document_freq;
+            const Document document{pivot_document, relevance, document_data.rating};
+            if (top_documents.size() < MAX_RESULT_DOCUMENT_COUNT){
+                top_documents.push_back(document);
+            }else{
+                auto lowest = top_documents.begin();
+                for (auto it = top_documents.begin(); it != top_documents.end(); ++it){
+                    if (HasHigherRank(*lowest, *it)){
+                        lowest = it;
                     }
-                }  
-                );
+                }
+                if (!HasHigherRank(document, *lowest)){
+                    continue;
+                }
+                *lowest = document;
             }
+            if (top_documents.size() == MAX_RESULT_DOCUMENT_COUNT){
+                threshold = std::min_element(top_documents.begin(), top_documents.end(),
+                    [](const Document &lhs, const Document &rhs){return lhs.relevance < rhs.relevance;})->relevance;
+            }
+        }
+        accumulation_timer.Finish();
+
+        // In id order like the exhaustive strategies, so sorting ranks them the same way
+        std::sort(top_documents.begin(), top_documents.end(), [](const Document &lhs, const Document &rhs){
+            return lhs.id < rhs.id;
         });
+        if (stats != nullptr){
+            stats->plus_terms = query.plus_terms_.size();
+            stats->minus_terms = query.minus_terms_.size();
+            stats->strategy = QueryStrategy::WAND;
+            stats->postings_scanned = scanned_postings;
+            stats->postings_rejected_by_predicate = rejected_postings;
+            stats->documents_scored = scored_documents;
+            stats->documents_removed_by_minus = removed_documents;
+        }
+        return top_documents;
+    }
 
-        for_each(query.minus_words.begin(),query.minus_words.end(),
-        [&](std::string_view word){
-            if (word_to_document_freqs_.count(word) != 0){
-            for (const auto [document_id, _] : word_to_document_freqs_.at(word)){
-                document_to_relevance.Delete(document_id);
-            }
+    // The accumulator is filled from many threads, so it stays on the default
+    // allocator: the arena is not thread-safe
+    template <typename DocumentPredicate>
+    std::vector<Document> FindAllDocuments(std::execution::parallel_policy,const CompiledQuery &query,
+                                           DocumentPredicate document_predicate,
+                                           std::pmr::memory_resource*, QueryStats *stats) const{
+        const TraceSpan find_span("FindAllDocuments");
+        const QueryStageMetrics &stages = GetQueryStageMetrics();
+        StageTimer accumulation_timer(stages.accumulation, "search.accumulation",
+                                      stats != nullptr ? &stats->accumulation_ns : nullptr);
+        ConcurrentMap<int, double> document_to_relevance(100);
+        std::atomic<std::size_t> rejected_postings = 0;
+        for_each(std::execution::par, query.plus_terms_.begin(),query.plus_terms_.end(),
+                [&](const CompiledQuery::PlusTerm &plus_term){
+            const double inverse_document_freq = plus_term.inverse_document_freq;
+            const auto postings = inverted_index_.GetPostings(plus_term.term);
+            // Shows on which worker every term ran and for how long
+            const TraceSpan term_span("search.accumulate_term", "postings", static_cast<std::int64_t>(postings.size()));
+            std::size_t term_rejected_postings = 0;
+            std::for_each(postings.begin(), postings.end(), [&](const Posting &posting){
+                const auto &document_data = documents_.at(posting.document_id);
+                if (document_predicate(posting.document_id, document_data.status, document_data.rating)){
+                    const double term_freq = posting.term_count * document_data.inv_word_count;
+                    document_to_relevance[posting.document_id].ref_to_value += term_freq * inverse_document_freq;
+                }else{
+                    ++term_rejected_postings;
+                }
+            });
+            rejected_postings.fetch_add(term_rejected_postings, std::memory_order_relaxed);
+        });
+
+        accumulation_timer.Finish();
+
+        StageTimer minus_filtering_timer(stages.minus_filtering, "search.minus_filtering",
+                                         stats != nullptr ? &stats->minus_filtering_ns : nullptr);
+        std::size_t removed_documents = 0;
+        for_each(query.minus_terms_.begin(),query.minus_terms_.end(),
+        [&](TermId term){
+            for (const auto [document_id, _] : inverted_index_.GetPostings(term)){
+                removed_documents += document_to_relevance.Delete(document_id);
             }
         });
-                
-                auto documents_map = document_to_relevance.BuildOrdinaryMap();
+        minus_filtering_timer.Finish();
+
+        StageTimer result_building_timer(stages.result_building, "search.result_building",
+                                         stats != nullptr ? &stats->result_building_ns : nullptr);
+        auto documents_map = document_to_relevance.BuildOrdinaryMap();
+        if (stats != nullptr){
+            CountQueryPostings(query, *stats);
+            stats->postings_rejected_by_predicate = rejected_postings.load(std::memory_order_relaxed);
+            stats->documents_scored = documents_map.size() + removed_documents;
+            stats->documents_removed_by_minus = removed_documents;
+        }
         std::vector<Document> matched_documents;
-        for (const auto [document_id, relevance] : documents_map){   
+        for (const auto [document_id, relevance] : documents_map){
             matched_documents.push_back(
                 {document_id, relevance, documents_.at(document_id).rating});
         }
@@ -215,4 +921,3 @@ private:
         return matched_documents;
     }
 };
-
@@ -0,0 +1,161 @@
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "binary_io.h"
+#include "search_server.h"
+
+namespace {
+
+constexpr char SNAPSHOT_MAGIC[8] = {'S', 'R', 'C', 'H', 'S', 'N', 'A', 'P'};
+// Version 2 stores term counts and word counts in place of tf values,
+// version 3 ends with a CRC-32C of everything after the header
+constexpr std::uint32_t SNAPSHOT_VERSION = 3;
+// Written in native byte order, a snapshot from a machine of other endianness reads it swapped
+constexpr std::uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+struct DocumentRecord{
+    std::int32_t document_id;
+    std::int32_t rating;
+    std::int32_t status;
+    std::uint32_t is_duplicate;
+    std::uint64_t forward_size;
+    DocumentFingerprint fingerprint;
+    std::uint64_t word_count;
+};
+
+} // namespace
+
+void SearchServer::Save(std::ostream &output) const{
+    output.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    WriteValue(output, SNAPSHOT_VERSION);
+    WriteValue(output, BYTE_ORDER_MARK);
+
+    ChecksumStreamBuf checksum_buffer(output.rdbuf());
+    std::ostream payload(&checksum_buffer);
+    WriteStrings(payload, stop_words_);
+    terms_.Save(payload);
+    inverted_index_.Save(payload);
+
+    std::vector<DocumentRecord> records;
+    records.reserve(documents_.size());
+    for (const auto &[document_id, document_data] : documents_){
+        records.push_back({document_id, document_data.rating, static_cast<std::int32_t>(document_data.status),
+                           document_data.is_duplicate, document_data.forward_size, document_data.fingerprint,
+                           document_data.word_count});
+    }
+    WriteVector(payload, records);
+    // Forward indexes packed in the order of the records
+    WriteValue<std::uint64_t>(payload, forward_entries_.size() - dead_forward_entries_);
+    for (const auto &[_, document_data] : documents_){
+        WriteArray(payload, forward_entries_.data() + document_data.forward_offset, document_data.forward_size);
+    }
+    WriteVector(payload, std::vector<int>(document_ids_.begin(), document_ids_.end()));
+    WriteValue(payload, static_cast<std::int32_t>(duplicate_policy_));
+    WriteValue(output, checksum_buffer.GetChecksum());
+
+    if (!payload || !output){
+        throw std::runtime_error("Failed to write the snapshot");
+    }
+}
+
+SearchServer SearchServer::Load(std::istream &input){
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    ReadArray(input, magic, sizeof(magic));
+    if (!std::equal(magic, magic + sizeof(magic), SNAPSHOT_MAGIC)){
+        throw std::invalid_argument("Not a search server snapshot");
+    }
+    if (ReadValue<std::uint32_t>(input) != SNAPSHOT_VERSION){
+        throw std::invalid_argument("Unsupported snapshot version");
+    }
+    if (ReadValue<std::uint32_t>(input) != BYTE_ORDER_MARK){
+        throw std::invalid_argument("Snapshot was written with another byte order");
+    }
+
+    // Everything is range checked while it is read, the checksum catches
+    // damage the checks cannot see
+    ChecksumStreamBuf checksum_buffer(input.rdbuf());
+    std::istream payload(&checksum_buffer);
+    SearchServer search_server(ReadStrings(payload));
+    search_server.terms_.Load(payload);
+    search_server.inverted_index_.Load(payload);
+    if (search_server.inverted_index_.GetTermCount() > search_server.terms_.size()){
+        throw std::invalid_argument("Snapshot postings refer to unknown terms");
+    }
+
+    const auto records = ReadVector<DocumentRecord>(payload);
+    search_server.forward_entries_ = ReadVector<ForwardEntry>(payload, ReadValue<std::uint64_t>(payload));
+    const std::vector<ForwardEntry> &forward_entries = search_server.forward_entries_;
+    const InvertedIndex &inverted_index = search_server.inverted_index_;
+    // Postings must be the inverse of the forward indexes: going through the
+    // documents in id order takes every posting list from front to back
+    std::vector<std::uint32_t> consumed_postings(inverted_index.GetTermCount(), 0);
+    std::size_t forward_offset = 0;
+    for (std::size_t i = 0; i < records.size(); ++i){
+        const DocumentRecord &record = records[i];
+        if (record.document_id < 0 || (i > 0 && record.document_id <= records[i - 1].document_id)
+            || record.status < static_cast<std::int32_t>(DocumentStatus::ACTUAL)
+            || record.status > static_cast<std::int32_t>(DocumentStatus::REMOVED)
+            || record.word_count == 0 || record.word_count > UINT32_MAX
+            || record.forward_size > forward_entries.size() - forward_offset){
+            throw std::invalid_argument("Damaged snapshot document record");
+        }
+        // Terms strictly ascending and known, term counts adding up to the word count
+        const auto first = forward_entries.begin() + forward_offset;
+        const auto last = first + record.forward_size;
+        std::uint64_t word_count = 0;
+        for (auto entry = first; entry != last; ++entry){
+            if (entry->term >= inverted_index.GetTermCount() || entry->term_count == 0
+                || (entry != first && entry->term <= std::prev(entry)->term)){
+                throw std::invalid_argument("Damaged snapshot forward index");
+            }
+            const PostingRange postings = inverted_index.GetPostings(entry->term);
+            const std::uint32_t index = consumed_postings[entry->term]++;
+            if (index >= postings.size() || postings.begin()[index].document_id != record.document_id
+                || postings.begin()[index].term_count != entry->term_count){
+                throw std::invalid_argument("Snapshot postings do not match the forward index");
+            }
+            word_count += entry->term_count;
+        }
+        if (word_count != record.word_count){
+            throw std::invalid_argument("Damaged snapshot forward index");
+        }
+        // Records are sorted by id, so every insertion goes to the end of the map
+        search_server.documents_.emplace_hint(search_server.documents_.end(), record.document_id,
+            DocumentData{record.rating, static_cast<DocumentStatus>(record.status),
+                         forward_offset, record.forward_size, record.fingerprint, record.is_duplicate != 0,
+                         static_cast<std::uint32_t>(record.word_count), 1.0 / record.word_count});
+        forward_offset += record.forward_size;
+    }
+    if (forward_offset != forward_entries.size()){
+        throw std::invalid_argument("Snapshot forward index does not match the documents");
+    }
+    for (TermId term = 0; term < inverted_index.GetTermCount(); ++term){
+        if (consumed_postings[term] != inverted_index.GetPostings(term).size()){
+            throw std::invalid_argument("Snapshot postings do not match the forward index");
+        }
+    }
+
+    auto document_ids = ReadVector<int>(payload);
+    search_server.document_ids_.assign(document_ids.begin(), document_ids.end());
+    std::sort(document_ids.begin(), document_ids.end());
+    if (!std::equal(document_ids.begin(), document_ids.end(), records.begin(), records.end(),
+                    [](int document_id, const DocumentRecord &record){return document_id == record.document_id;})){
+        throw std::invalid_argument("Snapshot document ids do not match the documents");
+    }
+    const auto duplicate_policy = ReadValue<std::int32_t>(payload);
+    if (duplicate_policy < static_cast<std::int32_t>(DuplicatePolicy::ALLOW)
+        || duplicate_policy > static_cast<std::int32_t>(DuplicatePolicy::REJECT)){
+        throw std::invalid_argument("Damaged snapshot duplicate policy");
+    }
+    const std::uint32_t checksum = checksum_buffer.GetChecksum();
+    if (ReadValue<std::uint32_t>(input) != checksum){
+        throw std::invalid_argument("Snapshot checksum mismatch");
+    }
+    search_server.SetDuplicatePolicy(static_cast<DuplicatePolicy>(duplicate_policy));
+    // Not stored, the bounds follow from the forward index
+    search_server.RebuildTermBounds();
+    return search_server;
+}
@@ -0,0 +1,26 @@
+#include <iostream>
+#include "test_example_functions.h"
+
+int main(){
+    TestStringProcessing();
+    TestStopWords();
+    TestTermDictionary();
+    TestSearchServer();
+    TestNearDuplicates();
+    TestSnapshots();
+    TestMappedIndex();
+    TestWriteAheadLog();
+    TestCorpusLoader();
+    TestPagination();
+    TestQueryArena();
+    TestMetrics();
+    TestTracing();
+    TestMemoryStats();
+    TestQueryStats();
+    TestPerfCounters();
+    TestQueryLog();
+    TestQueryBatch();
+    TestQueryPlanner();
+    std::cerr << "All tests passed" << std::endl;
+    return 0;
+}
@@ -0,0 +1,36 @@
+#include "stop_words.h"
+
+void StopWordSet::Reserve(std::size_t count){
+    std::size_t slot_count = 16;
+    while (slot_count < 2 * count){
+        slot_count *= 2;
+    }
+    // About 16 bits per word keeps false positives near 1%, 512 bits is one cache line
+    std::size_t bloom_bits = 512;
+    while (bloom_bits < 16 * count){
+        bloom_bits *= 2;
+    }
+    words_.reserve(count);
+    slots_.assign(slot_count, Slot{});
+    bloom_.assign(bloom_bits / 64, 0);
+    slot_mask_ = slot_count - 1;
+    bloom_mask_ = bloom_bits - 1;
+}
+
+void StopWordSet::Insert(std::string_view word){
+    if (word.empty() || Contains(word)){
+        return;
+    }
+    const std::uint64_t hash = HashString(word);
+    std::size_t slot = hash & slot_mask_;
+    while (slots_[slot].index != EMPTY_SLOT){
+        slot = (slot + 1) & slot_mask_;
+    }
+    slots_[slot] = {hash, static_cast<std::uint32_t>(words_.size())};
+    words_.emplace_back(word);
+
+    const std::size_t first = FirstBloomBit(hash);
+    const std::size_t second = SecondBloomBit(hash);
+    bloom_[first / 64] |= std::uint64_t{1} << (first % 64);
+    bloom_[second / 64] |= std::uint64_t{1} << (second % 64);
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "hashing.h"
+
+// Stop word set built once at SearchServer construction.
+// A Bloom filter of a few cache lines rejects most words before the
+// open addressing table is touched.
+class StopWordSet{
+public:
+    StopWordSet() = default;
+
+    // Empty strings and repeated words are skipped
+    template <typename StringContainer>
+    explicit StopWordSet(const StringContainer &words){
+        std::size_t count = 0;
+        for (const auto &word : words){
+            (void)word;
+            ++count;
+        }
+        Reserve(count);
+        for (const auto &word : words){
+            Insert(std::string_view{word});
+        }
+    }
+
+    bool Contains(std::string_view word) const{
+        if (words_.empty()){
+            return false;
+        }
+        const std::uint64_t hash = HashString(word);
+        if (!MayContain(hash)){
+            return false;
+        }
+        for (std::size_t slot = hash & slot_mask_; slots_[slot].index != EMPTY_SLOT;
+                                                    slot = (slot + 1) & slot_mask_){
+            if (slots_[slot].hash == hash && words_[slots_[slot].index] == word){
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::size_t size() const{return words_.size();}
+    bool empty() const{return words_.empty();}
+    std::vector<std::string>::const_iterator begin() const{return words_.begin();}
+    std::vector<std::string>::const_iterator end() const{return words_.end();}
+
+private:
+    static constexpr std::uint32_t EMPTY_SLOT = UINT32_MAX;
+
+    struct Slot{
+        std::uint64_t hash = 0;
+        std::uint32_t index = EMPTY_SLOT;
+    };
+
+    std::vector<std::string> words_;
+    std::vector<Slot> slots_;
+    std::vector<std::uint64_t> bloom_;
+    std::size_t slot_mask_ = 0;
+    std::size_t bloom_mask_ = 0;
+
+    // Two filter bits per word, taken from hash bits the table does not use first
+    std::size_t FirstBloomBit(std::uint64_t hash) const{return (hash >> 32) & bloom_mask_;}
+    std::size_t SecondBloomBit(std::uint64_t hash) const{return (hash >> 20) & bloom_mask_;}
+
+    bool MayContain(std::uint64_t hash) const{
+        const std::size_t first = FirstBloomBit(hash);
+        const std::size_t second = SecondBloomBit(hash);
+        return (bloom_[first / 64] >> (first % 64) & 1u) != 0
+            && (bloom_[second / 64] >> (second % 64) & 1u) != 0;
+    }
+
+    void Reserve(std::size_t count);
+    void Insert(std::string_view word);
+};
+
+// Stop word table for lists known at compile time:
+//     constexpr std::string_view STOP_WORDS[] = {"in"sv, "the"sv};
+//     constexpr ConstexprStopWords stop_words(STOP_WORDS);
+//     static_assert(stop_words.Contains("the"sv));
+// It is iterable, so a SearchServer can be constructed from it as well.
+template <std::size_t N>
+class ConstexprStopWords{
+public:
+    constexpr explicit ConstexprStopWords(const std::string_view (&words)[N]){
+        for (std::size_t i = 0; i < N; ++i){
+            words_[i] = words[i];
+            if (words[i].empty() || Contains(words[i])){
+                continue;
+            }
+            const std::uint64_t hash = HashString(words[i]);
+            std::size_t slot = hash & (TABLE_SIZE - 1);
+            while (slots_[slot] != 0){
+                slot = (slot + 1) & (TABLE_SIZE - 1);
+            }
+            slots_[slot] = i + 1;
+            hashes_[slot] = hash;
+        }
+    }
+
+    constexpr bool Contains(std::string_view word) const{
+        const std::uint64_t hash = HashString(word);
+        for (std::size_t slot = hash & (TABLE_SIZE - 1); slots_[slot] != 0;
+                                                        slot = (slot + 1) & (TABLE_SIZE - 1)){
+            if (hashes_[slot] == hash && words_[slots_[slot] - 1] == word){
+                return true;
+            }
+        }
+        return false;
+    }
+
+    constexpr std::size_t size() const{return N;}
+    constexpr const std::string_view *begin() const{return words_.data();}
+    constexpr const std::string_view *end() const{return words_.data() + N;}
+
+private:
+    static constexpr std::size_t ComputeTableSize(){
+        std::size_t size = 2;
+        while (size < 2 * N){
+            size *= 2;
+        }
+        return size;
+    }
+
+    static constexpr std::size_t TABLE_SIZE = ComputeTableSize();
+
+    std::array<std::string_view, N> words_{};
+    std::array<std::uint64_t, TABLE_SIZE> hashes_{};
+    // Index of the word plus one, zero marks an empty slot
+    std::array<std::size_t, TABLE_SIZE> slots_{};
+};
+
+template <std::size_t N>
+ConstexprStopWords(const std::string_view (&)[N]) -> ConstexprStopWords<N>;
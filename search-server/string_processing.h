@@ -1,14 +1,20 @@
 #pragma once
+#include <algorithm>
 #include <set>
 #include <string>
 #include <string_view>
 #include <deque>
+#include <cstdint>
+#include <cstddef>
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
 
 template <typename StringContainer>
 std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContainer& strings) {
     std::set<std::string, std::less<>> non_empty_strings{};
-    for (const auto& sv : strings) { 
-        if (!sv.empty()) { 
+    for (const auto& sv : strings) {
+        if (!sv.empty()) {
             non_empty_strings.insert(std::string{ sv });
         }
     }
@@ -17,6 +23,126 @@ std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(const StringContain
 
 std::deque<std::string_view> SplitIntoWords(std::string_view str);
 
+namespace tokenizer_detail {
+
+// Bit i of a mask describes byte i of the scanned block
+struct BlockMasks{
+    std::uint32_t spaces;
+    std::uint32_t controls;
+};
+
+#if defined(__AVX2__)
+constexpr std::size_t BLOCK_SIZE = 32;
+
+inline BlockMasks ScanBlock(const char* data){
+    const __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data));
+    const __m256i spaces = _mm256_cmpeq_epi8(bytes, _mm256_set1_epi8(' '));
+    // Control characters are the bytes 0x00..0x1F, i.e. signed values in [0, 32)
+    const __m256i controls = _mm256_andnot_si256(
+        _mm256_cmpgt_epi8(bytes, _mm256_set1_epi8(' ' - 1)),
+        _mm256_cmpgt_epi8(bytes, _mm256_set1_epi8(-1)));
+    return {static_cast<std::uint32_t>(_mm256_movemask_epi8(spaces)),
+            static_cast<std::uint32_t>(_mm256_movemask_epi8(controls))};
+}
+#elif defined(__SSE2__) || defined(_M_X64)
+constexpr std::size_t BLOCK_SIZE = 16;
+
+inline BlockMasks ScanBlock(const char* data){
+    const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+    const __m128i spaces = _mm_cmpeq_epi8(bytes, _mm_set1_epi8(' '));
+    const __m128i controls = _mm_andnot_si128(
+        _mm_cmpgt_epi8(bytes, _mm_set1_epi8(' ' - 1)),
+        _mm_cmpgt_epi8(bytes, _mm_set1_epi8(-1)));
+    return {static_cast<std::uint32_t>(_mm_movemask_epi8(spaces)),
+            static_cast<std::uint32_t>(_mm_movemask_epi8(controls))};
+}
+#else
+constexpr std::size_t BLOCK_SIZE = 16;
+
+inline BlockMasks ScanBlock(const char* data){
+    BlockMasks masks{0, 0};
+    for (std::size_t i = 0; i < BLOCK_SIZE; ++i){
+        masks.spaces |= static_cast<std::uint32_t>(data[i] == ' ') << i;
+        masks.controls |= static_cast<std::uint32_t>(data[i] >= '\0' && data[i] < ' ') << i;
+    }
+    return masks;
+}
+#endif
+
+// Scalar scan of the last, incomplete block
+inline BlockMasks ScanTail(const char* data, std::size_t size){
+    BlockMasks masks{0, 0};
+    for (std::size_t i = 0; i < size; ++i){
+        masks.spaces |= static_cast<std::uint32_t>(data[i] == ' ') << i;
+        masks.controls |= static_cast<std::uint32_t>(data[i] >= '\0' && data[i] < ' ') << i;
+    }
+    return masks;
+}
+
+inline int CountTrailingZeros(std::uint32_t mask){
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    int count = 0;
+    while ((mask & 1u) == 0){
+        mask >>= 1;
+        ++count;
+    }
+    return count;
+#endif
+}
+
+} // namespace tokenizer_detail
+
+// Calls callback(word, is_valid) for every space separated word of text.
+// is_valid is false when the word contains control characters (see IsValidWord).
+// Word boundaries are found with SIMD bitmask scanning, nothing is allocated.
+template <typename Callback>
+void ForEachWord(std::string_view text, Callback&& callback){
+    using namespace tokenizer_detail;
+    const char* data = text.data();
+    const std::size_t size = text.size();
+    std::size_t word_begin = 0;
+    bool in_word = false;
+    bool word_valid = true;
+
+    for (std::size_t block = 0; block < size; block += BLOCK_SIZE){
+        const std::size_t block_size = std::min(BLOCK_SIZE, size - block);
+        const BlockMasks masks = block_size == BLOCK_SIZE ? ScanBlock(data + block)
+                                                          : ScanTail(data + block, block_size);
+        const std::uint32_t in_block = block_size == 32 ? ~0u : (1u << block_size) - 1;
+        std::uint32_t remaining = in_block;
+        while (remaining != 0){
+            if (!in_word){
+                const std::uint32_t starts = ~masks.spaces & remaining;
+                if (starts == 0){
+                    break;
+                }
+                const int start = CountTrailingZeros(starts);
+                word_begin = block + start;
+                word_valid = true;
+                in_word = true;
+                remaining &= ~0u << start;
+            }else{
+                const std::uint32_t ends = masks.spaces & remaining;
+                if (ends == 0){
+                    word_valid = word_valid && (masks.controls & remaining) == 0;
+                    break;
+                }
+                const int end = CountTrailingZeros(ends);
+                const std::uint32_t word_bits = remaining & ~(~0u << end);
+                word_valid = word_valid && (masks.controls & word_bits) == 0;
+                callback(text.substr(word_begin, block + end - word_begin), word_valid);
+                in_word = false;
+                remaining &= ~0u << end;
+            }
+        }
+    }
+    if (in_word){
+        callback(text.substr(word_begin), word_valid);
+    }
+}
+
 template <typename It>
 struct IteratorRange{
     IteratorRange(It begin_in, It end_in)
@@ -25,4 +151,4 @@ struct IteratorRange{
 
     It begin;
     It end;
-};
\ No newline at end of file
+};
@@ -0,0 +1,160 @@
+#include "term_dictionary.h"
+#include "binary_io.h"
+#include <algorithm>
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+TermDictionary::TermDictionary(){
+    Rehash(GROUP_SIZE);
+}
+
+TermId TermDictionary::Find(std::string_view term) const{
+    return Find(term, HashString(term));
+}
+
+TermId TermDictionary::Insert(std::string_view term){
+    return Insert(term, false);
+}
+
+TermId TermDictionary::InsertBorrowed(std::string_view term){
+    return Insert(term, true);
+}
+
+TermId TermDictionary::Insert(std::string_view term, bool is_borrowed){
+    const std::uint64_t hash = HashString(term);
+    const TermId found = Find(term, hash);
+    if (found != NO_TERM){
+        return found;
+    }
+    // Keep the load factor under 7/8
+    if ((terms_.size() + 1) * 8 > slots_.size() * 7){
+        Rehash(slots_.size() * 2);
+    }
+    const TermId id = static_cast<TermId>(terms_.size());
+    terms_.push_back(is_borrowed ? term : StoreTerm(term));
+    hashes_.push_back(hash);
+    PlaceInSlot(id, hash);
+    return id;
+}
+
+// Bit i is set when control byte i of the group equals value
+std::uint32_t TermDictionary::MatchGroup(std::size_t group, std::int8_t value) const{
+#if defined(__SSE2__) || defined(_M_X64)
+    const __m128i control = _mm_loadu_si128(reinterpret_cast<const __m128i*>(control_.data() + group));
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(value))));
+#else
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < GROUP_SIZE; ++i){
+        mask |= static_cast<std::uint32_t>(control_[group + i] == value) << i;
+    }
+    return mask;
+#endif
+}
+
+TermId TermDictionary::Find(std::string_view term, std::uint64_t hash) const{
+    const std::int8_t h2 = H2(hash);
+    std::size_t group = H1(hash) & slot_mask_ & ~(GROUP_SIZE - 1);
+    for (std::size_t step = GROUP_SIZE; ; step += GROUP_SIZE){
+        for (std::uint32_t match = MatchGroup(group, h2); match != 0; match &= match - 1){
+            const TermId id = slots_[group + __builtin_ctz(match)];
+            if (hashes_[id] == hash && terms_[id] == term){
+                return id;
+            }
+        }
+        if (MatchGroup(group, EMPTY) != 0){
+            return NO_TERM;
+        }
+        // Triangular probing visits every group of a power of two table
+        group = (group + step) & slot_mask_;
+    }
+}
+
+void TermDictionary::PlaceInSlot(TermId id, std::uint64_t hash){
+    std::size_t group = H1(hash) & slot_mask_ & ~(GROUP_SIZE - 1);
+    for (std::size_t step = GROUP_SIZE; ; step += GROUP_SIZE){
+        const std::uint32_t empty = MatchGroup(group, EMPTY);
+        if (empty != 0){
+            const std::size_t slot = group + __builtin_ctz(empty);
+            control_[slot] = H2(hash);
+            slots_[slot] = id;
+            return;
+        }
+        group = (group + step) & slot_mask_;
+    }
+}
+
+void TermDictionary::Rehash(std::size_t slot_count){
+    control_.assign(slot_count, EMPTY);
+    slots_.assign(slot_count, NO_TERM);
+    slot_mask_ = slot_count - 1;
+    for (TermId id = 0; id < terms_.size(); ++id){
+        PlaceInSlot(id, hashes_[id]);
+    }
+}
+
+std::size_t TermDictionary::GetTableBytes() const{
+    return control_.capacity() * sizeof(std::int8_t) + slots_.capacity() * sizeof(TermId)
+        + terms_.capacity() * sizeof(std::string_view) + hashes_.capacity() * sizeof(std::uint64_t)
+        + chunks_.capacity() * sizeof(std::unique_ptr<char[]>);
+}
+
+void TermDictionary::Save(std::ostream &output) const{
+    WriteStrings(output, terms_);
+    WriteVector(output, hashes_);
+}
+
+void TermDictionary::Load(std::istream &input){
+    const auto lengths = ReadVector<std::uint32_t>(input);
+    std::size_t text_size = 0;
+    for (std::uint32_t length : lengths){
+        text_size += length;
+    }
+    const auto text_read = ReadVector<char>(input, text_size);
+    auto text = std::make_unique<char[]>(std::max<std::size_t>(text_size, 1));
+    std::copy(text_read.begin(), text_read.end(), text.get());
+    auto hashes = ReadVector<std::uint64_t>(input);
+    if (hashes.size() != lengths.size()){
+        throw std::invalid_argument("Term hashes do not match the terms");
+    }
+
+    terms_.clear();
+    terms_.reserve(lengths.size());
+    const char *term = text.get();
+    for (std::size_t id = 0; id < lengths.size(); ++id){
+        terms_.emplace_back(term, lengths[id]);
+        term += lengths[id];
+        if (hashes[id] != HashString(terms_.back())){
+            terms_.clear();
+            throw std::invalid_argument("Term hashes do not match the terms");
+        }
+    }
+    hashes_ = std::move(hashes);
+    chunks_.clear();
+    chunks_.push_back(std::move(text));
+    chunk_bytes_ = std::max<std::size_t>(text_size, 1);
+    chunk_end_ = nullptr;
+    chunk_free_ = 0;
+
+    std::size_t slot_count = GROUP_SIZE;
+    while ((terms_.size() + 1) * 8 > slot_count * 7){
+        slot_count *= 2;
+    }
+    Rehash(slot_count);
+}
+
+// Term text lives in large chunks, so adding a term rarely allocates
+std::string_view TermDictionary::StoreTerm(std::string_view term){
+    if (term.size() > chunk_free_){
+        const std::size_t chunk_size = std::max(CHUNK_SIZE, term.size());
+        chunks_.push_back(std::make_unique<char[]>(chunk_size));
+        chunk_bytes_ += chunk_size;
+        chunk_free_ = chunk_size;
+        chunk_end_ = chunks_.back().get() + chunk_size;
+    }
+    char *data = chunk_end_ - chunk_free_;
+    std::memcpy(data, term.data(), term.size());
+    chunk_free_ -= term.size();
+    return {data, term.size()};
+}
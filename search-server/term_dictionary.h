@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string_view>
+#include <vector>
+#include "hashing.h"
+
+using TermId = std::uint32_t;
+constexpr TermId NO_TERM = UINT32_MAX;
+
+// Maps every distinct word of the index to a dense TermId.
+// Swiss table layout: one control byte per slot holding 7 bits of the hash,
+// probed 16 slots at a time, so a lookup compares strings only for slots
+// whose control byte already matches. Terms are never removed.
+class TermDictionary{
+public:
+    TermDictionary();
+    // Terms are views into chunks the dictionary owns, a copy would point
+    // into the original; moving keeps the chunks and so the views
+    TermDictionary(const TermDictionary&) = delete;
+    TermDictionary &operator=(const TermDictionary&) = delete;
+    TermDictionary(TermDictionary&&) = default;
+    TermDictionary &operator=(TermDictionary&&) = default;
+
+    // NO_TERM when the term is unknown
+    TermId Find(std::string_view term) const;
+    // Returns the id of the term, copying it into the dictionary when it is new
+    TermId Insert(std::string_view term);
+    // Like Insert, but a new term is stored as a view of the given text,
+    // which must outlive the dictionary
+    TermId InsertBorrowed(std::string_view term);
+
+    // The view stays valid for the lifetime of the dictionary (or of the borrowed text)
+    std::string_view GetTerm(TermId id) const{return terms_[id];}
+    // HashString of the term
+    std::uint64_t GetHash(TermId id) const{return hashes_[id];}
+    std::size_t size() const{return terms_.size();}
+
+    // Bytes held by the hash table and the per-term arrays
+    std::size_t GetTableBytes() const;
+    // Bytes of the chunks holding copied term text
+    std::size_t GetTextBytes() const{return chunk_bytes_;}
+
+    // Binary form: term lengths, term text and hashes, each in one block.
+    // Load replaces the contents and allocates one chunk for all the text.
+    void Save(std::ostream &output) const;
+    void Load(std::istream &input);
+
+private:
+    static constexpr std::size_t GROUP_SIZE = 16;
+    static constexpr std::size_t CHUNK_SIZE = 64 * 1024;
+    static constexpr std::int8_t EMPTY = -128;
+
+    std::vector<std::int8_t> control_;
+    std::vector<TermId> slots_;
+    std::size_t slot_mask_ = 0;
+
+    std::vector<std::string_view> terms_;
+    std::vector<std::uint64_t> hashes_;
+
+    std::vector<std::unique_ptr<char[]>> chunks_;
+    char *chunk_end_ = nullptr;
+    std::size_t chunk_free_ = 0;
+    std::size_t chunk_bytes_ = 0;
+
+    static std::size_t H1(std::uint64_t hash){return static_cast<std::size_t>(hash >> 7);}
+    static std::int8_t H2(std::uint64_t hash){return static_cast<std::int8_t>(hash & 0x7F);}
+
+    TermId Insert(std::string_view term, bool is_borrowed);
+    std::uint32_t MatchGroup(std::size_t group, std::int8_t value) const;
+    TermId Find(std::string_view term, std::uint64_t hash) const;
+    void PlaceInSlot(TermId id, std::uint64_t hash);
+    void Rehash(std::size_t slot_count);
+    std::string_view StoreTerm(std::string_view term);
+};
@@ -0,0 +1,96 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "corpus_loader.h"
+#include "search_server.h"
+#include "test_example_functions.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+const std::vector<std::string> QUERIES = {"cat"s, "dog -collar"s, "word3 word7"s, "common"s};
+
+// A corpus and the server its documents should produce
+std::string MakeCorpus(SearchServer &expected){
+    std::string corpus;
+    for (int id = 0; id < 50; ++id){
+        const DocumentStatus status = static_cast<DocumentStatus>(id % 4);
+        const std::vector<int> ratings = id % 5 == 0 ? std::vector<int>{} : std::vector<int>{id, -id, 7};
+        const std::string text = "word"s + std::to_string(id % 11) + " common"s + (id % 3 == 0 ? " cat"s : " dog collar"s);
+        expected.AddDocument(id * 3, text, status, ratings);
+
+        static const char *STATUS_NAMES[] = {"ACTUAL", "IRRELEVANT", "BANNED", "REMOVED"};
+        corpus += std::to_string(id * 3) + "\t"s + STATUS_NAMES[id % 4] + "\t"s;
+        for (std::size_t i = 0; i < ratings.size(); ++i){
+            corpus += (i > 0 ? " "s : ""s) + std::to_string(ratings[i]);
+        }
+        corpus += "\t"s + text + (id % 7 == 0 ? "\r\n"s : "\n"s);
+        if (id % 10 == 0){
+            corpus += "\n"s;
+        }
+    }
+    return corpus;
+}
+
+// Chunks of any size, down to one byte, give the documents of single calls in order
+void TestMatchesSingleCalls(){
+    SearchServer expected("and"s);
+    const std::string corpus = MakeCorpus(expected);
+    for (const std::size_t chunk_size : {std::size_t{1}, std::size_t{7}, std::size_t{100}, corpus.size() * 2}){
+        SearchServer loaded("and"s);
+        ASSERT_EQUAL(LoadCorpusFromBuffer(loaded, corpus, {chunk_size}), 50u);
+        AssertSameResults(loaded, expected, QUERIES);
+    }
+    // The last line may lack its line break
+    SearchServer loaded("and"s);
+    ASSERT_EQUAL(LoadCorpusFromBuffer(loaded, "1\tACTUAL\t5\tcat"s), 1u);
+    ASSERT_EQUAL(loaded.FindTopDocuments("cat"s).size(), 1u);
+}
+
+void TestLoadsFiles(){
+    SearchServer expected("and"s);
+    const std::string corpus = MakeCorpus(expected);
+    const std::string path = MakeTempPath("corpus.tsv");
+    WriteFile(path, corpus);
+    SearchServer loaded("and"s);
+    ASSERT_EQUAL(LoadCorpus(loaded, path, {64}), 50u);
+    AssertSameResults(loaded, expected, QUERIES);
+
+    // Texts may borrow from a corpus that outlives the server
+    SearchServer borrowing("and"s);
+    borrowing.BorrowText(corpus);
+    ASSERT_EQUAL(LoadCorpusFromBuffer(borrowing, corpus, {64}), 50u);
+    AssertSameResults(borrowing, expected, QUERIES);
+    std::remove(path.c_str());
+
+    SearchServer search_server(""s);
+    ASSERT_THROWS(LoadCorpus(search_server, path), std::runtime_error);
+}
+
+// Documents before a malformed record stay added
+void TestRejectsMalformedRecords(){
+    const std::string valid = "1\tACTUAL\t1 2\tcat\n2\tBANNED\t\tdog\n"s;
+    for (const std::string &malformed : {"x\tACTUAL\t1\tbird\n"s, "3\tNEW\t1\tbird\n"s, "3\tACTUAL\t1 z\tbird\n"s,
+                                         "3\tACTUAL\tbird\n"s, "3 ACTUAL 1 bird\n"s}){
+        for (const std::size_t chunk_size : {std::size_t{1}, std::size_t{1} << 20}){
+            SearchServer search_server(""s);
+            ASSERT_THROWS(LoadCorpusFromBuffer(search_server, valid + malformed + "4\tACTUAL\t\tfish\n"s, {chunk_size}),
+                          std::invalid_argument);
+            ASSERT_EQUAL_HINT(search_server.GetDocumentCount(), 2, malformed);
+            ASSERT(search_server.FindTopDocuments("fish"s).empty());
+        }
+    }
+    // Duplicate ids are rejected like in AddDocument
+    SearchServer search_server(""s);
+    ASSERT_THROWS(LoadCorpusFromBuffer(search_server, valid + "1\tACTUAL\t\tfish\n"s), std::invalid_argument);
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 2);
+}
+
+} // namespace
+
+void TestCorpusLoader(){
+    RUN_TEST(TestMatchesSingleCalls);
+    RUN_TEST(TestLoadsFiles);
+    RUN_TEST(TestRejectsMalformedRecords);
+}
@@ -0,0 +1,93 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <unistd.h>
+#include "hashing.h"
+#include "search_server.h"
+#include "test_example_functions.h"
+
+void AssertImpl(bool value, const std::string &expr_str, const std::string &file, const std::string &func,
+                unsigned line, const std::string &hint){
+    if (!value){
+        std::cerr << file << "(" << line << "): " << func << ": ";
+        std::cerr << "ASSERT(" << expr_str << ") failed.";
+        if (!hint.empty()){
+            std::cerr << " Hint: " << hint;
+        }
+        std::cerr << std::endl;
+        std::abort();
+    }
+}
+
+bool AreSameDocuments(const std::vector<Document> &lhs, const std::vector<Document> &rhs){
+    if (lhs.size() != rhs.size()){
+        return false;
+    }
+    for (std::size_t i = 0; i < lhs.size(); ++i){
+        if (lhs[i].id != rhs[i].id || lhs[i].relevance != rhs[i].relevance || lhs[i].rating != rhs[i].rating){
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string PrintDocumentIds(const std::vector<Document> &documents){
+    std::ostringstream output;
+    output << '[';
+    for (std::size_t i = 0; i < documents.size(); ++i){
+        output << (i > 0 ? ", " : "") << documents[i].id;
+    }
+    output << ']';
+    return output.str();
+}
+
+std::string MakeWords(std::mt19937 &generator, int count, double probability){
+    std::geometric_distribution<int> word_distribution(probability);
+    std::string text;
+    for (int i = 0; i < count; ++i){
+        text += " w" + std::to_string(word_distribution(generator));
+    }
+    return text;
+}
+
+std::string ReadFile(const std::string &path){
+    std::ifstream input(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+}
+
+void WriteFile(const std::string &path, const std::string &contents){
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output.write(contents.data(), contents.size());
+}
+
+void AssertSameResults(const SearchServer &lhs, const SearchServer &rhs, const std::vector<std::string> &queries){
+    ASSERT_EQUAL(lhs.GetDocumentCount(), rhs.GetDocumentCount());
+    for (const std::string &query : queries){
+        for (int status = 0; status < 4; ++status){
+            ASSERT_HINT(AreSameDocuments(lhs.FindTopDocuments(query, static_cast<DocumentStatus>(status)),
+                                         rhs.FindTopDocuments(query, static_cast<DocumentStatus>(status))), query);
+        }
+    }
+    for (const int document_id : rhs){
+        ASSERT(lhs.GetWordFrequencies(document_id).size() == rhs.GetWordFrequencies(document_id).size());
+    }
+}
+
+void UpdateSnapshotChecksum(std::string &snapshot){
+    // A CRC-32C of everything between the 16 byte header and the checksum itself
+    constexpr std::size_t HEADER_SIZE = 16;
+    const std::uint32_t checksum = ComputeCrc32c(
+        std::string_view(snapshot).substr(HEADER_SIZE, snapshot.size() - HEADER_SIZE - sizeof(std::uint32_t)));
+    std::memcpy(snapshot.data() + snapshot.size() - sizeof(checksum), &checksum, sizeof(checksum));
+}
+
+std::string MakeTempPath(std::string_view name){
+    const std::filesystem::path path = std::filesystem::temp_directory_path()
+        / ("search_server_tests_" + std::to_string(getpid()) + "_" + std::string{name});
+    std::filesystem::remove(path);
+    return path.string();
+}
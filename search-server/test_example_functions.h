@@ -0,0 +1,111 @@
+#pragma once
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "document.h"
+
+class SearchServer;
+
+// Minimal assertion framework for search_server_tests. A failed assertion
+// prints where it happened and aborts, so ctest reports the test as failed.
+
+void AssertImpl(bool value, const std::string &expr_str, const std::string &file, const std::string &func,
+                unsigned line, const std::string &hint);
+
+template <typename T, typename U>
+void AssertEqualImpl(const T &t, const U &u, const std::string &t_str, const std::string &u_str,
+                     const std::string &file, const std::string &func, unsigned line, const std::string &hint){
+    if (t != u){
+        std::cerr << std::boolalpha;
+        std::cerr << file << "(" << line << "): " << func << ": ";
+        std::cerr << "ASSERT_EQUAL(" << t_str << ", " << u_str << ") failed: ";
+        std::cerr << t << " != " << u << ".";
+        if (!hint.empty()){
+            std::cerr << " Hint: " << hint;
+        }
+        std::cerr << std::endl;
+        std::abort();
+    }
+}
+
+#define ASSERT_EQUAL(a, b) AssertEqualImpl((a), (b), #a, #b, __FILE__, __FUNCTION__, __LINE__, "")
+#define ASSERT_EQUAL_HINT(a, b, hint) AssertEqualImpl((a), (b), #a, #b, __FILE__, __FUNCTION__, __LINE__, (hint))
+#define ASSERT(expr) AssertImpl(!!(expr), #expr, __FILE__, __FUNCTION__, __LINE__, "")
+#define ASSERT_HINT(expr, hint) AssertImpl(!!(expr), #expr, __FILE__, __FUNCTION__, __LINE__, (hint))
+
+// Passes when expr throws the given exception type
+#define ASSERT_THROWS(expr, exception_type)                                              \
+    do{                                                                                  \
+        bool thrown = false;                                                             \
+        try{                                                                             \
+            expr;                                                                        \
+        }catch (const exception_type&){                                                  \
+            thrown = true;                                                               \
+        }                                                                                \
+        AssertImpl(thrown, #expr " throws " #exception_type, __FILE__, __FUNCTION__,     \
+                   __LINE__, "");                                                        \
+    }while (false)
+
+template <typename TestFunc>
+void RunTestImpl(const TestFunc &func, const std::string &test_name){
+    func();
+    std::cerr << test_name << " OK" << std::endl;
+}
+
+#define RUN_TEST(func) RunTestImpl((func), #func)
+
+// Ids, relevances and ratings match exactly
+bool AreSameDocuments(const std::vector<Document> &lhs, const std::vector<Document> &rhs);
+// Ids in order, for readable assertions
+std::string PrintDocumentIds(const std::vector<Document> &documents);
+
+// count words " w<n>" with n drawn from a geometric distribution of the
+// given success probability: the lower it is, the more distinct words and
+// the less skewed their frequencies
+std::string MakeWords(std::mt19937 &generator, int count, double probability);
+
+// Whole contents of a binary file
+std::string ReadFile(const std::string &path);
+// Replaces the file with the given contents
+void WriteFile(const std::string &path, const std::string &contents);
+
+// Overwrites the bytes at offset with value, for tests that damage binary formats
+template <typename T>
+void Patch(std::string &contents, std::size_t offset, T value){
+    std::memcpy(contents.data() + offset, &value, sizeof(value));
+}
+
+// Both servers hold the same documents: equal results for every query and
+// status, and the same number of distinct words per document
+void AssertSameResults(const SearchServer &lhs, const SearchServer &rhs, const std::vector<std::string> &queries);
+
+// Recomputes the checksum of a SearchServer snapshot edited by a test
+void UpdateSnapshotChecksum(std::string &snapshot);
+
+// Path for a scratch file in the temporary directory, unique per process;
+// the file is removed before the path is returned
+std::string MakeTempPath(std::string_view name);
+
+// Test groups, one per source file
+void TestStringProcessing();
+void TestStopWords();
+void TestTermDictionary();
+void TestSearchServer();
+void TestNearDuplicates();
+void TestSnapshots();
+void TestMappedIndex();
+void TestWriteAheadLog();
+void TestCorpusLoader();
+void TestPagination();
+void TestQueryArena();
+void TestMetrics();
+void TestTracing();
+void TestMemoryStats();
+void TestQueryStats();
+void TestPerfCounters();
+void TestQueryLog();
+void TestQueryBatch();
+void TestQueryPlanner();
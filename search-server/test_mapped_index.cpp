@@ -0,0 +1,195 @@
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "mapped_index.h"
+#include "search_server.h"
+#include "test_example_functions.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+SearchServer MakeServer(){
+    SearchServer search_server("and with"s);
+    for (int id = 0; id < 40; ++id){
+        std::string text = "word"s + std::to_string(id % 9) + " common and w"s + std::to_string(id % 4);
+        for (int i = 0; i < id % 3; ++i){
+            text += " common"s;
+        }
+        search_server.AddDocument(id * 2, text, static_cast<DocumentStatus>(id % 4), {id, -id / 3});
+    }
+    return search_server;
+}
+
+std::string WriteIndex(const SearchServer &search_server, std::string_view name){
+    const std::string path = MakeTempPath(name);
+    std::ofstream output(path, std::ios::binary);
+    MappedIndex::Write(search_server, output);
+    return path;
+}
+
+MappedIndex::Header ReadHeader(const std::string &contents){
+    MappedIndex::Header header;
+    std::memcpy(&header, contents.data(), sizeof(header));
+    return header;
+}
+
+const std::vector<std::string> QUERIES = {
+    "common"s, "word3 w1"s, "word1 -w2"s, "common -common"s, "missing"s, "word8 word2 and"s,
+};
+
+void TestMatchesSearchServer(){
+    const SearchServer search_server = MakeServer();
+    const std::string path = WriteIndex(search_server, "round_trip");
+    {
+        const MappedIndex index(path);
+        ASSERT_EQUAL(index.GetDocumentCount(), search_server.GetDocumentCount());
+        for (const std::string &query : QUERIES){
+            ASSERT_HINT(AreSameDocuments(index.FindTopDocuments(query), search_server.FindTopDocuments(query)), query);
+            ASSERT_HINT(AreSameDocuments(index.FindTopDocuments(query, DocumentStatus::BANNED),
+                                         search_server.FindTopDocuments(query, DocumentStatus::BANNED)), query);
+            for (const int document_id : search_server){
+                const auto [index_words, index_status] = index.MatchDocument(query, document_id);
+                const auto [server_words, server_status] = search_server.MatchDocument(query, document_id);
+                ASSERT_HINT(index_words == server_words, query);
+                ASSERT_HINT(index_status == server_status, query);
+            }
+        }
+        ASSERT_THROWS(index.MatchDocument("common"s, 1), std::out_of_range);
+    }
+    std::remove(path.c_str());
+}
+
+// The index written after other data is the one written alone
+void TestWritesAtStreamPosition(){
+    const SearchServer search_server = MakeServer();
+    const std::string alone = ReadFile(WriteIndex(search_server, "alone"));
+    const std::string prefix = "prefix"s;
+    std::ostringstream output(prefix, std::ios::binary | std::ios::ate);
+    MappedIndex::Write(search_server, output);
+    const std::string contents = output.str();
+    ASSERT_EQUAL(contents.substr(0, prefix.size()), prefix);
+    ASSERT(contents.substr(prefix.size()) == alone);
+}
+
+void TestRejectsDamagedHeaders(){
+    const std::string path = WriteIndex(MakeServer(), "headers");
+    const std::string contents = ReadFile(path);
+    const MappedIndex::Header header = ReadHeader(contents);
+
+    std::string damaged = contents;
+    damaged[0] = 'X';
+    WriteFile(path, damaged);
+    ASSERT_THROWS(MappedIndex{path}, std::invalid_argument);
+
+    // Sections past the end of the file
+    WriteFile(path, contents.substr(0, header.stop_word_text_offset));
+    ASSERT_THROWS(MappedIndex{path}, std::invalid_argument);
+    WriteFile(path, contents.substr(0, sizeof(header) - 1));
+    ASSERT_THROWS(MappedIndex{path}, std::invalid_argument);
+
+    damaged = contents;
+    Patch(damaged, offsetof(MappedIndex::Header, term_slot_count), header.term_slot_count + 1);
+    WriteFile(path, damaged);
+    ASSERT_THROWS(MappedIndex{path}, std::invalid_argument);
+
+    damaged = contents;
+    Patch(damaged, offsetof(MappedIndex::Header, postings_offset), std::uint64_t{1} << 40);
+    WriteFile(path, damaged);
+    ASSERT_THROWS(MappedIndex{path}, std::invalid_argument);
+
+    // The last posting offset must match the posting count
+    damaged = contents;
+    Patch(damaged, header.posting_offsets_offset + header.term_count * sizeof(std::uint64_t), header.posting_count - 1);
+    WriteFile(path, damaged);
+    ASSERT_THROWS(MappedIndex{path}, std::invalid_argument);
+    std::remove(path.c_str());
+}
+
+// Damage inside a section is found by the query that reads it
+void TestRejectsDamagedSectionsOnAccess(){
+    const std::string path = WriteIndex(MakeServer(), "sections");
+    const std::string contents = ReadFile(path);
+    const MappedIndex::Header header = ReadHeader(contents);
+
+    std::string damaged = contents;
+    for (std::uint64_t i = 0; i < header.posting_count; ++i){
+        Patch(damaged, header.postings_offset + i * sizeof(MappedIndex::Posting), std::uint32_t{1000000});
+    }
+    WriteFile(path, damaged);
+    {
+        const MappedIndex index(path);
+        ASSERT_THROWS(index.FindTopDocuments("common"s), std::invalid_argument);
+        ASSERT(index.FindTopDocuments("missing"s).empty());
+    }
+
+    damaged = contents;
+    for (std::uint64_t term = 1; term < header.term_count; ++term){
+        Patch(damaged, header.posting_offsets_offset + term * sizeof(std::uint64_t), header.posting_count + 1);
+    }
+    WriteFile(path, damaged);
+    {
+        const MappedIndex index(path);
+        ASSERT_THROWS(index.FindTopDocuments("common word1"s), std::invalid_argument);
+    }
+
+    damaged = contents;
+    Patch(damaged, header.forward_offsets_offset + sizeof(std::uint64_t), header.forward_entry_count + 1);
+    WriteFile(path, damaged);
+    {
+        const MappedIndex index(path);
+        ASSERT_THROWS(index.MatchDocument("common"s, 0), std::invalid_argument);
+        ASSERT_THROWS(index.MatchDocument("common"s, 2), std::invalid_argument);
+        ASSERT_EQUAL(std::get<0>(index.MatchDocument("common"s, 4)).size(), 1u);
+    }
+
+    damaged = contents;
+    std::uint64_t term_text_size;
+    std::memcpy(&term_text_size, contents.data() + header.term_text_offsets_offset
+                + header.term_count * sizeof(std::uint64_t), sizeof(term_text_size));
+    for (std::uint64_t term = 1; term < header.term_count; ++term){
+        Patch(damaged, header.term_text_offsets_offset + term * sizeof(std::uint64_t), term_text_size + 1);
+    }
+    WriteFile(path, damaged);
+    {
+        const MappedIndex index(path);
+        ASSERT_THROWS(index.FindTopDocuments("common"s), std::invalid_argument);
+    }
+    std::remove(path.c_str());
+}
+
+// A slot table without an empty slot is searched once around, not forever
+void TestFullSlotTableTerminates(){
+    const std::string path = WriteIndex(MakeServer(), "full_slots");
+    std::string contents = ReadFile(path);
+    const MappedIndex::Header header = ReadHeader(contents);
+    for (std::uint64_t slot = 0; slot < header.term_slot_count; ++slot){
+        const std::uint64_t offset = header.term_slots_offset + slot * sizeof(TermId);
+        TermId term;
+        std::memcpy(&term, contents.data() + offset, sizeof(term));
+        if (term == NO_TERM){
+            Patch(contents, offset, TermId{0});
+        }
+    }
+    WriteFile(path, contents);
+    {
+        const MappedIndex index(path);
+        ASSERT(index.FindTopDocuments("missing"s).empty());
+        ASSERT(!index.FindTopDocuments("common"s).empty());
+    }
+    std::remove(path.c_str());
+}
+
+} // namespace
+
+void TestMappedIndex(){
+    RUN_TEST(TestMatchesSearchServer);
+    RUN_TEST(TestWritesAtStreamPosition);
+    RUN_TEST(TestRejectsDamagedHeaders);
+    RUN_TEST(TestRejectsDamagedSectionsOnAccess);
+    RUN_TEST(TestFullSlotTableTerminates);
+}
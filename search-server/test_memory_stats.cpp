@@ -0,0 +1,106 @@
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+#include "counting_allocator.h"
+#include "search_server.h"
+#include "test_example_functions.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+using CountedVector = std::vector<int, CountingAllocator<int>>;
+using CountedMap = std::map<int, int, std::less<int>, CountingAllocator<std::pair<const int, int>>>;
+
+void TestCopiesCountSeparately(){
+    CountedVector original(100);
+    const std::size_t original_bytes = original.get_allocator().GetBytes();
+    ASSERT_EQUAL(original_bytes, 100 * sizeof(int));
+    {
+        const CountedVector copy(original);
+        ASSERT(copy.get_allocator() != original.get_allocator());
+        ASSERT_EQUAL(copy.get_allocator().GetBytes(), 100 * sizeof(int));
+        ASSERT_EQUAL(original.get_allocator().GetBytes(), original_bytes);
+    }
+    ASSERT_EQUAL(original.get_allocator().GetBytes(), original_bytes);
+
+    // Copy assignment reallocates through the target's own counter
+    CountedVector target(10);
+    const CountingAllocator<int> target_allocator = target.get_allocator();
+    target = original;
+    ASSERT(target.get_allocator() == target_allocator);
+    ASSERT_EQUAL(target.get_allocator().GetBytes(), 100 * sizeof(int));
+    ASSERT_EQUAL(original.get_allocator().GetBytes(), original_bytes);
+
+    // Node containers count through rebound copies of the allocator
+    CountedMap map;
+    for (int i = 0; i < 50; ++i){
+        map[i] = i;
+    }
+    const std::size_t map_bytes = map.get_allocator().GetBytes();
+    ASSERT(map_bytes >= 50 * sizeof(std::pair<const int, int>));
+    CountedMap map_copy(map);
+    ASSERT_EQUAL(map_copy.get_allocator().GetBytes(), map_bytes);
+    map_copy.clear();
+    ASSERT_EQUAL(map_copy.get_allocator().GetBytes(), 0u);
+    ASSERT_EQUAL(map.get_allocator().GetBytes(), map_bytes);
+}
+
+void TestMovesTakeTheCounterAlong(){
+    CountedVector source(100);
+    const CountingAllocator<int> source_allocator = source.get_allocator();
+    CountedVector target(10);
+    target = std::move(source);
+    ASSERT(target.get_allocator() == source_allocator);
+    ASSERT_EQUAL(target.get_allocator().GetBytes(), 100 * sizeof(int));
+
+    CountedVector other(20);
+    std::swap(target, other);
+    ASSERT_EQUAL(target.get_allocator().GetBytes(), 20 * sizeof(int));
+    ASSERT_EQUAL(other.get_allocator().GetBytes(), 100 * sizeof(int));
+}
+
+void TestServerMemoryStats(){
+    auto server = std::make_unique<SearchServer>("and"s);
+    SearchServer &search_server = *server;
+    const MemoryStats empty = search_server.GetMemoryStats();
+    ASSERT_EQUAL(empty.document_count, 0u);
+    for (int id = 0; id < 100; ++id){
+        search_server.AddDocument(id, "word"s + std::to_string(id) + " common and"s, DocumentStatus::ACTUAL, {id});
+    }
+    const MemoryStats full = search_server.GetMemoryStats();
+    ASSERT_EQUAL(full.document_count, 100u);
+    ASSERT_EQUAL(full.term_count, 101u);
+    ASSERT_EQUAL(full.posting_count, 200u);
+    ASSERT_EQUAL(full.forward_entry_count, 200u);
+    ASSERT(full.document_metadata_bytes >= 100 * sizeof(int));
+    ASSERT(full.document_id_bytes >= 100 * sizeof(int));
+    ASSERT(full.GetTotalBytes() > empty.GetTotalBytes());
+
+    for (int id = 0; id < 10; ++id){
+        search_server.RemoveDocument(id);
+    }
+    const MemoryStats removed = search_server.GetMemoryStats();
+    ASSERT_EQUAL(removed.document_count, 90u);
+    ASSERT(removed.document_metadata_bytes < full.document_metadata_bytes);
+    ASSERT_EQUAL(removed.posting_count, 180u);
+
+    // The counters move with the containers; the moved-from server may
+    // allocate empty containers on the same counters until it is gone
+    const SearchServer moved(std::move(search_server));
+    server.reset();
+    const MemoryStats moved_stats = moved.GetMemoryStats();
+    ASSERT_EQUAL(moved_stats.document_metadata_bytes, removed.document_metadata_bytes);
+    ASSERT_EQUAL(moved_stats.document_id_bytes, removed.document_id_bytes);
+    ASSERT_EQUAL(moved_stats.GetTotalBytes(), removed.GetTotalBytes());
+}
+
+} // namespace
+
+void TestMemoryStats(){
+    RUN_TEST(TestCopiesCountSeparately);
+    RUN_TEST(TestMovesTakeTheCounterAlong);
+    RUN_TEST(TestServerMemoryStats);
+}
@@ -0,0 +1,125 @@
+#include <string>
+#include <thread>
+#include <vector>
+#include "metrics.h"
+#include "search_server.h"
+#include "test_example_functions.h"
+
+using namespace std::string_literals;
+using namespace std::string_view_literals;
+
+namespace {
+
+std::uint64_t GetHistogramCount(const std::string &name){
+    return MetricsRegistry::Instance().GetSnapshot().histograms.at(name).count;
+}
+
+void TestHistogramBuckets(){
+    for (std::uint64_t value = 0; value < HistogramSnapshot::LINEAR_BUCKETS; ++value){
+        ASSERT_EQUAL(HistogramSnapshot::GetBucket(value), value);
+    }
+    for (std::uint64_t value = 16; value < (std::uint64_t{1} << 40); value = value * 3 / 2 + 1){
+        const std::size_t bucket = HistogramSnapshot::GetBucket(value);
+        const std::uint64_t low = HistogramSnapshot::GetBucketLow(bucket);
+        const std::uint64_t high = HistogramSnapshot::GetBucketHigh(bucket);
+        ASSERT_HINT(low <= value && value <= high, std::to_string(value));
+        ASSERT_HINT(high - low <= low / 8, std::to_string(value));
+        ASSERT_EQUAL(HistogramSnapshot::GetBucket(high + 1), bucket + 1);
+    }
+    ASSERT_EQUAL(HistogramSnapshot::GetBucket(UINT64_MAX), HistogramSnapshot::BUCKET_COUNT - 1);
+}
+
+void TestHistogramPercentiles(){
+    HistogramSnapshot histogram;
+    ASSERT_EQUAL(histogram.GetPercentile(50), 0u);
+    for (std::uint64_t value = 1; value <= 1000; ++value){
+        histogram.Add(value * 1000);
+    }
+    ASSERT_EQUAL(histogram.count, 1000u);
+    ASSERT_EQUAL(histogram.max, 1000000u);
+    ASSERT_EQUAL(histogram.GetMean(), 500500.0);
+    for (const double percent : {50.0, 95.0, 99.0}){
+        const double exact = percent * 10 * 1000;
+        const double estimate = static_cast<double>(histogram.GetPercentile(percent));
+        ASSERT_HINT(estimate >= exact && estimate <= exact * 1.125, std::to_string(percent));
+    }
+    ASSERT_EQUAL(histogram.GetPercentile(100), 1000000u);
+
+    HistogramSnapshot other;
+    other.Add(5);
+    other.Add(2000000);
+    histogram.Merge(other);
+    ASSERT_EQUAL(histogram.count, 1002u);
+    ASSERT_EQUAL(histogram.max, 2000000u);
+    ASSERT_EQUAL(histogram.GetPercentile(0), 5u);
+}
+
+// Shards of threads that ended still count
+void TestRegistrySumsThreads(){
+    MetricsRegistry &registry = MetricsRegistry::Instance();
+    const CounterId counter = registry.GetCounter("test.events"sv);
+    ASSERT_EQUAL(registry.GetCounter("test.events"sv), counter);
+    const HistogramId histogram = registry.GetHistogram("test.latency_ns"sv);
+    const MetricsSnapshot before = registry.GetSnapshot();
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < 4; ++thread){
+        threads.emplace_back([&registry, counter, histogram]{
+            for (int i = 0; i < 1000; ++i){
+                registry.Add(counter);
+                registry.Record(histogram, i);
+            }
+        });
+    }
+    for (std::thread &thread : threads){
+        thread.join();
+    }
+    registry.Add(counter, 10);
+    {
+        RECORD_DURATION("test.latency_ns"s);
+    }
+    const MetricsSnapshot after = registry.GetSnapshot();
+    ASSERT_EQUAL(after.counters.at("test.events"s) - before.counters.at("test.events"s), 4010u);
+    ASSERT_EQUAL(after.histograms.at("test.latency_ns"s).count - before.histograms.at("test.latency_ns"s).count,
+                 4001u);
+    ASSERT(after.histograms.at("test.latency_ns"s).max >= 999u);
+}
+
+// Only searches feed the stage histograms
+void TestStageHistogramsCountSearchesOnly(){
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "white cat and collar"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "fluffy dog"s, DocumentStatus::ACTUAL, {1});
+    const MetricsSnapshot before = MetricsRegistry::Instance().GetSnapshot();
+    const std::uint64_t parse_before = GetHistogramCount("search.parse_ns"s);
+    const std::uint64_t lookup_before = GetHistogramCount("search.term_lookup_ns"s);
+
+    for (int i = 0; i < 5; ++i){
+        search_server.MatchDocument("cat dog"s, 1);
+        search_server.MatchDocument(std::execution::par, "cat dog"s, 2);
+        search_server.ExplainQuery("cat"s);
+    }
+    const SearchServer::CompiledQuery query = search_server.CompileQuery("cat -dog"s);
+    ASSERT_EQUAL(GetHistogramCount("search.parse_ns"s), parse_before);
+    ASSERT_EQUAL(GetHistogramCount("search.term_lookup_ns"s), lookup_before);
+
+    search_server.FindTopDocuments("cat"s);
+    search_server.FindTopDocuments(std::execution::par, "dog"s);
+    QueryStats stats;
+    search_server.FindTopDocuments("cat"s, stats);
+    search_server.FindTopDocumentsBatch({"cat"s, "dog"s});
+    // Compiled at CompileQuery, there is nothing to parse
+    search_server.FindTopDocuments(query);
+    ASSERT_EQUAL(GetHistogramCount("search.parse_ns"s), parse_before + 5);
+    ASSERT_EQUAL(GetHistogramCount("search.term_lookup_ns"s), lookup_before + 5);
+    const MetricsSnapshot after = MetricsRegistry::Instance().GetSnapshot();
+    ASSERT_EQUAL(after.counters.at("search.queries"s) - before.counters.at("search.queries"s), 6u);
+}
+
+} // namespace
+
+void TestMetrics(){
+    RUN_TEST(TestHistogramBuckets);
+    RUN_TEST(TestHistogramPercentiles);
+    RUN_TEST(TestRegistrySumsThreads);
+    RUN_TEST(TestStageHistogramsCountSearchesOnly);
+}
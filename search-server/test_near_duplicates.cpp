@@ -0,0 +1,51 @@
+#include <string>
+#include <vector>
+#include "near_duplicates.h"
+#include "test_example_functions.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+std::string MakeText(int first_word, int word_count){
+    std::string text;
+    for (int i = 0; i < word_count; ++i){
+        text += "w"s + std::to_string(first_word + i) + " "s;
+    }
+    return text;
+}
+
+void TestFindsSimilarDocuments(){
+    SearchServer search_server(""s);
+    // 1, 4 and 7 share 49 of 50 words, 2 and 5 are equal, the rest are unrelated
+    search_server.AddDocument(1, MakeText(0, 50), DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, MakeText(1000, 30), DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(3, MakeText(2000, 40), DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(4, MakeText(0, 49) + "other"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(5, MakeText(1000, 30), DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(6, MakeText(25, 50), DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(7, MakeText(1, 49), DocumentStatus::ACTUAL, {1});
+    const std::vector<std::vector<int>> expected = {{1, 4, 7}, {2, 5}};
+    ASSERT(FindNearDuplicates(search_server) == expected);
+    ASSERT(FindNearDuplicates(std::execution::par, search_server) == expected);
+
+    NearDuplicateOptions strict;
+    strict.min_similarity = 1.0;
+    ASSERT(FindNearDuplicates(search_server, strict) == std::vector<std::vector<int>>({{2, 5}}));
+}
+
+void TestNoNearDuplicates(){
+    SearchServer search_server(""s);
+    ASSERT(FindNearDuplicates(search_server).empty());
+    for (int id = 0; id < 100; ++id){
+        search_server.AddDocument(id, MakeText(id * 10, 10), DocumentStatus::ACTUAL, {1});
+    }
+    ASSERT(FindNearDuplicates(std::execution::seq, search_server).empty());
+}
+
+} // namespace
+
+void TestNearDuplicates(){
+    RUN_TEST(TestFindsSimilarDocuments);
+    RUN_TEST(TestNoNearDuplicates);
+}
@@ -0,0 +1,128 @@
+#include <string>
+#include <vector>
+#include "search_cursor.h"
+#include "search_server.h"
+#include "test_example_functions.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+// Relevances of neighbouring documents differ by less than ACCURACY while
+// their ratings go up and down, so the tolerant order is not transitive
+SearchServer MakeNearTieServer(){
+    SearchServer search_server(""s);
+    std::string filler;
+    for (int i = 0; i < 1000; ++i){
+        filler += " x"s + std::to_string(i);
+    }
+    for (int id = 0; id < 120; ++id){
+        // Pairs of documents have the same length, an exact tie
+        std::string text = "cat"s;
+        for (int i = 0; i < id / 2; ++i){
+            text += " y"s;
+        }
+        search_server.AddDocument(id, text + filler, DocumentStatus::ACTUAL, {(id * 37) % 11 - 5});
+        search_server.AddDocument(1000 + id, "dog"s, DocumentStatus::ACTUAL, {1});
+    }
+    return search_server;
+}
+
+std::vector<Document> ReadAllPages(const SearchServer &search_server, std::string_view query, int page_size){
+    std::vector<Document> documents;
+    SearchCursor cursor;
+    while (!cursor.IsEnd()){
+        // Clients only ever see the token
+        const SearchPage page = search_server.FindTopDocumentsPage(query, SearchCursor::Parse(cursor.ToString()),
+                                                                   page_size);
+        ASSERT(static_cast<int>(page.documents.size()) <= page_size);
+        ASSERT(!page.documents.empty() || page.next.IsEnd());
+        documents.insert(documents.end(), page.documents.begin(), page.documents.end());
+        cursor = page.next;
+    }
+    return documents;
+}
+
+void TestPagesNeitherSkipNorRepeat(){
+    const SearchServer search_server = MakeNearTieServer();
+    const std::vector<Document> all = search_server.FindTopDocumentsPage("cat"s, SearchCursor{}, 1000).documents;
+    ASSERT_EQUAL(all.size(), 120u);
+    ASSERT(all.front().relevance - all.back().relevance > ACCURACY);
+    for (std::size_t i = 1; i < all.size(); ++i){
+        const Document &lhs = all[i - 1];
+        const Document &rhs = all[i];
+        ASSERT(lhs.relevance - rhs.relevance < ACCURACY);
+        ASSERT(lhs.relevance > rhs.relevance || (lhs.relevance == rhs.relevance
+               && (lhs.rating > rhs.rating || (lhs.rating == rhs.rating && lhs.id < rhs.id))));
+    }
+    for (const int page_size : {1, 2, 3, 7, 50, 119, 120}){
+        const std::vector<Document> paged = ReadAllPages(search_server, "cat"s, page_size);
+        ASSERT_HINT(AreSameDocuments(paged, all), std::to_string(page_size));
+    }
+}
+
+void TestFiltersAndEmptyResults(){
+    const SearchServer search_server = MakeNearTieServer();
+    ASSERT(ReadAllPages(search_server, "missing"s, 3).empty());
+    ASSERT(ReadAllPages(search_server, "cat"s, 3).size() == 120u);
+    ASSERT(ReadAllPages(search_server, "cat -y"s, 3).size() == 2u);
+    const SearchPage banned = search_server.FindTopDocumentsPage("cat"s, DocumentStatus::BANNED, SearchCursor{}, 3);
+    ASSERT(banned.documents.empty());
+    ASSERT(banned.next.IsEnd());
+    const SearchPage even = search_server.FindTopDocumentsPage("cat"s, [](int document_id, DocumentStatus, int){
+        return document_id % 2 == 0;
+    }, SearchCursor{}, 100);
+    ASSERT_EQUAL(even.documents.size(), 60u);
+    ASSERT(even.next.IsEnd());
+}
+
+void TestRejectsInvalidCursors(){
+    SearchServer search_server = MakeNearTieServer();
+    ASSERT_THROWS(search_server.FindTopDocumentsPage("cat"s, SearchCursor{}, 0), std::invalid_argument);
+    ASSERT_THROWS(SearchCursor::Parse("not a cursor"s), std::invalid_argument);
+    std::string token = search_server.FindTopDocumentsPage("cat"s, SearchCursor{}, 5).next.ToString();
+    token[0] = 'z';
+    ASSERT_THROWS(SearchCursor::Parse(token), std::invalid_argument);
+
+    // Relevances change with the index
+    const SearchCursor cursor = search_server.FindTopDocumentsPage("cat"s, SearchCursor{}, 5).next;
+    search_server.AddDocument(5000, "cat"s, DocumentStatus::ACTUAL, {1});
+    ASSERT_THROWS(search_server.FindTopDocumentsPage("cat"s, cursor, 5), std::invalid_argument);
+    // A cursor from the start is never stale
+    ASSERT_EQUAL(search_server.FindTopDocumentsPage("cat"s, SearchCursor{}, 5).documents.size(), 5u);
+}
+
+// A position means nothing in the ranking of another query or filter
+void TestRejectsCursorsOfOtherQueries(){
+    const SearchServer search_server = MakeNearTieServer();
+    const SearchCursor cursor = search_server.FindTopDocumentsPage("cat"s, SearchCursor{}, 5).next;
+    ASSERT_THROWS(search_server.FindTopDocumentsPage("cat -y"s, cursor, 5), std::invalid_argument);
+    ASSERT_THROWS(search_server.FindTopDocumentsPage("cat"s, DocumentStatus::BANNED, cursor, 5),
+                  std::invalid_argument);
+    ASSERT_THROWS(search_server.FindTopDocumentsPage("cat"s, [](int, DocumentStatus, int){
+        return true;
+    }, cursor, 5), std::invalid_argument);
+    // ACTUAL is the default filter
+    ASSERT_EQUAL(search_server.FindTopDocumentsPage("cat"s, DocumentStatus::ACTUAL, cursor, 5).documents.size(), 5u);
+
+    const SearchCursor end = search_server.FindTopDocumentsPage("missing"s, SearchCursor{}, 5).next;
+    ASSERT(end.IsEnd());
+    ASSERT(search_server.FindTopDocumentsPage("missing"s, end, 5).documents.empty());
+    ASSERT_THROWS(search_server.FindTopDocumentsPage("cat"s, end, 5), std::invalid_argument);
+
+    const auto is_even = [](int document_id, DocumentStatus, int){
+        return document_id % 2 == 0;
+    };
+    const SearchCursor even = search_server.FindTopDocumentsPage("cat"s, is_even, SearchCursor{}, 5).next;
+    ASSERT_EQUAL(search_server.FindTopDocumentsPage("cat"s, is_even, even, 5).documents.size(), 5u);
+    ASSERT_THROWS(search_server.FindTopDocumentsPage("cat"s, even, 5), std::invalid_argument);
+}
+
+} // namespace
+
+void TestPagination(){
+    RUN_TEST(TestPagesNeitherSkipNorRepeat);
+    RUN_TEST(TestFiltersAndEmptyResults);
+    RUN_TEST(TestRejectsInvalidCursors);
+    RUN_TEST(TestRejectsCursorsOfOtherQueries);
+}
@@ -0,0 +1,61 @@
+#include <cctype>
+#include <cstdint>
+#include <set>
+#include <string>
+#include "perf_counters.h"
+#include "test_example_functions.h"
+
+namespace {
+
+void TestEventNames(){
+    std::set<std::string> names;
+    for (std::size_t i = 0; i < PERF_EVENT_COUNT; ++i){
+        const std::string name = PerfCounters::GetName(static_cast<PerfEvent>(i));
+        ASSERT(!name.empty());
+        for (const char c : name){
+            ASSERT_HINT(std::islower(static_cast<unsigned char>(c)) || c == '_', name);
+        }
+        names.insert(name);
+    }
+    ASSERT_EQUAL(names.size(), PERF_EVENT_COUNT);
+    ASSERT_EQUAL(std::string(PerfCounters::GetName(PerfEvent::LLC_LOADS)), "llc_loads");
+}
+
+// Holds on machines with counters and without them: events that are not
+// counted read as zero and never show up as counted
+void TestReadingsMatchAvailability(){
+    PerfCounters counters;
+    bool any_available = false;
+    for (std::size_t i = 0; i < PERF_EVENT_COUNT; ++i){
+        any_available = any_available || counters.IsAvailable(static_cast<PerfEvent>(i));
+    }
+    ASSERT_EQUAL(counters.IsAvailable(), any_available);
+
+    for (int round = 0; round < 2; ++round){
+        counters.Start();
+        volatile std::uint64_t sum = 0;
+        for (std::uint64_t i = 0; i < 1000000; ++i){
+            sum = sum + i;
+        }
+        const PerfReading reading = counters.Stop();
+        for (std::size_t i = 0; i < PERF_EVENT_COUNT; ++i){
+            const auto event = static_cast<PerfEvent>(i);
+            const std::string name = PerfCounters::GetName(event);
+            ASSERT_HINT(!reading.IsCounted(event) || counters.IsAvailable(event), name);
+            if (!reading.IsCounted(event)){
+                ASSERT_EQUAL_HINT(reading.Get(event), 0.0, name);
+            }
+        }
+        // A million additions cannot take fewer instructions
+        if (reading.IsCounted(PerfEvent::INSTRUCTIONS)){
+            ASSERT(reading.Get(PerfEvent::INSTRUCTIONS) >= 1000000.0);
+        }
+    }
+}
+
+} // namespace
+
+void TestPerfCounters(){
+    RUN_TEST(TestEventNames);
+    RUN_TEST(TestReadingsMatchAvailability);
+}
@@ -0,0 +1,74 @@
+#include <future>
+#include <memory_resource>
+#include <string>
+#include <vector>
+#include "query_arena.h"
+#include "search_server.h"
+#include "test_example_functions.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+void TestNestedScopesShareTheArena(){
+    const QueryArena outer;
+    std::pmr::vector<int> numbers(outer.GetResource());
+    numbers.assign(100000, 7);
+    {
+        const QueryArena inner;
+        ASSERT(inner.GetResource() == outer.GetResource());
+        // Releasing the inner scope must not free what the outer one holds
+        std::pmr::string text(std::string(1000, 'x'), inner.GetResource());
+    }
+    ASSERT_EQUAL(numbers.back(), 7);
+    ASSERT_EQUAL(numbers.size(), 100000u);
+}
+
+void TestThreadsHaveOwnArenas(){
+    const QueryArena arena;
+    std::pmr::memory_resource *other = std::async(std::launch::async, []{
+        const QueryArena arena;
+        return arena.GetResource();
+    }).get();
+    ASSERT(other != arena.GetResource());
+}
+
+// Queries reuse the arena of their thread, large ones outgrow its first buffer
+void TestQueriesReuseArenas(){
+    SearchServer search_server("and"s);
+    std::string long_query;
+    for (int id = 0; id < 3000; ++id){
+        const std::string word = "word"s + std::to_string(id);
+        // Distinct ratings, so that the top documents are unambiguous
+        search_server.AddDocument(id, word + " common and"s, DocumentStatus::ACTUAL, {id});
+        long_query += word + " "s;
+    }
+    const std::vector<Document> common = search_server.FindTopDocuments("common"s);
+    const std::vector<Document> everything = search_server.FindTopDocuments(long_query);
+    ASSERT_EQUAL(everything.size(), static_cast<std::size_t>(MAX_RESULT_DOCUMENT_COUNT));
+
+    std::vector<std::future<bool>> results;
+    for (int thread = 0; thread < 8; ++thread){
+        results.push_back(std::async(std::launch::async, [&]{
+            bool same = true;
+            for (int i = 0; i < 4; ++i){
+                same = same && AreSameDocuments(search_server.FindTopDocuments("common"s), common);
+                same = same && AreSameDocuments(search_server.FindTopDocuments(long_query), everything);
+                same = same && AreSameDocuments(search_server.FindTopDocuments(std::execution::par, long_query),
+                                                everything);
+            }
+            return same;
+        }));
+    }
+    for (std::future<bool> &result : results){
+        ASSERT(result.get());
+    }
+}
+
+} // namespace
+
+void TestQueryArena(){
+    RUN_TEST(TestNestedScopesShareTheArena);
+    RUN_TEST(TestThreadsHaveOwnArenas);
+    RUN_TEST(TestQueriesReuseArenas);
+}
@@ -0,0 +1,101 @@
+#include <random>
+#include <string>
+#include <vector>
+#include "process_queries.h"
+#include "search_server.h"
+#include "test_example_functions.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+// Word frequencies skewed enough that queries share popular terms
+constexpr double WORD_PROBABILITY = 0.08;
+
+// Every query_step-th query and the last ones are compared to FindTopDocuments
+void CheckBatch(const SearchServer &search_server, const std::vector<std::string> &queries, DocumentStatus status,
+                std::size_t query_step = 1){
+    const std::vector<std::vector<Document>> seq = search_server.FindTopDocumentsBatch(queries, status);
+    const std::vector<std::vector<Document>> par = search_server.FindTopDocumentsBatch(std::execution::par,
+                                                                                       queries, status);
+    ASSERT_EQUAL(seq.size(), queries.size());
+    ASSERT_EQUAL(par.size(), queries.size());
+    for (std::size_t i = 0; i < queries.size(); ++i){
+        ASSERT_HINT(AreSameDocuments(par[i], seq[i]), queries[i]);
+        if (i % query_step != 0 && i + 2 < queries.size()){
+            continue;
+        }
+        const std::vector<Document> expected = search_server.FindTopDocuments(queries[i], status);
+        ASSERT_HINT(AreSameDocuments(seq[i], expected), queries[i] + ": "s + PrintDocumentIds(seq[i])
+                    + " != "s + PrintDocumentIds(expected));
+    }
+}
+
+void TestBatchMatchesSingleQueries(){
+    std::mt19937 generator(42);
+    SearchServer search_server("w0 and"s);
+    for (int id = 0; id < 600; ++id){
+        const auto status = static_cast<DocumentStatus>(id % 7 == 0 ? id % 4 : 0);
+        // Distinct ratings, so that equal relevances have one order
+        search_server.AddDocument(id * 3, MakeWords(generator, 4 + id % 13, WORD_PROBABILITY), status, {id});
+    }
+    std::vector<std::string> queries;
+    for (int i = 0; i < 300; ++i){
+        std::string query = MakeWords(generator, 1 + i % 5, WORD_PROBABILITY);
+        if (i % 3 == 0){
+            query += " -"s + MakeWords(generator, 1, WORD_PROBABILITY).substr(1);
+        }
+        if (i % 50 == 0){
+            query += " missing and"s;
+        }
+        queries.push_back(query);
+    }
+    // Repeats and queries without plus terms
+    queries.push_back(queries.front());
+    queries.push_back("-w1"s);
+    queries.push_back("missing"s);
+    for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED, DocumentStatus::REMOVED}){
+        CheckBatch(search_server, queries, status);
+    }
+    CheckBatch(search_server, {"w1 w2 -w3"s}, DocumentStatus::ACTUAL);
+    ASSERT(search_server.FindTopDocumentsBatch({}).empty());
+
+    const std::vector<std::vector<Document>> processed = ProcessQueries(search_server, queries);
+    ASSERT_EQUAL(processed.size(), queries.size());
+    ASSERT(AreSameDocuments(processed[5], search_server.FindTopDocuments(queries[5])));
+}
+
+// Queries on a frequent term fill a block by posting volume before its query
+// count: 237 queries of 1101 postings and one of 550 more make the first
+// block, the last query is left alone in the second
+void TestBatchBlocksByPostingVolume(){
+    SearchServer search_server(""s);
+    constexpr int document_count = 1100;
+    for (int id = 0; id < document_count; ++id){
+        search_server.AddDocument(id, "common u"s + std::to_string(id) + (id % 2 == 0 ? " even"s : ""s),
+                                  DocumentStatus::ACTUAL, {id});
+    }
+    std::vector<std::string> queries;
+    for (int i = 0; i < 238; ++i){
+        queries.push_back("common u"s + std::to_string(i * 13 % document_count));
+    }
+    queries[8] += " -even"s;
+    queries[237] += " -even"s;
+    CheckBatch(search_server, queries, DocumentStatus::ACTUAL, 8);
+}
+
+void TestBatchRejectsInvalidQueries(){
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "white cat and collar"s, DocumentStatus::ACTUAL, {1});
+    ASSERT_THROWS(search_server.FindTopDocumentsBatch({"cat"s, "--cat"s}), std::invalid_argument);
+    ASSERT_THROWS(search_server.FindTopDocumentsBatch(std::execution::par, {"cat -"s, "cat"s}),
+                  std::invalid_argument);
+}
+
+} // namespace
+
+void TestQueryBatch(){
+    RUN_TEST(TestBatchMatchesSingleQueries);
+    RUN_TEST(TestBatchBlocksByPostingVolume);
+    RUN_TEST(TestBatchRejectsInvalidQueries);
+}
@@ -0,0 +1,162 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#include "query_log.h"
+#include "request_queue.h"
+#include "test_example_functions.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+void TestRoundTrip(){
+    const std::string path = MakeTempPath("round_trip.qlog");
+    const auto before = std::chrono::system_clock::now();
+    // Long enough for a two byte length
+    const std::string long_query(300, 'q');
+    {
+        QueryLogWriter writer(path);
+        writer.Record("white cat"s, DocumentStatus::ACTUAL);
+        writer.Record(""s, DocumentStatus::BANNED);
+        writer.Record(long_query, DocumentStatus::REMOVED);
+        ASSERT_EQUAL(writer.GetRecordCount(), 3u);
+        // Only the header is written until a flush
+        ASSERT(ReadQueryLog(path).queries.empty());
+        writer.Flush();
+        ASSERT_EQUAL(ReadQueryLog(path).queries.size(), 3u);
+        writer.Record("dog"s, DocumentStatus::IRRELEVANT);
+    }
+    const QueryLog log = ReadQueryLog(path);
+    ASSERT(log.start_time >= before - std::chrono::seconds(1));
+    ASSERT(log.start_time <= std::chrono::system_clock::now());
+    ASSERT_EQUAL(log.queries.size(), 4u);
+    ASSERT_EQUAL(log.queries[0].raw_query, "white cat"s);
+    ASSERT(log.queries[0].status == DocumentStatus::ACTUAL);
+    ASSERT_EQUAL(log.queries[1].raw_query, ""s);
+    ASSERT(log.queries[1].status == DocumentStatus::BANNED);
+    ASSERT_EQUAL(log.queries[2].raw_query, long_query);
+    ASSERT(log.queries[2].status == DocumentStatus::REMOVED);
+    ASSERT_EQUAL(log.queries[3].raw_query, "dog"s);
+    ASSERT(log.queries[3].status == DocumentStatus::IRRELEVANT);
+    for (std::size_t i = 1; i < log.queries.size(); ++i){
+        ASSERT(log.queries[i - 1].time_ns <= log.queries[i].time_ns);
+    }
+}
+
+void TestRequestQueueRecords(){
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "white cat and collar"s, DocumentStatus::ACTUAL, {1});
+    const std::string path = MakeTempPath("request_queue.qlog");
+    {
+        QueryLogWriter writer(path);
+        RequestQueue request_queue(search_server);
+        request_queue.AddFindRequest("cat"s);
+        request_queue.SetQueryLog(&writer);
+        request_queue.AddFindRequest("collar"s);
+        request_queue.AddFindRequest("dog"s, DocumentStatus::BANNED);
+        request_queue.SetQueryLog(nullptr);
+        request_queue.AddFindRequest("cat"s);
+    }
+    const QueryLog log = ReadQueryLog(path);
+    ASSERT_EQUAL(log.queries.size(), 2u);
+    ASSERT_EQUAL(log.queries[0].raw_query, "collar"s);
+    ASSERT(log.queries[0].status == DocumentStatus::ACTUAL);
+    ASSERT_EQUAL(log.queries[1].raw_query, "dog"s);
+    ASSERT(log.queries[1].status == DocumentStatus::BANNED);
+}
+
+// A crash may cut the log anywhere, every whole record before the cut is read
+void TestTruncatedTail(){
+    const std::string path = MakeTempPath("truncated.qlog");
+    {
+        QueryLogWriter writer(path);
+        writer.Record("cat"s, DocumentStatus::ACTUAL);
+        writer.Record(std::string(200, 'x'), DocumentStatus::BANNED);
+        writer.Record("dog"s, DocumentStatus::ACTUAL);
+    }
+    const QueryLog full = ReadQueryLog(path);
+    ASSERT_EQUAL(full.queries.size(), 3u);
+    const auto size = std::filesystem::file_size(path);
+    std::size_t previous_count = full.queries.size();
+    for (auto cut = size; cut-- > 16;){
+        std::filesystem::resize_file(path, cut);
+        const QueryLog log = ReadQueryLog(path);
+        ASSERT_HINT(log.queries.size() <= previous_count, std::to_string(cut));
+        ASSERT_HINT(log.queries.size() < full.queries.size(), std::to_string(cut));
+        for (std::size_t i = 0; i < log.queries.size(); ++i){
+            ASSERT_EQUAL(log.queries[i].raw_query, full.queries[i].raw_query);
+            ASSERT_EQUAL(log.queries[i].time_ns, full.queries[i].time_ns);
+        }
+        previous_count = log.queries.size();
+    }
+    ASSERT_EQUAL(previous_count, 0u);
+}
+
+void TestRejectsOtherFiles(){
+    const std::string path = MakeTempPath("other.qlog");
+    std::ofstream(path, std::ios::binary) << "not a query log at all";
+    ASSERT_THROWS(ReadQueryLog(path), std::invalid_argument);
+    std::ofstream(path, std::ios::binary) << "SRCHQLG";
+    ASSERT_THROWS(ReadQueryLog(path), std::invalid_argument);
+
+    {
+        QueryLogWriter writer(path);
+        writer.Record("cat"s, DocumentStatus::ACTUAL);
+    }
+    // The status byte comes before the one byte length of the text
+    std::string contents;
+    {
+        std::ifstream input(path, std::ios::binary);
+        contents.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    }
+    ASSERT_EQUAL(contents.substr(contents.size() - 5), "\x00\x03"s "cat"s);
+    contents[contents.size() - 5] = static_cast<char>(100);
+    std::ofstream(path, std::ios::binary) << contents;
+    ASSERT_THROWS(ReadQueryLog(path), std::invalid_argument);
+
+    ASSERT_THROWS(ReadQueryLog(MakeTempPath("missing.qlog")), std::runtime_error);
+    ASSERT_THROWS(QueryLogWriter(MakeTempPath("missing_directory") + "/log.qlog"s), std::runtime_error);
+}
+
+void TestConcurrentRecords(){
+    const std::string path = MakeTempPath("concurrent.qlog");
+    {
+        QueryLogWriter writer(path);
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < 4; ++thread){
+            threads.emplace_back([&writer, thread]{
+                for (int i = 0; i < 2000; ++i){
+                    writer.Record("query "s + std::to_string(thread), DocumentStatus::ACTUAL);
+                }
+            });
+        }
+        for (std::thread &thread : threads){
+            thread.join();
+        }
+        ASSERT_EQUAL(writer.GetRecordCount(), 8000u);
+    }
+    const QueryLog log = ReadQueryLog(path);
+    ASSERT_EQUAL(log.queries.size(), 8000u);
+    std::vector<int> counts(4);
+    for (std::size_t i = 0; i < log.queries.size(); ++i){
+        ASSERT(i == 0 || log.queries[i - 1].time_ns <= log.queries[i].time_ns);
+        ++counts.at(log.queries[i].raw_query.back() - '0');
+    }
+    for (const int count : counts){
+        ASSERT_EQUAL(count, 2000);
+    }
+}
+
+} // namespace
+
+void TestQueryLog(){
+    RUN_TEST(TestRoundTrip);
+    RUN_TEST(TestRequestQueueRecords);
+    RUN_TEST(TestTruncatedTail);
+    RUN_TEST(TestRejectsOtherFiles);
+    RUN_TEST(TestConcurrentRecords);
+}
@@ -0,0 +1,149 @@
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include "query_planner.h"
+#include "search_server.h"
+#include "test_example_functions.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+void TestExplainQuery(){
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "cat cat dog"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "cat bird cow"s, DocumentStatus::ACTUAL, {2});
+    search_server.AddDocument(3, "cat dog fish"s, DocumentStatus::BANNED, {3});
+    search_server.AddDocument(4, "cow"s, DocumentStatus::ACTUAL, {4});
+
+    const QueryPlan plan = search_server.ExplainQuery("cat bird and dog missing -fish -cow"s);
+    ASSERT_EQUAL(plan.terms.size(), 5u);
+    // Rarest first, plus terms before minus terms
+    const std::vector<std::string> words{"bird"s, "dog"s, "cat"s, "fish"s, "cow"s};
+    for (std::size_t i = 0; i < words.size(); ++i){
+        ASSERT_EQUAL(std::string{plan.terms[i].word}, words[i]);
+        ASSERT_EQUAL(plan.terms[i].is_minus, i >= 3);
+    }
+    ASSERT_EQUAL(plan.terms[0].document_freq, 1u);
+    ASSERT_EQUAL(plan.terms[1].document_freq, 2u);
+    ASSERT_EQUAL(plan.terms[2].document_freq, 3u);
+    ASSERT_EQUAL(plan.plus_postings, 6u);
+    ASSERT_EQUAL(plan.minus_postings, 3u);
+    // cat makes up two thirds of document 1
+    const double cat_idf = std::log(4.0 / 3.0);
+    ASSERT(std::abs(plan.terms[2].inverse_document_freq - cat_idf) < 1e-12);
+    ASSERT(std::abs(plan.terms[2].max_relevance - cat_idf * 2.0 / 3.0) < 1e-12);
+    ASSERT_EQUAL(plan.terms[3].max_relevance, 0.0);
+
+    const std::string text = plan.ToString();
+    ASSERT_EQUAL(text.substr(0, text.find(':')), std::string{GetStrategyName(plan.strategy)});
+    ASSERT(text.find("+bird df=1"s) < text.find("+cat df=3"s));
+    ASSERT(text.find("-fish df=1"s) != std::string::npos);
+    ASSERT(text.find("missing"s) == std::string::npos);
+
+    ASSERT_THROWS(search_server.ExplainQuery("cat --dog"s), std::invalid_argument);
+    const QueryPlan empty = SearchServer(""s).ExplainQuery("cat"s);
+    ASSERT(empty.strategy == QueryStrategy::TAAT);
+    ASSERT(empty.terms.empty());
+
+    ASSERT_EQUAL(std::string{GetStrategyName(QueryStrategy::TAAT)}, "TAAT"s);
+    ASSERT_EQUAL(std::string{GetStrategyName(QueryStrategy::BITMAP)}, "BITMAP"s);
+    ASSERT_EQUAL(std::string{GetStrategyName(QueryStrategy::WAND)}, "WAND"s);
+}
+
+// Word frequencies of the planner tests: posting lists range from a few
+// documents to a third of them
+constexpr double WORD_PROBABILITY = 0.02;
+
+// Holds the same documents twice: with dense ids, and with ids spread out
+// so that the planner never finds a bitmap worth it
+struct PlannerServers{
+    static constexpr int ID_SPREAD = 1000;
+
+    SearchServer dense{"and"s};
+    SearchServer sparse{"and"s};
+};
+
+void AddDocuments(PlannerServers &servers){
+    std::mt19937 generator(7);
+    for (int id = 0; id < 3000; ++id){
+        const std::string text = MakeWords(generator, 5 + id % 20, WORD_PROBABILITY);
+        const auto status = id % 11 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+        // Distinct ratings, so that equal relevances have one order
+        servers.dense.AddDocument(id, text, status, {id});
+        servers.sparse.AddDocument(id * PlannerServers::ID_SPREAD, text, status, {id});
+    }
+}
+
+// Every strategy ranks the documents like the parallel policy, which always
+// runs TAAT, and like the same query on the other id layout
+void TestStrategiesAgree(){
+    PlannerServers servers;
+    AddDocuments(servers);
+    std::mt19937 generator(11);
+    std::vector<int> strategy_counts(3);
+    for (int i = 0; i < 400; ++i){
+        std::string query = MakeWords(generator, 1 + i % 6, WORD_PROBABILITY);
+        if (i % 4 == 0){
+            query += " -"s + MakeWords(generator, 1, WORD_PROBABILITY).substr(1);
+        }
+        const DocumentStatus status = i % 5 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+
+        QueryStats stats;
+        const std::vector<Document> dense = servers.dense.FindTopDocuments(query, status, stats);
+        ASSERT_HINT(stats.strategy == servers.dense.ExplainQuery(query).strategy, query);
+        ++strategy_counts[static_cast<int>(stats.strategy)];
+        ASSERT_HINT(AreSameDocuments(dense, servers.dense.FindTopDocuments(std::execution::par, query, status)),
+                    query);
+
+        std::vector<Document> sparse = servers.sparse.FindTopDocuments(query, status, stats);
+        ASSERT_HINT(stats.strategy != QueryStrategy::BITMAP, query);
+        ++strategy_counts[static_cast<int>(stats.strategy)];
+        for (Document &document : sparse){
+            document.id /= PlannerServers::ID_SPREAD;
+        }
+        ASSERT_HINT(AreSameDocuments(dense, sparse), query + ": "s + PrintDocumentIds(dense) + " != "s
+                    + PrintDocumentIds(sparse));
+    }
+    ASSERT_HINT(strategy_counts[static_cast<int>(QueryStrategy::TAAT)] > 20, "TAAT");
+    ASSERT_HINT(strategy_counts[static_cast<int>(QueryStrategy::BITMAP)] > 20, "BITMAP");
+    ASSERT_HINT(strategy_counts[static_cast<int>(QueryStrategy::WAND)] > 20, "WAND");
+}
+
+// WAND skips documents but must not lose any: once the top holds documents
+// with the rare term, the cursors skip most of the frequent one
+void TestWandKeepsTheTop(){
+    SearchServer search_server(""s);
+    for (int id = 0; id < 2000; ++id){
+        std::string text = id % 4 != 1 ? "common"s : "other"s;
+        if (id % 50 == 3){
+            text += " rare"s;
+        }
+        if (id % 200 == 3){
+            text += " excluded"s;
+        }
+        search_server.AddDocument(id, text, id % 3 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL, {id});
+    }
+    for (const std::string &query : {"common rare"s, "rare common -excluded"s}){
+        QueryStats stats;
+        const std::vector<Document> documents = search_server.FindTopDocuments(query, stats);
+        ASSERT_HINT(stats.strategy == QueryStrategy::WAND, query);
+        ASSERT_HINT(AreSameDocuments(documents, search_server.FindTopDocuments(std::execution::par, query)), query);
+        ASSERT_EQUAL(documents.size(), static_cast<std::size_t>(MAX_RESULT_DOCUMENT_COUNT));
+        for (const Document &document : documents){
+            ASSERT_HINT(document.id % 50 == 3, query);
+        }
+        const QueryPlan plan = search_server.ExplainQuery(query);
+        ASSERT(plan.strategy == QueryStrategy::WAND);
+        ASSERT_HINT(stats.postings_scanned < plan.plus_postings / 2, query);
+    }
+}
+
+} // namespace
+
+void TestQueryPlanner(){
+    RUN_TEST(TestExplainQuery);
+    RUN_TEST(TestStrategiesAgree);
+    RUN_TEST(TestWandKeepsTheTop);
+}
@@ -0,0 +1,128 @@
+#include <chrono>
+#include <string>
+#include <vector>
+#include "query_stats.h"
+#include "search_server.h"
+#include "test_example_functions.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+SearchServer MakeStatsServer(){
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "white cat and collar"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "fluffy cat tail"s, DocumentStatus::ACTUAL, {2});
+    search_server.AddDocument(3, "groomed dog cat"s, DocumentStatus::ACTUAL, {3});
+    search_server.AddDocument(4, "cat dog"s, DocumentStatus::BANNED, {4});
+    return search_server;
+}
+
+void CheckCounts(const QueryStats &stats){
+    // Unknown words and stop words are not terms
+    ASSERT_EQUAL(stats.plus_terms, 2u);
+    ASSERT_EQUAL(stats.minus_terms, 1u);
+    // cat 4, collar 1, dog 2
+    ASSERT_EQUAL(stats.postings_scanned, 7u);
+    // The banned document holds cat
+    ASSERT_EQUAL(stats.postings_rejected_by_predicate, 1u);
+    ASSERT_EQUAL(stats.documents_scored, 3u);
+    ASSERT_EQUAL(stats.documents_removed_by_minus, 1u);
+    ASSERT_EQUAL(stats.documents_returned, 2u);
+    ASSERT(stats.parse_ns + stats.accumulation_ns + stats.minus_filtering_ns + stats.result_building_ns
+           + stats.top_k_ns <= stats.total_ns);
+}
+
+void TestStatsCountTheWork(){
+    const SearchServer search_server = MakeStatsServer();
+    const std::string query = "cat and collar missing -dog"s;
+    QueryStats stats;
+    const std::vector<Document> documents = search_server.FindTopDocuments(query, stats);
+    ASSERT(AreSameDocuments(documents, search_server.FindTopDocuments(query)));
+    CheckCounts(stats);
+
+    QueryStats par_stats;
+    const std::vector<Document> par_documents = search_server.FindTopDocuments(std::execution::par, query, par_stats);
+    ASSERT(AreSameDocuments(par_documents, documents));
+    CheckCounts(par_stats);
+    ASSERT(par_stats.strategy == QueryStrategy::TAAT);
+
+    // Stats are overwritten, not added to
+    search_server.FindTopDocuments("tail"s, DocumentStatus::ACTUAL, stats);
+    ASSERT_EQUAL(stats.plus_terms, 1u);
+    ASSERT_EQUAL(stats.minus_terms, 0u);
+    ASSERT_EQUAL(stats.postings_scanned, 1u);
+    ASSERT_EQUAL(stats.postings_rejected_by_predicate, 0u);
+    ASSERT_EQUAL(stats.documents_scored, 1u);
+    ASSERT_EQUAL(stats.documents_removed_by_minus, 0u);
+    ASSERT_EQUAL(stats.documents_returned, 1u);
+
+    search_server.FindTopDocuments("missing"s, stats);
+    ASSERT_EQUAL(stats.plus_terms, 0u);
+    ASSERT_EQUAL(stats.postings_scanned, 0u);
+    ASSERT_EQUAL(stats.documents_returned, 0u);
+}
+
+void TestSlowQueryLogKeepsTheLatest(){
+    ASSERT_THROWS(SlowQueryLog({std::chrono::nanoseconds(0), 0}), std::invalid_argument);
+
+    SlowQueryLog log({std::chrono::milliseconds(5), 2});
+    QueryStats stats;
+    stats.total_ns = 4999999;
+    ASSERT(!log.Record("fast"s, stats));
+    for (int i = 0; i < 3; ++i){
+        stats.total_ns = 5000000 + i;
+        ASSERT(log.Record("slow"s + std::to_string(i), stats));
+    }
+    const std::vector<SlowQuery> queries = log.GetQueries();
+    ASSERT_EQUAL(queries.size(), 2u);
+    ASSERT_EQUAL(queries[0].raw_query, "slow1"s);
+    ASSERT_EQUAL(queries[1].raw_query, "slow2"s);
+    ASSERT_EQUAL(queries[1].stats.total_ns, 5000002u);
+    ASSERT(queries[0].time <= queries[1].time);
+    ASSERT_EQUAL(log.GetSlowQueryCount(), 3u);
+
+    log.Clear();
+    ASSERT(log.GetQueries().empty());
+    ASSERT_EQUAL(log.GetSlowQueryCount(), 0u);
+}
+
+void TestServerFeedsTheLog(){
+    SearchServer search_server = MakeStatsServer();
+    SlowQueryLog log({std::chrono::nanoseconds(0), 16});
+    search_server.SetSlowQueryLog(&log);
+
+    const std::string query = "cat collar -dog"s;
+    search_server.FindTopDocuments(query);
+    search_server.FindTopDocuments(std::execution::par, query);
+    QueryStats stats;
+    search_server.FindTopDocuments(query, stats);
+    search_server.FindTopDocuments(search_server.CompileQuery(query));
+    // Matching is not a search
+    search_server.MatchDocument(query, 1);
+
+    const std::vector<SlowQuery> queries = log.GetQueries();
+    ASSERT_EQUAL(queries.size(), 4u);
+    for (const SlowQuery &slow_query : queries){
+        ASSERT_EQUAL(slow_query.raw_query, query);
+        CheckCounts(slow_query.stats);
+    }
+    ASSERT_EQUAL(queries[2].stats.total_ns, stats.total_ns);
+
+    SlowQueryLog patient_log({std::chrono::hours(1), 16});
+    search_server.SetSlowQueryLog(&patient_log);
+    search_server.FindTopDocuments(query);
+    ASSERT(patient_log.GetQueries().empty());
+
+    search_server.SetSlowQueryLog(nullptr);
+    search_server.FindTopDocuments(query);
+    ASSERT_EQUAL(log.GetSlowQueryCount(), 4u);
+}
+
+} // namespace
+
+void TestQueryStats(){
+    RUN_TEST(TestStatsCountTheWork);
+    RUN_TEST(TestSlowQueryLogKeepsTheLatest);
+    RUN_TEST(TestServerFeedsTheLog);
+}
@@ -0,0 +1,276 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "inverted_index.h"
+#include "search_server.h"
+#include "test_example_functions.h"
+
+using namespace std::string_literals;
+using namespace std::string_view_literals;
+
+namespace {
+
+SearchServer MakeSampleServer(){
+    SearchServer search_server("and in on"s);
+    search_server.AddDocument(1, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, {8, -3});
+    search_server.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server.AddDocument(3, "groomed dog expressive eyes"s, DocumentStatus::ACTUAL, {5, -12, 2, 1});
+    search_server.AddDocument(4, "groomed starling eugene"s, DocumentStatus::BANNED, {9});
+    search_server.AddDocument(5, "cat on the collar of a dog"s, DocumentStatus::ACTUAL, {1, 1});
+    return search_server;
+}
+
+// CompiledQuery
+
+void TestCompiledQueryMatchesRawQuery(){
+    const SearchServer search_server = MakeSampleServer();
+    for (const std::string &raw_query : {"fluffy groomed cat"s, "cat -collar"s, "dog eyes -fluffy"s, "nothing"s}){
+        const SearchServer::CompiledQuery query = search_server.CompileQuery(raw_query);
+        ASSERT_EQUAL(query.GetRawQuery(), raw_query);
+        ASSERT_HINT(AreSameDocuments(search_server.FindTopDocuments(query), search_server.FindTopDocuments(raw_query)),
+                    raw_query);
+        for (int document_id : search_server){
+            ASSERT_HINT(search_server.MatchDocument(query, document_id)
+                        == search_server.MatchDocument(raw_query, document_id), raw_query);
+        }
+    }
+    ASSERT_THROWS(search_server.CompileQuery("cat --collar"s), std::invalid_argument);
+    ASSERT_THROWS(search_server.CompileQuery("cat -"s), std::invalid_argument);
+}
+
+// A query compiled before a change is parsed again, so it sees new terms
+// and the new document frequencies
+void TestCompiledQueryFollowsIndexChanges(){
+    SearchServer search_server = MakeSampleServer();
+    const SearchServer::CompiledQuery query = search_server.CompileQuery("parrot cat"s);
+    search_server.AddDocument(6, "green parrot"s, DocumentStatus::ACTUAL, {3});
+    ASSERT(AreSameDocuments(search_server.FindTopDocuments(query), search_server.FindTopDocuments("parrot cat"s)));
+    ASSERT_EQUAL(search_server.FindTopDocuments(query).front().id, 6);
+    search_server.RemoveDocument(6);
+    ASSERT(AreSameDocuments(search_server.FindTopDocuments(query), search_server.FindTopDocuments("parrot cat"s)));
+    ASSERT_EQUAL(std::get<0>(search_server.MatchDocument(query, 2)).size(), 1u);
+}
+
+// MatchDocuments
+
+void TestMatchDocumentsMatchesSingleCalls(){
+    const SearchServer search_server = MakeSampleServer();
+    const std::vector<int> ids = {5, 1, 2, 3, 4, 1};
+    for (const std::string &raw_query : {"fluffy groomed cat collar"s, "cat -dog"s, "eugene"s}){
+        const auto seq = search_server.MatchDocuments(std::execution::seq, raw_query, ids);
+        const auto par = search_server.MatchDocuments(std::execution::par, search_server.CompileQuery(raw_query), ids);
+        ASSERT_EQUAL(seq.size(), ids.size());
+        for (std::size_t i = 0; i < ids.size(); ++i){
+            ASSERT_HINT(seq[i] == search_server.MatchDocument(raw_query, ids[i]), raw_query);
+            ASSERT_HINT(par[i] == seq[i], raw_query);
+        }
+    }
+    const auto [words, status] = search_server.MatchDocuments(std::execution::seq, "collar cat white"s,
+                                                               std::vector<int>{1}).front();
+    // Words come sorted, like MatchDocument returns them
+    ASSERT(words == std::vector<std::string_view>({"cat", "collar", "white"}));
+    ASSERT(status == DocumentStatus::ACTUAL);
+    ASSERT_THROWS(search_server.MatchDocuments(std::execution::par, "cat"s, std::vector<int>{1, 42}),
+                  std::out_of_range);
+}
+
+// Forward index
+
+std::map<std::string_view, double> ToMap(const WordFrequencies &frequencies){
+    return {frequencies.begin(), frequencies.end()};
+}
+
+void TestWordFrequencies(){
+    const SearchServer search_server = MakeSampleServer();
+    const std::map<std::string_view, double> expected = {{"fluffy", 0.5}, {"cat", 0.25}, {"tail", 0.25}};
+    ASSERT(ToMap(search_server.GetWordFrequencies(2)) == expected);
+    ASSERT_EQUAL(search_server.GetWordFrequencies(1).size(), 4u);
+    ASSERT(search_server.GetWordFrequencies(42).size() == 0);
+}
+
+// Removing most documents compacts the shared forward index, the
+// remaining documents keep their words
+void TestWordFrequenciesSurviveCompaction(){
+    SearchServer search_server(""s);
+    std::map<int, std::map<std::string_view, double>> expected;
+    for (int id = 0; id < 200; ++id){
+        search_server.AddDocument(id, "w"s + std::to_string(id) + " common w"s + std::to_string(id % 7),
+                                  DocumentStatus::ACTUAL, {1});
+    }
+    for (int id = 0; id < 200; ++id){
+        if (id % 5 != 0){
+            search_server.RemoveDocument(id);
+        }else{
+            expected[id] = ToMap(search_server.GetWordFrequencies(id));
+        }
+    }
+    const MemoryStats stats = search_server.GetMemoryStats();
+    ASSERT(stats.dead_forward_entry_count * 2 <= stats.forward_entry_count);
+    for (const auto &[id, frequencies] : expected){
+        ASSERT(ToMap(search_server.GetWordFrequencies(id)) == frequencies);
+        ASSERT_EQUAL(frequencies.size(), id % 7 == id ? 2u : 3u);
+    }
+    ASSERT_EQUAL(search_server.GetWordFrequencies(1).size(), 0u);
+}
+
+// Term counts
+
+static_assert(sizeof(Posting) == 8 && sizeof(ForwardEntry) == 8);
+
+// tf rebuilt from the count and the word count matches the plain formula
+void TestRelevanceFromTermCounts(){
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "cat cat dog and"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "cat bird bird bird fish fish eel"s, DocumentStatus::ACTUAL, {2});
+    search_server.AddDocument(3, "dog"s, DocumentStatus::ACTUAL, {3});
+    const std::vector<Document> documents = search_server.FindTopDocuments("cat bird dog"s);
+    const std::map<int, double> expected = {
+        {1, 2.0 / 3 * std::log(3.0 / 2) + 1.0 / 3 * std::log(3.0 / 2)},
+        {2, 1.0 / 7 * std::log(3.0 / 2) + 3.0 / 7 * std::log(3.0)},
+        {3, 1.0 * std::log(3.0 / 2)},
+    };
+    ASSERT_EQUAL(documents.size(), 3u);
+    for (const Document &document : documents){
+        ASSERT_HINT(std::abs(document.relevance - expected.at(document.id)) < 1e-12, std::to_string(document.id));
+    }
+    const std::map<std::string_view, double> expected_frequencies = {
+        {"cat", 1.0 / 7}, {"bird", 3.0 / 7}, {"fish", 2.0 / 7}, {"eel", 1.0 / 7}};
+    const auto frequencies = ToMap(search_server.GetWordFrequencies(2));
+    ASSERT_EQUAL(frequencies.size(), expected_frequencies.size());
+    for (const auto &[word, frequency] : expected_frequencies){
+        ASSERT_HINT(std::abs(frequencies.at(word) - frequency) < 1e-15, std::string{word});
+    }
+}
+
+// Counts are not quantized, repeats beyond 8 and 16 bits are exact
+void TestLargeTermCounts(){
+    SearchServer search_server(""s);
+    std::string text;
+    for (int i = 0; i < 70000; ++i){
+        text += "cat "s;
+    }
+    search_server.AddDocument(1, text + "dog"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "bird"s, DocumentStatus::ACTUAL, {1});
+    const auto frequencies = ToMap(search_server.GetWordFrequencies(1));
+    ASSERT(std::abs(frequencies.at("cat") - 70000.0 / 70001) < 1e-15);
+    ASSERT(std::abs(frequencies.at("dog") - 1.0 / 70001) < 1e-15);
+    const std::vector<Document> documents = search_server.FindTopDocuments("cat"s);
+    ASSERT_EQUAL(documents.size(), 1u);
+    ASSERT(std::abs(documents[0].relevance - 70000.0 / 70001 * std::log(2.0)) < 1e-12);
+}
+
+// Duplicates
+
+void TestFindDuplicates(){
+    SearchServer search_server("and"s);
+    search_server.AddDocument(3, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    search_server.AddDocument(1, "rat nasty pet funny funny"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "funny pet with curly hair"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(4, "funny pet and curly hair with"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(5, "nasty rat"s, DocumentStatus::ACTUAL, {1});
+    ASSERT(search_server.FindDuplicates() == std::vector<int>({3, 4}));
+    ASSERT(search_server.GetDocumentFingerprint(1) == search_server.GetDocumentFingerprint(3));
+}
+
+void TestDuplicatePolicies(){
+    SearchServer search_server(""s);
+    search_server.SetDuplicatePolicy(DuplicatePolicy::FLAG);
+    search_server.AddDocument(1, "big cat"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "cat big big"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(3, "big dog"s, DocumentStatus::ACTUAL, {1});
+    ASSERT(!search_server.IsDuplicate(1) && search_server.IsDuplicate(2) && !search_server.IsDuplicate(3));
+    search_server.SetDuplicatePolicy(DuplicatePolicy::REJECT);
+    ASSERT_THROWS(search_server.AddDocument(4, "cat big"s, DocumentStatus::ACTUAL, {1}), std::invalid_argument);
+    search_server.RemoveDocument(1);
+    search_server.RemoveDocument(2);
+    search_server.AddDocument(4, "cat big"s, DocumentStatus::ACTUAL, {1});
+    ASSERT_EQUAL(search_server.GetDocumentCount(), 2);
+}
+
+// Replaces the fingerprint of document target by the one of document source
+// in a snapshot, as a hash collision would produce, and fixes the checksum
+SearchServer LoadWithCollidingFingerprints(const SearchServer &search_server, int source, int target){
+    std::stringstream stream;
+    search_server.Save(stream);
+    std::string snapshot = stream.str();
+    const DocumentFingerprint source_fingerprint = search_server.GetDocumentFingerprint(source);
+    const DocumentFingerprint target_fingerprint = search_server.GetDocumentFingerprint(target);
+    char target_bytes[sizeof(DocumentFingerprint)];
+    std::memcpy(target_bytes, &target_fingerprint, sizeof(target_bytes));
+    const auto position = std::search(snapshot.begin(), snapshot.end(), target_bytes, target_bytes + sizeof(target_bytes));
+    ASSERT(position != snapshot.end());
+    std::memcpy(&*position, &source_fingerprint, sizeof(source_fingerprint));
+    UpdateSnapshotChecksum(snapshot);
+    stream.str(snapshot);
+    return SearchServer::Load(stream);
+}
+
+void TestFingerprintCollisionsAreNotDuplicates(){
+    SearchServer search_server(""s);
+    search_server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "cat bird"s, DocumentStatus::ACTUAL, {1});
+    SearchServer colliding = LoadWithCollidingFingerprints(search_server, 2, 1);
+    ASSERT(colliding.GetDocumentFingerprint(1) == colliding.GetDocumentFingerprint(2));
+    ASSERT(colliding.FindDuplicates().empty());
+    colliding.SetDuplicatePolicy(DuplicatePolicy::REJECT);
+    colliding.RemoveDocument(2);
+    // Collides with document 1, whose words differ
+    colliding.AddDocument(2, "bird cat"s, DocumentStatus::ACTUAL, {1});
+    ASSERT_THROWS(colliding.AddDocument(3, "cat bird"s, DocumentStatus::ACTUAL, {1}), std::invalid_argument);
+}
+
+// Copied and borrowed texts
+
+// Only new terms are copied, the text itself is not kept
+void TestTextsAreNotKept(){
+    SearchServer search_server(""s);
+    {
+        std::string text;
+        for (int i = 0; i < 100000; ++i){
+            text += "repeated word"s + std::to_string(i % 3) + " "s;
+        }
+        search_server.AddDocument(1, text, DocumentStatus::ACTUAL, {1});
+    }
+    const MemoryStats stats = search_server.GetMemoryStats();
+    ASSERT_EQUAL(stats.term_count, 4u);
+    ASSERT_HINT(stats.GetTotalBytes() < 256 * 1024, std::to_string(stats.GetTotalBytes()));
+    const auto [words, status] = search_server.MatchDocument("word2 missing"s, 1);
+    ASSERT(words == std::vector<std::string_view>({"word2"sv}));
+}
+
+void TestBorrowedTextsAreNotCopied(){
+    const std::string corpus = "white cat\ndog with collar\n"s;
+    SearchServer search_server(""s);
+    search_server.BorrowText(corpus);
+    search_server.AddDocument(1, std::string_view{corpus}.substr(0, 9), DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, std::string_view{corpus}.substr(10, 15), DocumentStatus::ACTUAL, {1});
+    ASSERT_EQUAL(search_server.GetMemoryStats().term_text_bytes, 0u);
+    const auto [words, status] = search_server.MatchDocument("collar cat"s, 2);
+    ASSERT_EQUAL(words.size(), 1u);
+    ASSERT(words[0].data() == corpus.data() + 19);
+    // Words outside the borrowed text are copied
+    search_server.AddDocument(3, "fluffy cat"s, DocumentStatus::ACTUAL, {1});
+    ASSERT(search_server.GetMemoryStats().term_text_bytes > 0);
+    ASSERT_EQUAL(search_server.FindTopDocuments("cat"s).size(), 2u);
+}
+
+} // namespace
+
+void TestSearchServer(){
+    RUN_TEST(TestCompiledQueryMatchesRawQuery);
+    RUN_TEST(TestCompiledQueryFollowsIndexChanges);
+    RUN_TEST(TestMatchDocumentsMatchesSingleCalls);
+    RUN_TEST(TestWordFrequencies);
+    RUN_TEST(TestWordFrequenciesSurviveCompaction);
+    RUN_TEST(TestRelevanceFromTermCounts);
+    RUN_TEST(TestLargeTermCounts);
+    RUN_TEST(TestFindDuplicates);
+    RUN_TEST(TestDuplicatePolicies);
+    RUN_TEST(TestFingerprintCollisionsAreNotDuplicates);
+    RUN_TEST(TestTextsAreNotKept);
+    RUN_TEST(TestBorrowedTextsAreNotCopied);
+}
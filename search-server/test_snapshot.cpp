@@ -0,0 +1,160 @@
+#include <cstring>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include "search_server.h"
+#include "test_example_functions.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+// Layout of a document record in the snapshot
+constexpr std::size_t RECORD_SIZE = 48;
+constexpr std::size_t RECORD_STATUS_OFFSET = 8;
+constexpr std::size_t RECORD_WORD_COUNT_OFFSET = 40;
+
+SearchServer MakeServer(){
+    SearchServer search_server("and with"s);
+    search_server.SetDuplicatePolicy(DuplicatePolicy::FLAG);
+    for (int id = 0; id < 60; ++id){
+        std::string text = "word"s + std::to_string(id % 13) + " common and w"s + std::to_string(id % 5);
+        for (int i = 0; i < id % 4; ++i){
+            text += " common"s;
+        }
+        search_server.AddDocument(id * 3, text, static_cast<DocumentStatus>(id % 4), {id, -id / 2, 3});
+    }
+    for (int id = 0; id < 60; id += 7){
+        search_server.RemoveDocument(id * 3);
+    }
+    return search_server;
+}
+
+std::string Save(const SearchServer &search_server){
+    std::ostringstream output;
+    search_server.Save(output);
+    return output.str();
+}
+
+SearchServer Load(const std::string &snapshot){
+    std::istringstream input(snapshot);
+    return SearchServer::Load(input);
+}
+
+// Offset of the record of a document with the given id and rating
+std::size_t FindRecord(const std::string &snapshot, std::int32_t document_id, std::int32_t rating){
+    char pattern[2 * sizeof(std::int32_t)];
+    std::memcpy(pattern, &document_id, sizeof(document_id));
+    std::memcpy(pattern + sizeof(document_id), &rating, sizeof(rating));
+    const std::size_t offset = snapshot.find(std::string_view(pattern, sizeof(pattern)));
+    ASSERT(offset != std::string::npos);
+    return offset;
+}
+
+// Reads a string without letting the stream seek, like a pipe
+class ForwardOnlyBuffer : public std::streambuf{
+public:
+    explicit ForwardOnlyBuffer(std::string &data){
+        setg(data.data(), data.data(), data.data() + data.size());
+    }
+};
+
+void TestRoundTrip(){
+    const SearchServer search_server = MakeServer();
+    const SearchServer loaded = Load(Save(search_server));
+    ASSERT_EQUAL(loaded.GetDocumentCount(), search_server.GetDocumentCount());
+    ASSERT(std::equal(loaded.begin(), loaded.end(), search_server.begin(), search_server.end()));
+    ASSERT(loaded.GetDuplicatePolicy() == DuplicatePolicy::FLAG);
+    for (const std::string &query : {"common"s, "word3 w1 -word7"s, "w0 w1 w2 w3 w4"s, "word12 common -w2"s}){
+        for (const DocumentStatus status : {DocumentStatus::ACTUAL, DocumentStatus::BANNED}){
+            ASSERT_HINT(AreSameDocuments(loaded.FindTopDocuments(query, status),
+                                         search_server.FindTopDocuments(query, status)), query);
+        }
+        ASSERT_HINT(AreSameDocuments(loaded.FindTopDocuments(std::execution::par, query),
+                                     search_server.FindTopDocuments(std::execution::par, query)), query);
+        ASSERT_EQUAL(loaded.ExplainQuery(query).ToString(), search_server.ExplainQuery(query).ToString());
+    }
+    for (int document_id : search_server){
+        ASSERT(loaded.MatchDocument("word1 common w2"s, document_id)
+               == search_server.MatchDocument("word1 common w2"s, document_id));
+        ASSERT_EQUAL(loaded.IsDuplicate(document_id), search_server.IsDuplicate(document_id));
+        const auto expected = search_server.GetWordFrequencies(document_id);
+        const auto frequencies = loaded.GetWordFrequencies(document_id);
+        ASSERT(std::equal(frequencies.begin(), frequencies.end(), expected.begin(), expected.end()));
+    }
+    // Saving the loaded index gives the same bytes
+    ASSERT(Save(loaded) == Save(search_server));
+    ASSERT_EQUAL(Load(Save(SearchServer{})).GetDocumentCount(), 0);
+}
+
+void TestTruncatedSnapshots(){
+    const std::string snapshot = Save(MakeServer());
+    for (std::size_t size = 0; size < snapshot.size(); ++size){
+        ASSERT_THROWS(Load(snapshot.substr(0, size)), std::invalid_argument);
+    }
+}
+
+// Any flipped bit is caught, by a range check or by the checksum
+void TestDamagedSnapshots(){
+    const std::string snapshot = Save(MakeServer());
+    for (std::size_t offset = 0; offset < snapshot.size(); ++offset){
+        std::string damaged = snapshot;
+        damaged[offset] = static_cast<char>(damaged[offset] ^ (1 << offset % 8));
+        ASSERT_THROWS(Load(damaged), std::invalid_argument);
+    }
+}
+
+// Damage written with a valid checksum, as a buggy writer could
+void TestOutOfRangeValues(){
+    SearchServer search_server(""s);
+    search_server.AddDocument(77, "cat dog"s, DocumentStatus::ACTUAL, {12345});
+    const std::string snapshot = Save(search_server);
+    const std::size_t record = FindRecord(snapshot, 77, 12345);
+    // The forward index count and then the forward entries follow the record
+    const std::size_t forward_entry = record + RECORD_SIZE + sizeof(std::uint64_t);
+
+    const auto expect_rejected = [&snapshot](std::size_t offset, auto value){
+        std::string damaged = snapshot;
+        Patch(damaged, offset, value);
+        UpdateSnapshotChecksum(damaged);
+        ASSERT_THROWS(Load(damaged), std::invalid_argument);
+    };
+    expect_rejected(record, std::int32_t{-1});
+    expect_rejected(record + RECORD_STATUS_OFFSET, std::int32_t{9});
+    expect_rejected(record + RECORD_WORD_COUNT_OFFSET, std::uint64_t{0});
+    expect_rejected(record + RECORD_WORD_COUNT_OFFSET, std::uint64_t{3});
+    expect_rejected(forward_entry, TermId{1000000});
+    expect_rejected(forward_entry, TermId{1});
+    expect_rejected(snapshot.size() - 2 * sizeof(std::int32_t), std::int32_t{9});
+    // The posting of term 0 names the document
+    const std::size_t posting = snapshot.rfind(std::string_view("\x4d\0\0\0", 4), record - 1);
+    expect_rejected(posting, std::int32_t{78});
+
+    std::string unchanged = snapshot;
+    UpdateSnapshotChecksum(unchanged);
+    ASSERT_EQUAL(Load(unchanged).GetDocumentCount(), 1);
+}
+
+// A damaged count fails on the data, not on a huge allocation
+void TestHugeCounts(){
+    std::string snapshot = Save(MakeServer());
+    // The stop word count is the first value after the header
+    Patch(snapshot, 16, std::uint64_t{1} << 60);
+    UpdateSnapshotChecksum(snapshot);
+    ASSERT_THROWS(Load(snapshot), std::invalid_argument);
+    Patch(snapshot, 16, std::uint64_t{1} << 36);
+    ForwardOnlyBuffer buffer(snapshot);
+    std::istream input(&buffer);
+    ASSERT_THROWS(SearchServer::Load(input), std::invalid_argument);
+}
+
+} // namespace
+
+void TestSnapshots(){
+    RUN_TEST(TestRoundTrip);
+    RUN_TEST(TestTruncatedSnapshots);
+    RUN_TEST(TestDamagedSnapshots);
+    RUN_TEST(TestOutOfRangeValues);
+    RUN_TEST(TestHugeCounts);
+}
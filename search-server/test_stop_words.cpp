@@ -0,0 +1,54 @@
+#include <string>
+#include <vector>
+#include "search_server.h"
+#include "stop_words.h"
+#include "test_example_functions.h"
+
+using namespace std::string_literals;
+using namespace std::string_view_literals;
+
+namespace {
+
+void TestStopWordSetLookup(){
+    std::vector<std::string> words;
+    for (int i = 0; i < 1000; ++i){
+        words.push_back("stop"s + std::to_string(i));
+    }
+    words.push_back(""s);
+    words.push_back("stop7"s);
+    const StopWordSet stop_words(words);
+    ASSERT_EQUAL(stop_words.size(), 1000u);
+    for (int i = 0; i < 1000; ++i){
+        ASSERT(stop_words.Contains("stop"s + std::to_string(i)));
+        ASSERT(!stop_words.Contains("word"s + std::to_string(i)));
+    }
+    ASSERT(!stop_words.Contains(""sv));
+    ASSERT(!StopWordSet{}.Contains("stop1"sv));
+}
+
+void TestConstexprStopWords(){
+    static constexpr std::string_view WORDS[] = {"in"sv, "the"sv, "in"sv};
+    constexpr ConstexprStopWords stop_words(WORDS);
+    static_assert(stop_words.Contains("the"sv));
+    static_assert(!stop_words.Contains("cat"sv));
+    const SearchServer search_server(stop_words);
+    ASSERT(search_server.FindTopDocuments("in"sv).empty());
+}
+
+void TestStopWordsExcludedFromSearch(){
+    SearchServer search_server("in the"s);
+    search_server.AddDocument(1, "cat in the city"s, DocumentStatus::ACTUAL, {1});
+    ASSERT(search_server.FindTopDocuments("in"s).empty());
+    ASSERT_EQUAL(search_server.FindTopDocuments("cat"s).size(), 1u);
+    const auto [words, status] = search_server.MatchDocument("in cat the"s, 1);
+    ASSERT_EQUAL(words.size(), 1u);
+    ASSERT_EQUAL(words[0], "cat"s);
+}
+
+} // namespace
+
+void TestStopWords(){
+    RUN_TEST(TestStopWordSetLookup);
+    RUN_TEST(TestConstexprStopWords);
+    RUN_TEST(TestStopWordsExcludedFromSearch);
+}
@@ -0,0 +1,82 @@
+#include <string>
+#include <vector>
+#include "search_server.h"
+#include "string_processing.h"
+#include "test_example_functions.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+struct Word{
+    std::string_view text;
+    bool is_valid;
+};
+
+std::vector<Word> CollectWords(std::string_view text){
+    std::vector<Word> words;
+    ForEachWord(text, [&words](std::string_view word, bool is_valid){
+        words.push_back({word, is_valid});
+    });
+    return words;
+}
+
+void TestSplitsOnSpaces(){
+    const std::string text = "  cat in  the city "s;
+    const auto words = SplitIntoWords(text);
+    ASSERT_EQUAL(words.size(), 4u);
+    ASSERT_EQUAL(words[0], "cat"s);
+    ASSERT_EQUAL(words[1], "in"s);
+    ASSERT_EQUAL(words[2], "the"s);
+    ASSERT_EQUAL(words[3], "city"s);
+    ASSERT(SplitIntoWords(""s).empty());
+    ASSERT(SplitIntoWords("      "s).empty());
+}
+
+// Words crossing 16 and 32 byte blocks and texts ending inside a block
+// come out the same as from a plain scalar split
+void TestMatchesScalarSplitAcrossBlocks(){
+    for (std::size_t length = 1; length < 100; ++length){
+        std::string text;
+        for (std::size_t i = 0; i < length; ++i){
+            text.push_back(i % 7 == 3 || i % 11 == 0 ? ' ' : static_cast<char>('a' + i % 26));
+        }
+        std::vector<std::string_view> expected;
+        for (std::size_t begin = 0; begin < text.size(); ){
+            const std::size_t end = std::min(text.find(' ', begin), text.size());
+            if (end > begin){
+                expected.push_back(std::string_view{text}.substr(begin, end - begin));
+            }
+            begin = end + 1;
+        }
+        const auto words = CollectWords(text);
+        ASSERT_EQUAL_HINT(words.size(), expected.size(), text);
+        for (std::size_t i = 0; i < words.size(); ++i){
+            ASSERT_EQUAL_HINT(words[i].text, expected[i], text);
+            ASSERT_HINT(words[i].is_valid, text);
+        }
+    }
+}
+
+void TestMarksWordsWithControlCharacters(){
+    const std::string long_word(40, 'x');
+    const std::string text = "ok b\x01" "d "s + long_word + "\x1f " + long_word + " fine"s;
+    const auto words = CollectWords(text);
+    ASSERT_EQUAL(words.size(), 5u);
+    ASSERT(words[0].is_valid);
+    ASSERT(!words[1].is_valid);
+    ASSERT(!words[2].is_valid);
+    ASSERT(words[3].is_valid);
+    ASSERT(words[4].is_valid);
+    ASSERT_THROWS(SearchServer("in b\x02" "d"s), std::invalid_argument);
+    SearchServer search_server(""s);
+    ASSERT_THROWS(search_server.AddDocument(1, "cat b\x03" "d"s, DocumentStatus::ACTUAL, {1}), std::invalid_argument);
+}
+
+} // namespace
+
+void TestStringProcessing(){
+    RUN_TEST(TestSplitsOnSpaces);
+    RUN_TEST(TestMatchesScalarSplitAcrossBlocks);
+    RUN_TEST(TestMarksWordsWithControlCharacters);
+}
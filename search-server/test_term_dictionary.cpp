@@ -0,0 +1,85 @@
+#include <sstream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "search_server.h"
+#include "term_dictionary.h"
+#include "test_example_functions.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+static_assert(!std::is_copy_constructible_v<TermDictionary> && !std::is_copy_assignable_v<TermDictionary>);
+static_assert(std::is_move_constructible_v<TermDictionary> && std::is_move_assignable_v<TermDictionary>);
+static_assert(!std::is_copy_constructible_v<SearchServer> && !std::is_copy_assignable_v<SearchServer>);
+static_assert(std::is_move_constructible_v<SearchServer> && std::is_move_assignable_v<SearchServer>);
+
+void TestInsertAndFind(){
+    TermDictionary terms;
+    ASSERT_EQUAL(terms.Find("cat"s), NO_TERM);
+    std::vector<TermId> ids;
+    // Enough terms for several rehashes and text chunks
+    for (int i = 0; i < 20000; ++i){
+        ids.push_back(terms.Insert("term"s + std::to_string(i)));
+        ASSERT_EQUAL(ids.back(), static_cast<TermId>(i));
+    }
+    ASSERT_EQUAL(terms.size(), 20000u);
+    for (int i = 0; i < 20000; ++i){
+        const std::string term = "term"s + std::to_string(i);
+        ASSERT_EQUAL(terms.Insert(term), ids[i]);
+        ASSERT_EQUAL(terms.Find(term), ids[i]);
+        ASSERT_EQUAL(terms.GetTerm(ids[i]), term);
+        ASSERT_EQUAL(terms.GetHash(ids[i]), HashString(term));
+    }
+    ASSERT_EQUAL(terms.Find("term20000"s), NO_TERM);
+    ASSERT(terms.GetTextBytes() > 0);
+}
+
+void TestBorrowedTermsAreNotCopied(){
+    const std::string text = "borrowed"s;
+    TermDictionary terms;
+    const TermId id = terms.InsertBorrowed(text);
+    ASSERT(terms.GetTerm(id).data() == text.data());
+    ASSERT_EQUAL(terms.GetTextBytes(), 0u);
+    ASSERT_EQUAL(terms.Insert("borrowed"s), id);
+}
+
+void TestSaveLoad(){
+    TermDictionary terms;
+    for (int i = 0; i < 1000; ++i){
+        terms.Insert("w"s + std::to_string(i * 7));
+    }
+    std::stringstream stream;
+    terms.Save(stream);
+    TermDictionary loaded;
+    loaded.Load(stream);
+    ASSERT_EQUAL(loaded.size(), terms.size());
+    for (TermId id = 0; id < terms.size(); ++id){
+        ASSERT_EQUAL(loaded.GetTerm(id), terms.GetTerm(id));
+        ASSERT_EQUAL(loaded.Find(terms.GetTerm(id)), id);
+    }
+}
+
+// Moving keeps the term views valid
+void TestMovedServerSearches(){
+    SearchServer source("and"s);
+    source.AddDocument(1, "white cat and fashionable collar"s, DocumentStatus::ACTUAL, {8, -3});
+    source.AddDocument(2, "fluffy cat fluffy tail"s, DocumentStatus::ACTUAL, {7, 2, 7});
+    const auto expected = source.FindTopDocuments("fluffy cat"s);
+    SearchServer moved(std::move(source));
+    ASSERT(AreSameDocuments(moved.FindTopDocuments("fluffy cat"s), expected));
+    SearchServer assigned;
+    assigned = std::move(moved);
+    ASSERT(AreSameDocuments(assigned.FindTopDocuments("fluffy cat"s), expected));
+    ASSERT_EQUAL(std::get<0>(assigned.MatchDocument("collar and cat"s, 1)).size(), 2u);
+}
+
+} // namespace
+
+void TestTermDictionary(){
+    RUN_TEST(TestInsertAndFind);
+    RUN_TEST(TestBorrowedTermsAreNotCopied);
+    RUN_TEST(TestSaveLoad);
+    RUN_TEST(TestMovedServerSearches);
+}
@@ -0,0 +1,89 @@
+#include <sstream>
+#include <string>
+#include <thread>
+#include "search_server.h"
+#include "test_example_functions.h"
+#include "tracing.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+std::string ExportTrace(){
+    std::ostringstream output;
+    Tracer::Instance().WriteChromeTrace(output);
+    return output.str();
+}
+
+std::size_t CountOccurrences(const std::string &text, const std::string &pattern){
+    std::size_t count = 0;
+    for (std::size_t position = text.find(pattern); position != std::string::npos;
+         position = text.find(pattern, position + pattern.size())){
+        ++count;
+    }
+    return count;
+}
+
+void TestDisabledTracerRecordsNothing(){
+    Tracer &tracer = Tracer::Instance();
+    tracer.SetEnabled(false);
+    tracer.Clear();
+    SearchServer search_server(""s);
+    search_server.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, {1});
+    search_server.FindTopDocuments("cat"s);
+    {
+        const TraceSpan span("test.disabled");
+    }
+    ASSERT_EQUAL(ExportTrace(), "{\"traceEvents\":[\n],\"displayTimeUnit\":\"ns\"}\n"s);
+}
+
+void TestSearchStagesAreTraced(){
+    Tracer &tracer = Tracer::Instance();
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "white cat and collar"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "fluffy dog"s, DocumentStatus::ACTUAL, {1});
+    tracer.Clear();
+    tracer.SetEnabled(true);
+    search_server.FindTopDocuments("cat -dog"s);
+    search_server.FindTopDocumentsBatch({"cat"s, "dog"s, "collar"s});
+    tracer.SetEnabled(false);
+    const std::string trace = ExportTrace();
+    ASSERT_EQUAL(CountOccurrences(trace, "\"name\":\"FindTopDocuments\""s), 1u);
+    ASSERT_EQUAL(CountOccurrences(trace, "\"name\":\"ParseQuery\""s), 4u);
+    ASSERT_EQUAL(CountOccurrences(trace, "\"name\":\"search.parse\""s), 4u);
+    ASSERT(CountOccurrences(trace, "\"name\":\"search.accumulation\""s) >= 2u);
+    ASSERT_EQUAL(CountOccurrences(trace, "\"name\":\"search.top_k\""s), 1u);
+    ASSERT_EQUAL(CountOccurrences(trace, "\"name\":\"FindTopDocumentsBatch\""s), 1u);
+    ASSERT_EQUAL(CountOccurrences(trace, "\"args\":{\"queries\":3}"s), 1u);
+    ASSERT_EQUAL(CountOccurrences(trace, "\"ph\":\"X\""s), CountOccurrences(trace, "\"name\":"s));
+}
+
+// Every thread keeps its latest spans, also after it ends
+void TestThreadRingBuffers(){
+    Tracer &tracer = Tracer::Instance();
+    tracer.Clear();
+    tracer.SetEnabled(true);
+    std::thread([]{
+        for (std::size_t i = 0; i < Tracer::SPANS_PER_THREAD + 10; ++i){
+            const TraceSpan span(i < 10 ? "test.old" : "test.new");
+        }
+    }).join();
+    {
+        const TraceSpan span("test.\"quoted\"");
+    }
+    tracer.SetEnabled(false);
+    const std::string trace = ExportTrace();
+    ASSERT_EQUAL(CountOccurrences(trace, "\"name\":\"test.old\""s), 0u);
+    ASSERT_EQUAL(CountOccurrences(trace, "\"name\":\"test.new\""s), Tracer::SPANS_PER_THREAD);
+    ASSERT_EQUAL(CountOccurrences(trace, "\"name\":\"test.\\\"quoted\\\"\""s), 1u);
+    tracer.Clear();
+    ASSERT_EQUAL(CountOccurrences(ExportTrace(), "\"name\":"s), 0u);
+}
+
+} // namespace
+
+void TestTracing(){
+    RUN_TEST(TestDisabledTracerRecordsNothing);
+    RUN_TEST(TestSearchStagesAreTraced);
+    RUN_TEST(TestThreadRingBuffers);
+}
@@ -0,0 +1,172 @@
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "durable_search_server.h"
+#include "search_server.h"
+#include "test_example_functions.h"
+#include "write_ahead_log.h"
+
+using namespace std::string_literals;
+
+namespace {
+
+constexpr std::uint64_t LOG_MAGIC_SIZE = 8;
+
+const std::vector<std::string> QUERIES = {"cat"s, "dog -collar"s, "bird cat"s, "missing"s};
+
+// Applies the same operations to a server and a log
+void AddDocument(SearchServer &search_server, WriteAheadLog &log, int document_id, const std::string &text){
+    search_server.AddDocument(document_id, text, DocumentStatus::ACTUAL, {document_id});
+    log.LogAddDocument(document_id, text, DocumentStatus::ACTUAL, {document_id});
+}
+
+void TestReplaysLoggedOperations(){
+    const std::string path = MakeTempPath("round_trip.wal");
+    SearchServer expected("and"s);
+    {
+        WriteAheadLog log(path, {4});
+        AddDocument(expected, log, 1, "white cat and collar"s);
+        AddDocument(expected, log, 2, "fluffy cat"s);
+        expected.RemoveDocument(1);
+        log.LogRemoveDocument(1);
+        AddDocument(expected, log, 3, "dog with collar"s);
+        expected.AddDocument(4, "bird", DocumentStatus::BANNED, {-1, 3});
+        log.LogAddDocument(4, "bird", DocumentStatus::BANNED, {-1, 3});
+    }
+    {
+        WriteAheadLog log(path);
+        SearchServer replayed("and"s);
+        ASSERT_EQUAL(log.Replay(replayed), 5u);
+        ASSERT_EQUAL(log.GetLastSequence(), 5u);
+        AssertSameResults(replayed, expected, QUERIES);
+        ASSERT(AreSameDocuments(replayed.FindTopDocuments("bird"s, DocumentStatus::BANNED),
+                                expected.FindTopDocuments("bird"s, DocumentStatus::BANNED)));
+    }
+    {
+        WriteAheadLog log(path);
+        SearchServer replayed("and"s);
+        ASSERT_EQUAL(log.Replay(replayed, 3), 2u);
+        ASSERT_EQUAL(replayed.GetDocumentCount(), 2);
+    }
+    std::remove(path.c_str());
+}
+
+// A torn tail is cut off in place, records logged afterwards replay too
+void TestCutsTornTail(){
+    const std::string path = MakeTempPath("torn_tail.wal");
+    SearchServer expected("and"s);
+    {
+        WriteAheadLog log(path, {1});
+        AddDocument(expected, log, 1, "white cat"s);
+        AddDocument(expected, log, 2, "fluffy dog"s);
+    }
+    const std::string valid = ReadFile(path);
+    for (std::size_t torn = 1; torn < 40; torn += 6){
+        WriteFile(path, valid + std::string(torn, '\x7f'));
+        SearchServer replayed("and"s);
+        {
+            WriteAheadLog log(path);
+            ASSERT_EQUAL(log.Replay(replayed), 2u);
+            ASSERT_EQUAL(ReadFile(path), valid);
+            replayed.AddDocument(3, "bird", DocumentStatus::ACTUAL, {3});
+            log.LogAddDocument(3, "bird", DocumentStatus::ACTUAL, {3});
+        }
+        WriteAheadLog log(path);
+        SearchServer again("and"s);
+        ASSERT_EQUAL(log.Replay(again), 3u);
+        AssertSameResults(again, replayed, QUERIES);
+    }
+
+    // A record cut in the middle
+    WriteFile(path, valid.substr(0, valid.size() - 3));
+    {
+        WriteAheadLog log(path);
+        SearchServer replayed("and"s);
+        ASSERT_EQUAL(log.Replay(replayed), 1u);
+        ASSERT_EQUAL(replayed.FindTopDocuments("dog"s).size(), 0u);
+        ASSERT(ReadFile(path).size() < valid.size() - 3);
+    }
+    std::remove(path.c_str());
+}
+
+// Replay stops at the first record whose checksum does not match
+void TestStopsAtCorruptedRecord(){
+    const std::string path = MakeTempPath("corrupted.wal");
+    {
+        SearchServer search_server(""s);
+        WriteAheadLog log(path);
+        AddDocument(search_server, log, 1, "first record"s);
+        AddDocument(search_server, log, 2, "second record"s);
+        AddDocument(search_server, log, 3, "third record"s);
+    }
+    std::string contents = ReadFile(path);
+    const std::size_t second = contents.find("second"s);
+    ASSERT(second != std::string::npos);
+    contents[second] = 'S';
+    WriteFile(path, contents);
+    {
+        WriteAheadLog log(path);
+        SearchServer replayed(""s);
+        ASSERT_EQUAL(log.Replay(replayed), 1u);
+        ASSERT_EQUAL(replayed.FindTopDocuments("record"s).size(), 1u);
+        ASSERT(ReadFile(path).size() < second);
+    }
+
+    WriteFile(path, "not a log"s);
+    ASSERT_THROWS(WriteAheadLog{path}, std::invalid_argument);
+    std::remove(path.c_str());
+}
+
+void TestCheckpointRecovery(){
+    const std::string checkpoint_path = MakeTempPath("recovery.checkpoint");
+    const std::string log_path = MakeTempPath("recovery.wal");
+    SearchServer expected("and"s);
+    {
+        DurableSearchServer durable(checkpoint_path, log_path, SearchServer("and"s), {2});
+        ASSERT_EQUAL(durable.GetReplayedCount(), 0u);
+        for (int id = 0; id < 10; ++id){
+            const std::string text = "cat number"s + std::to_string(id);
+            durable.AddDocument(id, text, DocumentStatus::ACTUAL, {id});
+            expected.AddDocument(id, text, DocumentStatus::ACTUAL, {id});
+        }
+        ASSERT_THROWS(durable.AddDocument(3, "dog"s, DocumentStatus::ACTUAL, {}), std::invalid_argument);
+        durable.Checkpoint();
+        ASSERT_EQUAL(std::filesystem::file_size(log_path), LOG_MAGIC_SIZE);
+        ASSERT(!std::filesystem::exists(checkpoint_path + ".tmp"s));
+        durable.RemoveDocument(4);
+        expected.RemoveDocument(4);
+        durable.AddDocument(20, "dog with collar"s, DocumentStatus::ACTUAL, {5});
+        expected.AddDocument(20, "dog with collar"s, DocumentStatus::ACTUAL, {5});
+    }
+    {
+        DurableSearchServer durable(checkpoint_path, log_path, SearchServer("and"s));
+        ASSERT_EQUAL(durable.GetReplayedCount(), 2u);
+        AssertSameResults(durable.GetSearchServer(), expected, QUERIES);
+    }
+
+    // A crash between the checkpoint rename and the log truncation leaves
+    // records the checkpoint already covers, they are skipped on replay
+    const std::string log_before_checkpoint = ReadFile(log_path);
+    {
+        DurableSearchServer durable(checkpoint_path, log_path, SearchServer("and"s));
+        durable.Checkpoint();
+    }
+    WriteFile(log_path, log_before_checkpoint);
+    {
+        DurableSearchServer durable(checkpoint_path, log_path, SearchServer("and"s));
+        ASSERT_EQUAL(durable.GetReplayedCount(), 0u);
+        AssertSameResults(durable.GetSearchServer(), expected, QUERIES);
+    }
+    std::remove(checkpoint_path.c_str());
+    std::remove(log_path.c_str());
+}
+
+} // namespace
+
+void TestWriteAheadLog(){
+    RUN_TEST(TestReplaysLoggedOperations);
+    RUN_TEST(TestCutsTornTail);
+    RUN_TEST(TestStopsAtCorruptedRecord);
+    RUN_TEST(TestCheckpointRecovery);
+}
@@ -0,0 +1,61 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include "tool_common.h"
+
+using namespace std::string_literals;
+
+OutputFormat ParseOutputFormat(const std::string &value){
+    if (value == "json"){
+        return OutputFormat::JSON;
+    }
+    if (value == "csv"){
+        return OutputFormat::CSV;
+    }
+    throw std::invalid_argument("Unknown format "s + value);
+}
+
+void PrintMetrics(const Metrics &metrics, OutputFormat format){
+    std::cout.precision(10);
+    if (format == OutputFormat::CSV){
+        std::cout << "metric,value\n";
+        for (const auto &[name, value] : metrics){
+            std::cout << name << ',' << value << '\n';
+        }
+        return;
+    }
+    std::cout << "{\n";
+    for (std::size_t i = 0; i < metrics.size(); ++i){
+        std::cout << "  \"" << metrics[i].first << "\": " << metrics[i].second
+                  << (i + 1 < metrics.size() ? ",\n" : "\n");
+    }
+    std::cout << "}\n";
+}
+
+double Percentile(const std::vector<double> &sorted, double percent){
+    if (sorted.empty()){
+        return 0;
+    }
+    const auto rank = static_cast<std::size_t>(std::ceil(percent / 100 * sorted.size()));
+    return sorted[std::clamp<std::size_t>(rank, 1, sorted.size()) - 1];
+}
+
+void AddLatencyMetrics(Metrics &metrics, const std::string &prefix, std::vector<double> latencies){
+    std::sort(latencies.begin(), latencies.end());
+    const double total = std::accumulate(latencies.begin(), latencies.end(), 0.0);
+    metrics.emplace_back(prefix + ".p50_ns", Percentile(latencies, 50));
+    metrics.emplace_back(prefix + ".p95_ns", Percentile(latencies, 95));
+    metrics.emplace_back(prefix + ".p99_ns", Percentile(latencies, 99));
+    metrics.emplace_back(prefix + ".max_ns", latencies.empty() ? 0 : latencies.back());
+    metrics.emplace_back(prefix + ".mean_ns", latencies.empty() ? 0 : total / latencies.size());
+}
+
+void AddHistogramMetrics(Metrics &metrics, const std::string &prefix, const HistogramSnapshot &histogram){
+    metrics.emplace_back(prefix + ".p50_ns", histogram.GetPercentile(50));
+    metrics.emplace_back(prefix + ".p95_ns", histogram.GetPercentile(95));
+    metrics.emplace_back(prefix + ".p99_ns", histogram.GetPercentile(99));
+    metrics.emplace_back(prefix + ".p999_ns", histogram.GetPercentile(99.9));
+    metrics.emplace_back(prefix + ".max_ns", histogram.max);
+    metrics.emplace_back(prefix + ".mean_ns", histogram.GetMean());
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "metrics.h"
+
+// Command line and report plumbing shared by the benchmark and the replay tool
+
+enum class OutputFormat{
+    JSON,
+    CSV,
+};
+
+using Metrics = std::vector<std::pair<std::string, double>>;
+
+// Calls handle_option(key, value) for every key=value argument; it returns
+// false for a key it does not know. Throws std::invalid_argument for an
+// argument without '=' or an unknown key.
+template <typename OptionHandler>
+void ParseKeyValueOptions(int argc, char **argv, OptionHandler handle_option){
+    using namespace std::string_literals;
+    for (int i = 1; i < argc; ++i){
+        const std::string argument = argv[i];
+        const std::size_t equals = argument.find('=');
+        if (equals == std::string::npos){
+            throw std::invalid_argument("Expected key=value, got "s + argument);
+        }
+        const std::string key = argument.substr(0, equals);
+        if (!handle_option(key, argument.substr(equals + 1))){
+            throw std::invalid_argument("Unknown option "s + key);
+        }
+    }
+}
+
+// json or csv, throws std::invalid_argument for anything else
+OutputFormat ParseOutputFormat(const std::string &value);
+
+// One flat object as JSON, or metric,value CSV lines
+void PrintMetrics(const Metrics &metrics, OutputFormat format);
+
+// Nearest-rank percentile of sorted values
+double Percentile(const std::vector<double> &sorted, double percent);
+
+// p50, p95, p99, max and mean of exact latencies in nanoseconds
+void AddLatencyMetrics(Metrics &metrics, const std::string &prefix, std::vector<double> latencies);
+// The same from a histogram, with p99.9 added
+void AddHistogramMetrics(Metrics &metrics, const std::string &prefix, const HistogramSnapshot &histogram);
@@ -0,0 +1,83 @@
+#include <algorithm>
+#include <iomanip>
+#include "tracing.h"
+
+namespace {
+
+void WriteJsonString(std::ostream &output, const char *text){
+    output << '"';
+    for (; *text != '\0'; ++text){
+        if (*text == '"' || *text == '\\'){
+            output << '\\';
+        }
+        output << *text;
+    }
+    output << '"';
+}
+
+} // namespace
+
+Tracer &Tracer::Instance(){
+    // Never destroyed, like the metrics registry
+    static Tracer *tracer = new Tracer();
+    return *tracer;
+}
+
+void Tracer::Record(const Span &span){
+    ThreadBuffer &buffer = GetThreadBuffer();
+    const std::lock_guard guard(buffer.mutex);
+    if (buffer.spans.size() < SPANS_PER_THREAD){
+        buffer.spans.push_back(span);
+    }else{
+        buffer.spans[buffer.written % SPANS_PER_THREAD] = span;
+    }
+    ++buffer.written;
+}
+
+void Tracer::Clear(){
+    const std::lock_guard guard(mutex_);
+    for (const auto &buffer : buffers_){
+        const std::lock_guard buffer_guard(buffer->mutex);
+        buffer->spans.clear();
+        buffer->written = 0;
+    }
+}
+
+void Tracer::WriteChromeTrace(std::ostream &output) const{
+    const std::lock_guard guard(mutex_);
+    const auto old_flags = output.flags();
+    output << std::fixed << std::setprecision(3);
+    output << "{\"traceEvents\":[";
+    bool is_first = true;
+    for (const auto &buffer : buffers_){
+        const std::lock_guard buffer_guard(buffer->mutex);
+        for (const Span &span : buffer->spans){
+            output << (is_first ? "\n" : ",\n");
+            is_first = false;
+            output << "{\"name\":";
+            WriteJsonString(output, span.name);
+            // Complete events with microsecond timestamps
+            output << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_id
+                   << ",\"ts\":" << span.start_ns / 1000.0 << ",\"dur\":" << span.duration_ns / 1000.0;
+            if (span.argument_name != nullptr){
+                output << ",\"args\":{";
+                WriteJsonString(output, span.argument_name);
+                output << ':' << span.argument << '}';
+            }
+            output << '}';
+        }
+    }
+    output << "\n],\"displayTimeUnit\":\"ns\"}\n";
+    output.flags(old_flags);
+}
+
+Tracer::ThreadBuffer &Tracer::GetThreadBuffer(){
+    thread_local std::shared_ptr<ThreadBuffer> buffer = [this]{
+        auto new_buffer = std::make_shared<ThreadBuffer>();
+        const std::lock_guard guard(mutex_);
+        new_buffer->thread_id = static_cast<int>(buffers_.size()) + 1;
+        buffers_.push_back(new_buffer);
+        return new_buffer;
+    }();
+    return *buffer;
+}
@@ -0,0 +1,119 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+#include "metrics.h"
+
+// Opt-in tracing of query stages. While enabled, every TraceSpan is
+// stored in a ring buffer of its thread, which keeps the latest
+// SPANS_PER_THREAD spans; WriteChromeTrace exports them as Chrome
+// trace-event JSON for chrome://tracing or Perfetto. When disabled a span
+// costs one relaxed load.
+class Tracer{
+public:
+    static constexpr std::size_t SPANS_PER_THREAD = std::size_t{1} << 15;
+
+    struct Span{
+        // Names are string literals
+        const char *name;
+        const char *argument_name;
+        std::int64_t argument;
+        std::int64_t start_ns;
+        std::int64_t duration_ns;
+    };
+
+    static Tracer &Instance();
+
+    void SetEnabled(bool is_enabled){is_enabled_.store(is_enabled, std::memory_order_relaxed);}
+    bool IsEnabled() const{return is_enabled_.load(std::memory_order_relaxed);}
+
+    void Record(const Span &span);
+    // Drops the recorded spans of all threads
+    void Clear();
+    void WriteChromeTrace(std::ostream &output) const;
+
+    // Nanoseconds since the tracer was created
+    std::int64_t Now() const{
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch_).count();
+    }
+
+    Tracer(const Tracer&) = delete;
+    Tracer &operator=(const Tracer&) = delete;
+
+private:
+    struct ThreadBuffer{
+        int thread_id = 0;
+        // Taken by the owning thread per span and by exports, so it is uncontended
+        std::mutex mutex;
+        std::vector<Span> spans;
+        // Spans ever written, the next one goes to written % SPANS_PER_THREAD
+        std::uint64_t written = 0;
+    };
+
+    std::atomic<bool> is_enabled_{false};
+    const std::chrono::steady_clock::time_point epoch_ = std::chrono::steady_clock::now();
+    mutable std::mutex mutex_;
+    // Kept after their threads end, so their spans can still be exported
+    std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+
+    Tracer() = default;
+
+    ThreadBuffer &GetThreadBuffer();
+};
+
+// Span from construction to destruction or to Finish
+class TraceSpan{
+public:
+    explicit TraceSpan(const char *name, const char *argument_name = nullptr, std::int64_t argument = 0)
+        : name_(Tracer::Instance().IsEnabled() ? name : nullptr),
+        argument_name_(argument_name),
+        argument_(argument),
+        start_ns_(name_ != nullptr ? Tracer::Instance().Now() : 0){
+    }
+
+    ~TraceSpan(){
+        Finish();
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan &operator=(const TraceSpan&) = delete;
+
+    void Finish(){
+        if (name_ != nullptr){
+            Tracer &tracer = Tracer::Instance();
+            tracer.Record({name_, argument_name_, argument_, start_ns_, tracer.Now() - start_ns_});
+            name_ = nullptr;
+        }
+    }
+
+private:
+    const char *name_;
+    const char *argument_name_;
+    std::int64_t argument_;
+    std::int64_t start_ns_;
+};
+
+// Times a query stage into its histogram, into elapsed_ns if given and,
+// while tracing, into a span
+class StageTimer{
+public:
+    StageTimer(HistogramId histogram, const char *name, std::uint64_t *elapsed_ns = nullptr)
+        : latency_(histogram, elapsed_ns),
+        span_(name){
+    }
+
+    void Finish(){
+        span_.Finish();
+        latency_.Finish();
+    }
+
+private:
+    ScopedLatency latency_;
+    TraceSpan span_;
+};
@@ -0,0 +1,325 @@
+#include <cstring>
+#include <execution>
+#include <filesystem>
+#include <stdexcept>
+#include <utility>
+#include "hashing.h"
+#include "mapped_file.h"
+#include "write_ahead_log.h"
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <unistd.h>
+#define SEARCH_SERVER_HAS_FSYNC 1
+#endif
+
+using namespace std::string_literals;
+
+namespace {
+
+constexpr char LOG_MAGIC[8] = {'S', 'R', 'C', 'H', 'W', 'A', 'L', '1'};
+
+enum class RecordType : std::uint8_t{
+    ADD_DOCUMENT = 1,
+    REMOVE_DOCUMENT = 2,
+};
+
+// Precedes every record payload
+struct RecordHeader{
+    std::uint32_t payload_size;
+    std::uint32_t checksum;
+};
+
+// A torn write can not produce a larger record than this
+constexpr std::uint32_t MAX_PAYLOAD_SIZE = 1u << 30;
+
+template <typename T>
+void AppendValue(std::string &output, const T &value){
+    output.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// Reads the fields of a payload, failing on a payload that ends too early
+class PayloadReader{
+public:
+    explicit PayloadReader(std::string_view payload)
+        : payload_(payload){
+    }
+
+    template <typename T>
+    bool Read(T &value){
+        if (payload_.size() < sizeof(T)){
+            return false;
+        }
+        std::memcpy(&value, payload_.data(), sizeof(T));
+        payload_.remove_prefix(sizeof(T));
+        return true;
+    }
+
+    bool Read(std::string_view &text, std::size_t size){
+        if (payload_.size() < size){
+            return false;
+        }
+        text = payload_.substr(0, size);
+        payload_.remove_prefix(size);
+        return true;
+    }
+
+    bool AtEnd() const{return payload_.empty();}
+
+private:
+    std::string_view payload_;
+};
+
+struct Record{
+    std::uint64_t sequence = 0;
+    RecordType type = RecordType::ADD_DOCUMENT;
+    DocumentInput document{};
+};
+
+bool ParseRecord(std::string_view payload, Record &record){
+    PayloadReader reader(payload);
+    std::uint8_t type = 0;
+    std::int32_t document_id = 0;
+    if (!reader.Read(record.sequence) || !reader.Read(type) || !reader.Read(document_id)){
+        return false;
+    }
+    record.type = static_cast<RecordType>(type);
+    record.document.document_id = document_id;
+    if (record.type == RecordType::REMOVE_DOCUMENT){
+        return reader.AtEnd();
+    }
+    if (record.type != RecordType::ADD_DOCUMENT){
+        return false;
+    }
+    std::int32_t status = 0;
+    std::uint32_t rating_count = 0;
+    if (!reader.Read(status) || !reader.Read(rating_count) || rating_count > payload.size()){
+        return false;
+    }
+    record.document.status = static_cast<DocumentStatus>(status);
+    record.document.ratings.resize(rating_count);
+    for (int &rating : record.document.ratings){
+        std::int32_t value = 0;
+        if (!reader.Read(value)){
+            return false;
+        }
+        rating = value;
+    }
+    std::uint32_t text_size = 0;
+    return reader.Read(text_size) && reader.Read(record.document.text, text_size) && reader.AtEnd();
+}
+
+} // namespace
+
+WriteAheadLog::WriteAheadLog(const std::string &path, WriteAheadLogOptions options)
+    : path_(path),
+    options_(options){
+    if (options_.sync_batch_size == 0){
+        throw std::invalid_argument("Sync batch size must be positive"s);
+    }
+    if (std::FILE *existing = std::fopen(path_.c_str(), "rb")){
+        char magic[sizeof(LOG_MAGIC)];
+        const std::size_t read = std::fread(magic, 1, sizeof(magic), existing);
+        std::fclose(existing);
+        if (read == sizeof(magic) && std::equal(magic, magic + sizeof(magic), LOG_MAGIC)){
+            Open("ab");
+            return;
+        }
+        if (read != 0){
+            throw std::invalid_argument("Not a write-ahead log: "s + path_);
+        }
+    }
+    Create();
+}
+
+WriteAheadLog::~WriteAheadLog(){
+    try{
+        Sync();
+    }catch (const std::exception&){
+    }
+    if (file_ != nullptr){
+        std::fclose(file_);
+    }
+}
+
+std::size_t WriteAheadLog::Replay(SearchServer &search_server, std::uint64_t after_sequence){
+    Sync();
+    last_sequence_ = std::max(last_sequence_, after_sequence);
+    const MappedFile log(path_);
+    const std::string_view contents = log.GetContents();
+    if (contents.size() < sizeof(LOG_MAGIC) || !std::equal(LOG_MAGIC, LOG_MAGIC + sizeof(LOG_MAGIC), contents.data())){
+        throw std::invalid_argument("Not a write-ahead log: "s + path_);
+    }
+
+    std::size_t applied = 0;
+    // Additions are collected until a removal or the end of the log,
+    // their texts point into the mapping
+    std::vector<DocumentInput> batch;
+    const auto apply_batch = [&search_server, &batch, &applied]{
+        search_server.AddDocuments(std::execution::par, batch);
+        applied += batch.size();
+        batch.clear();
+    };
+
+    std::size_t offset = sizeof(LOG_MAGIC);
+    while (contents.size() - offset >= sizeof(RecordHeader)){
+        RecordHeader header;
+        std::memcpy(&header, contents.data() + offset, sizeof(header));
+        if (header.payload_size > MAX_PAYLOAD_SIZE
+            || header.payload_size > contents.size() - offset - sizeof(RecordHeader)){
+            break;
+        }
+        const std::string_view payload = contents.substr(offset + sizeof(RecordHeader), header.payload_size);
+        Record record;
+        if (ComputeCrc32c(payload) != header.checksum || !ParseRecord(payload, record)){
+            break;
+        }
+        offset += sizeof(RecordHeader) + header.payload_size;
+        if (record.sequence <= after_sequence){
+            continue;
+        }
+        last_sequence_ = std::max(last_sequence_, record.sequence);
+        if (record.type == RecordType::ADD_DOCUMENT){
+            batch.push_back(std::move(record.document));
+        }else{
+            apply_batch();
+            search_server.RemoveDocument(record.document.document_id);
+            ++applied;
+        }
+    }
+    apply_batch();
+
+    if (offset != contents.size()){
+        // Appending after the damaged tail would make the new records unreachable.
+        // Only the tail is cut, the mapping is not read past this point.
+        Resize(offset);
+    }
+    return applied;
+}
+
+void WriteAheadLog::LogAddDocument(int document_id, std::string_view document, DocumentStatus status,
+                                   const std::vector<int> &ratings){
+    std::string payload;
+    payload.reserve(32 + ratings.size() * sizeof(std::int32_t) + document.size());
+    AppendValue(payload, ++last_sequence_);
+    AppendValue(payload, RecordType::ADD_DOCUMENT);
+    AppendValue(payload, static_cast<std::int32_t>(document_id));
+    AppendValue(payload, static_cast<std::int32_t>(status));
+    AppendValue(payload, static_cast<std::uint32_t>(ratings.size()));
+    for (int rating : ratings){
+        AppendValue(payload, static_cast<std::int32_t>(rating));
+    }
+    AppendValue(payload, static_cast<std::uint32_t>(document.size()));
+    payload += document;
+    Append(std::move(payload));
+}
+
+void WriteAheadLog::LogRemoveDocument(int document_id){
+    std::string payload;
+    AppendValue(payload, ++last_sequence_);
+    AppendValue(payload, RecordType::REMOVE_DOCUMENT);
+    AppendValue(payload, static_cast<std::int32_t>(document_id));
+    Append(std::move(payload));
+}
+
+void WriteAheadLog::Sync(){
+    if (buffered_records_ == 0){
+        return;
+    }
+    if (std::fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size() || std::fflush(file_) != 0){
+        throw std::runtime_error("Cannot write "s + path_);
+    }
+#ifdef SEARCH_SERVER_HAS_FSYNC
+    if (fsync(fileno(file_)) != 0){
+        throw std::runtime_error("Cannot sync "s + path_);
+    }
+#endif
+    buffer_.clear();
+    buffered_records_ = 0;
+}
+
+void WriteAheadLog::Truncate(){
+    buffer_.clear();
+    buffered_records_ = 0;
+    Resize(sizeof(LOG_MAGIC));
+}
+
+void WriteAheadLog::Open(const char *mode){
+    if (file_ != nullptr){
+        std::fclose(file_);
+    }
+    file_ = std::fopen(path_.c_str(), mode);
+    if (file_ == nullptr){
+        throw std::runtime_error("Cannot open "s + path_);
+    }
+}
+
+void WriteAheadLog::Create(){
+    Open("wb");
+    if (std::fwrite(LOG_MAGIC, 1, sizeof(LOG_MAGIC), file_) != sizeof(LOG_MAGIC) || std::fflush(file_) != 0){
+        throw std::runtime_error("Cannot write "s + path_);
+    }
+#ifdef SEARCH_SERVER_HAS_FSYNC
+    if (fsync(fileno(file_)) != 0){
+        throw std::runtime_error("Cannot sync "s + path_);
+    }
+#endif
+    Open("ab");
+    SyncParentDirectory(path_);
+}
+
+void WriteAheadLog::Resize(std::uint64_t size){
+    if (std::fflush(file_) != 0){
+        throw std::runtime_error("Cannot write "s + path_);
+    }
+#ifdef SEARCH_SERVER_HAS_FSYNC
+    // Appends go to the new end, the file is open with O_APPEND
+    if (ftruncate(fileno(file_), static_cast<off_t>(size)) != 0){
+        throw std::runtime_error("Cannot truncate "s + path_);
+    }
+    if (fsync(fileno(file_)) != 0){
+        throw std::runtime_error("Cannot sync "s + path_);
+    }
+#else
+    std::fclose(file_);
+    file_ = nullptr;
+    std::error_code error;
+    std::filesystem::resize_file(path_, size, error);
+    if (error){
+        throw std::runtime_error("Cannot truncate "s + path_);
+    }
+    Open("ab");
+#endif
+}
+
+void WriteAheadLog::Append(std::string &&payload){
+    AppendValue(buffer_, RecordHeader{static_cast<std::uint32_t>(payload.size()), ComputeCrc32c(payload)});
+    buffer_ += payload;
+    if (++buffered_records_ >= options_.sync_batch_size){
+        Sync();
+    }
+}
+
+void SyncFile(const std::string &path){
+#ifdef SEARCH_SERVER_HAS_FSYNC
+    const int descriptor = open(path.c_str(), O_RDONLY);
+    if (descriptor < 0){
+        throw std::runtime_error("Cannot open "s + path);
+    }
+    const int result = fsync(descriptor);
+    close(descriptor);
+    if (result != 0){
+        throw std::runtime_error("Cannot sync "s + path);
+    }
+#else
+    (void)path;
+#endif
+}
+
+void SyncParentDirectory(const std::string &path){
+#ifdef SEARCH_SERVER_HAS_FSYNC
+    const std::filesystem::path directory = std::filesystem::path(path).parent_path();
+    SyncFile(directory.empty() ? "."s : directory.string());
+#else
+    (void)path;
+#endif
+}
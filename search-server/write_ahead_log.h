@@ -0,0 +1,66 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "search_server.h"
+
+struct WriteAheadLogOptions{
+    // Records written between two fsync calls, 1 makes every logged operation durable on return
+    std::size_t sync_batch_size = 64;
+};
+
+// Append-only log of AddDocument and RemoveDocument operations.
+// Every record carries a sequence number and a CRC-32C of its contents;
+// records are buffered and written with one fsync per batch.
+class WriteAheadLog{
+public:
+    // Opens or creates the log. Throws std::runtime_error on I/O errors
+    // and std::invalid_argument if the file is not a log.
+    explicit WriteAheadLog(const std::string &path, WriteAheadLogOptions options = {});
+    // Syncs the buffered records, errors are ignored
+    ~WriteAheadLog();
+
+    WriteAheadLog(const WriteAheadLog&) = delete;
+    WriteAheadLog &operator=(const WriteAheadLog&) = delete;
+
+    // Applies the records with sequence numbers above after_sequence, consecutive
+    // additions through the AddDocuments batch path. A torn or corrupted tail
+    // left by a crash is cut off. Must be called before anything is logged.
+    // Returns the number of applied records.
+    std::size_t Replay(SearchServer &search_server, std::uint64_t after_sequence = 0);
+
+    // Log operations that were already applied, so that replay never fails
+    void LogAddDocument(int document_id, std::string_view document, DocumentStatus status,
+                        const std::vector<int> &ratings);
+    void LogRemoveDocument(int document_id);
+
+    // Writes and fsyncs the buffered records
+    void Sync();
+    // Drops all records once a durable checkpoint covers them, sequence numbers keep growing
+    void Truncate();
+
+    std::uint64_t GetLastSequence() const{return last_sequence_;}
+
+private:
+    std::string path_;
+    WriteAheadLogOptions options_;
+    std::FILE *file_ = nullptr;
+    std::string buffer_;
+    std::size_t buffered_records_ = 0;
+    std::uint64_t last_sequence_ = 0;
+
+    void Open(const char *mode);
+    // Starts a new log that holds only the magic
+    void Create();
+    // Cuts the file to size bytes in place and syncs it
+    void Resize(std::uint64_t size);
+    void Append(std::string &&payload);
+};
+
+// Flushes a closed file to stable storage, does nothing where fsync is unavailable
+void SyncFile(const std::string &path);
+// Flushes the directory holding path, making a file created or renamed there durable
+void SyncParentDirectory(const std::string &path);